@@ -23,6 +23,7 @@
 #include "SearchTMDBInfo.h"
 #include "TransformResult.h"
 #include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/PreferencesSnapshot.h"
 #include "SearchTMDB.h"
 
 #include <QString>
@@ -71,7 +72,7 @@ namespace NMediaManager
         QString SSearchTMDBInfo::replaceKnownAbbreviations( const QString &string )
         {
             QString retVal = string;
-            auto knownAbbreviations = NPreferences::NCore::CPreferences::instance()->getKnownAbbreviations();
+            auto knownAbbreviations = NPreferences::NCore::CPreferences::instance()->snapshot()->fKnownAbbreviations;
             for ( auto &&ii = knownAbbreviations.begin(); ii != knownAbbreviations.end(); ++ii )
             {
                 auto regExpStr = "(\\W|^)(?<word>" + QRegularExpression::escape( ii.key() ) + ")(\\W|$)";
@@ -88,7 +89,7 @@ namespace NMediaManager
         QString SSearchTMDBInfo::stripKnownData( const QString &string )
         {
             QString retVal = string;
-            auto regExs = NPreferences::NCore::CPreferences::instance()->getKnownStringRegExs();
+            auto regExs = NPreferences::NCore::CPreferences::instance()->snapshot()->fKnownStringRegExs;
             for ( auto &&ii : regExs )
             {
                 auto regEx = QRegularExpression( ii, QRegularExpression::CaseInsensitiveOption );
@@ -127,7 +128,7 @@ namespace NMediaManager
         QString SSearchTMDBInfo::stripKnownExtendedData( const QString &string, QString &extendedData )
         {
             QString retVal = string;
-            auto knownStrings = NPreferences::NCore::CPreferences::instance()->getKnownExtendedStrings();
+            auto knownStrings = NPreferences::NCore::CPreferences::instance()->snapshot()->fKnownExtendedStrings;
             for ( auto &&knownString : knownStrings )
             {
                 knownString = QRegularExpression::escape( knownString );
@@ -181,7 +182,7 @@ namespace NMediaManager
 
                 if ( checkForKnownHyphens )
                 {
-                    auto knownHyphens = NPreferences::NCore::CPreferences::instance()->getKnownHyphenatedData();
+                    auto knownHyphens = NPreferences::NCore::CPreferences::instance()->snapshot()->fKnownHyphenatedData;
                     int from = 0;
                     auto pos = retVal.indexOf( '-' );
                     while ( pos != -1 )
@@ -21,9 +21,17 @@
 // SOFTWARE.
 
 #include "DirModel.h"
+#include "DirScanIndex.h"
+#include "SidecarIndex.h"
+#include "ProcessJournal.h"
 #include "Core/TransformResult.h"
 #include "Core/SearchTMDBInfo.h"
 #include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/PathMatcher.h"
+#include "Preferences/Core/PreferencesSnapshot.h"
+#include "Preferences/Core/MediaInfoCache.h"
+#include "Preferences/Core/MediaProbePool.h"
+#include "Preferences/Core/MKVProbe.h"
 
 #include "UI/ProcessConfirm.h"
 #include "UI/BasePage.h"
@@ -50,17 +58,31 @@
 #include <QFileIconProvider>
 #include <QTimer>
 #include <QTreeView>
+#include <QScrollBar>
 #include <QApplication>
 #include <QBrush>
 #include <QDirIterator>
 #include <QPlainTextEdit>
 #include <QMessageBox>
 #include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QCryptographicHash>
+#include <QStorageInfo>
+#include <QTemporaryDir>
 
 #include <QProcess>
 
 #include <set>
 #include <list>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#ifdef Q_OS_LINUX
+    #include <unistd.h>
+#endif
 
 QDebug operator<<( QDebug dbg, const NMediaManager::NModels::STreeNode &node )
 {
@@ -169,13 +191,23 @@ namespace NMediaManager
             fReloadTimer->setSingleShot( true );
             connect( fReloadTimer, &QTimer::timeout, this, &CDirModel::slotLoadRootDirectory );
 
-            fProcess = new QProcess( this );
-            connect( fProcess, &QProcess::errorOccurred, this, &CDirModel::slotProcessErrorOccured );
-            connect( fProcess, qOverload< int, QProcess::ExitStatus >( &QProcess::finished ), this, &CDirModel::slotProcessFinished );
-            connect( fProcess, &QProcess::readyReadStandardError, this, &CDirModel::slotProcessStandardError );
-            connect( fProcess, &QProcess::readyReadStandardOutput, this, &CDirModel::slotProcessStandardOutput );
-            connect( fProcess, &QProcess::started, this, &CDirModel::slotProcessStarted );
-            connect( fProcess, &QProcess::stateChanged, this, &CDirModel::slotProcesssStateChanged );
+            fFileSystemWatcher = new QFileSystemWatcher( this );
+            connect( fFileSystemWatcher, &QFileSystemWatcher::directoryChanged, this, &CDirModel::slotDirectoryChanged );
+            connect( fFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &CDirModel::slotFileChanged );
+
+            fLiveUpdateTimer = new QTimer( this );
+            fLiveUpdateTimer->setInterval( 250 );
+            fLiveUpdateTimer->setSingleShot( true );
+            connect( fLiveUpdateTimer, &QTimer::timeout, this, &CDirModel::slotApplyLiveUpdates );
+
+            fViewportTimer = new QTimer( this );
+            fViewportTimer->setInterval( 100 );
+            fViewportTimer->setSingleShot( true );
+            connect( fViewportTimer, &QTimer::timeout, this, &CDirModel::slotUpdateViewportPriority );
+
+            fLogFlushTimer = new QTimer( this );
+            fLogFlushTimer->setInterval( 250 );
+            connect( fLogFlushTimer, &QTimer::timeout, this, &CDirModel::slotFlushProcessLogs );
 
             connect( this, &QStandardItemModel::dataChanged, this, &CDirModel::slotDataChanged );
 
@@ -184,6 +216,7 @@ namespace NMediaManager
 
         CDirModel::~CDirModel()
         {
+            stopDirScan();
             delete fIconProvider;
         }
 
@@ -215,6 +248,7 @@ namespace NMediaManager
         {
             NSABUtils::CAutoWaitCursor awc;
 
+            stopDirScan();
             preLoad();
 
             //qDebug() << fRootPath;
@@ -222,28 +256,58 @@ namespace NMediaManager
 
             if ( progressDlg() )
             {
-                progressDlg()->setLabelText( tr( "Computing number of Files under '%1'" ).arg( fRootPath.absolutePath() ) );
-                qApp->processEvents();
-                auto numFiles = computeNumberOfFiles( rootFI ).second;
-                if ( !progressCanceled() )
-                {
-                    progressDlg()->setValue( 0 );
-                    progressDlg()->setRange( 0, numFiles );
-                }
+                progressDlg()->setValue( 0 );
+                progressDlg()->setRange( 0, fLoadOnDemand ? 0 : 1 );   // the scan raises the maximum from the scanner's running total as batches arrive
             }
-            if ( progressCanceled() )
+            if ( progressCanceled() || !rootFI.exists() )
             {
-                postLoad( false );
+                postLoad( !progressCanceled() );
                 return;
             }
 
-            loadFileInfo( rootFI );
+            if ( fLoadOnDemand )
+            {
+                fetchDirectory( rootFI.absoluteFilePath() );
+                postLoad( true );
+                return;
+            }
 
-            postLoad( true );
+            startDirScan( rootFI );
         }
 
         void CDirModel::preLoad()
         {
+            fLiveUpdateTimer->stop();
+            fPendingLiveUpdates.clear();
+            fFirstPendingLiveUpdate.invalidate();
+            fScannedPaths.clear();
+            auto watchedDirs = fFileSystemWatcher->directories();
+            if ( !watchedDirs.isEmpty() )
+                fFileSystemWatcher->removePaths( watchedDirs );
+            unwatchFiles();
+            fLiveUpdatesAvailable = true;
+            fWatchFiles = true;
+            fUnfetchedDirs.clear();
+            fLoadOnDemand = NPreferences::NCore::CPreferences::instance()->getLoadDirectoriesOnDemand();
+            fMediaTagsEditable.reset();
+
+            NPreferences::NCore::CMediaProbePool::instance()->cancelAll();   // requests from the previous root are no longer wanted
+            NPreferences::NCore::CMediaProbePool::instance()->setStorageHint( fRootPath.absolutePath() );
+            auto view = filesView();
+            if ( view && ( view != fViewportView ) )
+            {
+                fViewportView = view;
+                auto startViewportTimer = [ this ]()
+                {
+                    if ( !fViewportTimer->isActive() )
+                        fViewportTimer->start();
+                };
+                connect( view->verticalScrollBar(), &QScrollBar::valueChanged, this, startViewportTimer );
+                connect( view, &QTreeView::expanded, this, startViewportTimer );
+                connect( view, &QTreeView::collapsed, this, startViewportTimer );
+                connect( this, &QStandardItemModel::rowsInserted, this, startViewportTimer );
+            }
+
             setIsLoading( true );
             clear();
             setHorizontalHeaderLabels( headers() );
@@ -337,191 +401,477 @@ namespace NMediaManager
             return QStandardItemModel::setData( idx, value, role );
         }
 
-        std::unique_ptr< QDirIterator > CDirModel::getDirIteratorForPath( const QFileInfo &fileInfo ) const
+        void CDirModel::startDirScan( const QFileInfo &rootInfo )
+        {
+            fDirScanAlreadyAdded.clear();
+            auto generation = ++fDirScanGeneration;
+            auto batchReady = [ this, generation ]( std::shared_ptr< TDirScanBatch > batch, int filesFound, bool finished ) { QMetaObject::invokeMethod( this, [ this, generation, batch, filesFound, finished ]() { slotDirScanBatchReady( generation, batch, filesFound, finished ); }, Qt::QueuedConnection ); };
+            auto index = std::make_shared< CDirScanIndex >( rootInfo.absoluteFilePath(), dirModelFilter() + sidecarFilter(), dirScanIndexKey() );
+            fSidecarIndex = std::make_shared< CSidecarIndex >( sidecarFilter() );
+
+            // the scanner threads only ever see the snapshot taken here, never the settings
+            auto prefs = NPreferences::NCore::CPreferences::instance()->snapshot();
+            auto forMediaNaming = ignoreExtrasOnSearch();
+            auto isSkipped = [ prefs, forMediaNaming ]( const QFileInfo &fi ) { return !prefs->ignorePathNamesToSkip( forMediaNaming ) && prefs->skippedPathMatcher( forMediaNaming )->matches( fi.fileName() ); };
+
+            fDirScanner = std::make_unique< CDirScanner >( rootInfo, dirModelFilter(), isSkipped, batchReady, NPreferences::NCore::CPreferences::instance()->getNumDirScanThreads(), index, fSidecarIndex );
+            fDirScanner->start();
+        }
+
+        QByteArray CDirModel::dirScanIndexKey() const
         {
-            auto filter = dirModelFilter();
-            auto tmp = filter;
-            tmp.sort();
-            auto retVal = std::make_unique< QDirIterator >( fileInfo.absoluteFilePath(), filter, QDir::AllDirs | QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable );
-            return std::move( retVal );
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            QStringList values;
+            values << QString::number( ignoreExtrasOnSearch() ) << QString::number( prefs->getIgnorePathNamesToSkip( ignoreExtrasOnSearch() ) ) << QString::number( prefs->getIgnorePathNamesToIgnore() );
+            values << prefs->getSkippedPaths( ignoreExtrasOnSearch() ) << prefs->getIgnoredPaths();
+            return QCryptographicHash::hash( values.join( "\n" ).toUtf8(), QCryptographicHash::Md5 );
         }
 
-        void CDirModel::iterateEveryFile( const QFileInfo &fileInfo, const SIterateInfo &iterInfo, std::optional< QDateTime > &lastUpdateUI, bool countOnly ) const
+        CSidecarIndex *CDirModel::sidecarIndex() const
         {
-            //qDebug() << fileInfo;
-            if ( progressCanceled() )
+            if ( !fSidecarIndex )
+                fSidecarIndex = std::make_shared< CSidecarIndex >( sidecarFilter() );
+            return fSidecarIndex.get();
+        }
+
+        void CDirModel::stopDirScan()
+        {
+            fDirScanGeneration++;
+            fDirScanner.reset();
+            fDirScanTree.clear();
+            fDirScanSkipDepth = 0;
+        }
+
+        void CDirModel::slotDirScanBatchReady( uint64_t generation, std::shared_ptr< TDirScanBatch > batch, int filesFound, bool finished )
+        {
+            if ( generation != fDirScanGeneration )   // from a scan that has since been stopped
                 return;
 
-            if ( fileInfo.isDir() )
+            if ( progressCanceled() )
             {
-                bool iteraterDir = true;
-                if ( iterInfo.fPreDirFunction )
-                    iteraterDir = iterInfo.fPreDirFunction( fileInfo );
+                stopDirScan();
+                postLoad( false );
+                return;
+            }
 
-                if ( iteraterDir )
-                {
-                    auto ii = getDirIteratorForPath( fileInfo );
-                    if ( !ii )
-                    {
-                        if ( iterInfo.fPostDirFunction )
-                            iterInfo.fPostDirFunction( fileInfo, countOnly );
-                        return;
-                    }
+            if ( isLoading() && progressDlg() && ( filesFound > progressDlg()->primaryMax() ) )
+                progressDlg()->setPrimaryMaximum( filesFound );
 
-                    while ( ii->hasNext() )
-                    {
-                        ii->next();
-                        auto fi = ii->fileInfo();
-                        iterateEveryFile( fi, iterInfo, lastUpdateUI, countOnly );
-                        if ( progressDlg() && ( !lastUpdateUI.has_value() || ( lastUpdateUI.value().msecsTo( QDateTime::currentDateTime() ) > 250 ) ) )
-                        {
-                            qApp->processEvents();
-                            lastUpdateUI = QDateTime::currentDateTime();
-                        }
-                    }
-                    qApp->processEvents();
+            for ( auto &&ii : *batch )
+            {
+                switch ( ii.fType )
+                {
+                    case SDirScanEntry::EType::eDirStart:
+                        loadDirStart( ii );
+                        break;
+                    case SDirScanEntry::EType::eDirEnd:
+                        loadDirEnd( ii );
+                        break;
+                    case SDirScanEntry::EType::eFile:
+                        loadFile( ii );
+                        break;
                 }
+            }
 
-                if ( iterInfo.fPostDirFunction )
-                    iterInfo.fPostDirFunction( fileInfo, true );
+            if ( finished )
+            {
+                stopDirScan();
+                postLoad( true );
             }
-            else if ( fileInfo.isFile() )
+        }
+
+        void CDirModel::loadDirStart( const SDirScanEntry &entry )
+        {
+            if ( fDirScanSkipDepth || !preDirFunction( entry.fFileInfo, false ) )
+            {
+                fDirScanSkipDepth++;
+                return;
+            }
+
+            fDirScanTree.push_back( std::move( getItemRow( entry ) ) );
+            fScannedPaths.insert( entry.fFileInfo.absoluteFilePath() );
+            if ( !entry.fSkipped )
+                watchDir( entry.fFileInfo.absoluteFilePath() );
+
+            if ( isLoading() && progressDlg() )
             {
-                bool aOK = true;
-                if ( iterInfo.fPreFileFunction )
-                    aOK = iterInfo.fPreFileFunction( fileInfo );
-                if ( iterInfo.fPostFileFunction )
-                    iterInfo.fPostFileFunction( fileInfo, aOK );
+                progressDlg()->setLabelText( tr( "Searching Directory '%1'" ).arg( QDir( fRootPath ).relativeFilePath( entry.fFileInfo.absoluteFilePath() ) ) );
             }
         }
 
-        std::pair< uint64_t, uint64_t > CDirModel::computeNumberOfFiles( const QFileInfo &fileInfo )
+        void CDirModel::loadDirEnd( const SDirScanEntry &entry )
         {
-            uint64_t numDirs = 0;
-            uint64_t numFiles = 0;
-            SIterateInfo info;
-            info.fPreDirFunction = [ this, &numDirs ]( const QFileInfo &dirInfo )
+            if ( fDirScanSkipDepth )
             {
-                if ( isSkippedPathName( dirInfo ) )
-                    return false;
-                numDirs++;
+                fDirScanSkipDepth--;
+                return;
+            }
 
-                if ( progressDlg() )
-                {
-                    progressDlg()->setPrimaryValue( numDirs );
+            postDirFunction( true, entry.fFileInfo, fDirScanTree, false );
+            fDirScanTree.pop_back();
+        }
 
-                    int childDirs = 0;
+        void CDirModel::loadFile( const SDirScanEntry &entry )
+        {
+            // every non-skipped file the scanner counted steps the progress, attached or not, so the value tracks the scanner's total
+            if ( !entry.fSkipped && isLoading() && progressDlg() )
+                progressDlg()->setValue( progressDlg()->value() + 1 );
 
-                    auto iter = QDirIterator(
-                        dirInfo.absoluteFilePath(),
-                        QStringList() << "*"
-                                      << "*.*",
-                        QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Readable );
-                    int currMax = progressDlg()->primaryMax();
-                    while ( iter.hasNext() )
-                    {
-                        progressDlg()->setPrimaryMaximum( ++currMax );
-                        iter.next();
-                    }
-                }
-                return true;
-            };
+            if ( fDirScanSkipDepth )
+                return;
 
-            TParentTree tree;
-            std::unordered_set< QString > alreadyAdded;
-            info.fPreFileFunction = [ this, &tree, &alreadyAdded, &numFiles ]( const QFileInfo &fileInfo )
-            {
-                if ( isSkippedPathName( fileInfo ) )
-                    return false;
+            fDirScanTree.push_back( std::move( getItemRow( entry ) ) );   // mkv file
+            fScannedPaths.insert( entry.fFileInfo.absoluteFilePath() );
+            if ( !entry.fSkipped )
+                watchFile( entry.fFileInfo.absoluteFilePath() );
 
+            bool aOK = !entry.fSkipped;
+            if ( aOK )
+            {
                 // need to be children of file
-                auto attachFile = preFileFunction( fileInfo, alreadyAdded, tree, true );
+                auto attachFile = preFileFunction( entry.fFileInfo, fDirScanAlreadyAdded, fDirScanTree, false );
                 if ( attachFile )
-                    numFiles++;
-                return false;
-            };
-            std::optional< QDateTime > lastUpdate;
-            iterateEveryFile( fileInfo, info, lastUpdate, true );
+                    attachTreeNodes( fDirScanTree );
+            }
+
+            postFileFunction( aOK, entry.fFileInfo, fDirScanTree, false );
+            while ( !fDirScanTree.empty() && fDirScanTree.back().fIsFile )
+                fDirScanTree.pop_back();
+        }
+
+        void CDirModel::watchDir( const QString &dirPath )
+        {
+            if ( !fLiveUpdatesAvailable )
+                return;
 
-            return std::make_pair( numDirs, numFiles );
+            if ( !fFileSystemWatcher->addPath( dirPath ) )   // typically out of inotify watches, fall back to full reloads
+            {
+                fLiveUpdatesAvailable = false;
+                auto watchedDirs = fFileSystemWatcher->directories();
+                if ( !watchedDirs.isEmpty() )
+                    fFileSystemWatcher->removePaths( watchedDirs );
+                unwatchFiles();
+            }
         }
 
-        void CDirModel::loadFileInfo( const QFileInfo &fileInfo )
+        void CDirModel::watchFile( const QString &filePath )
         {
-            if ( !fileInfo.exists() )
+            if ( !fLiveUpdatesAvailable || !fWatchFiles || ( fWatchedFiles.find( filePath ) != fWatchedFiles.end() ) )
                 return;
 
-            TParentTree tree;
+            if ( fFileSystemWatcher->addPath( filePath ) )
+                fWatchedFiles.insert( filePath );
+            else
+            {
+                // give the watches back to the directories, an in place rewrite is then only seen on the next load
+                fWatchFiles = false;
+                unwatchFiles();
+            }
+        }
+
+        void CDirModel::unwatchFiles()
+        {
+            auto watchedFiles = fFileSystemWatcher->files();
+            if ( !watchedFiles.isEmpty() )
+                fFileSystemWatcher->removePaths( watchedFiles );
+            fWatchedFiles.clear();
+        }
+
+        bool CDirModel::reloadNeededAfterProcessing() const
+        {
+            return !fLiveUpdatesAvailable || !usesQueuedProcessing();
+        }
+
+        void CDirModel::slotDirectoryChanged( const QString &dirPath )
+        {
+            queueLiveUpdate( dirPath );
+        }
 
-            SIterateInfo info;
-            info.fPreDirFunction = [ this, &tree ]( const QFileInfo &dirInfo )
+        void CDirModel::slotFileChanged( const QString &filePath )
+        {
+            if ( !QFileInfo::exists( filePath ) )   // the watcher drops removed files, a rename is caught by the directory's watch
             {
-                //qDebug().noquote().nospace() << "Pre Directory A: " << dirInfo.absoluteFilePath() << tree;
+                fWatchedFiles.erase( filePath );
+                fFileSystemWatcher->removePath( filePath );
+            }
 
-                if ( !preDirFunction( dirInfo, false ) )
-                    return false;
+            // the directory update compares the row's modified date, so a rewritten file gets its row rebuilt
+            queueLiveUpdate( QFileInfo( filePath ).absolutePath() );
+        }
+
+        void CDirModel::queueLiveUpdate( const QString &dirPath )
+        {
+            if ( !fLiveUpdatesAvailable )
+                return;
+
+            fPendingLiveUpdates.insert( QFileInfo( dirPath ).absoluteFilePath() );
+
+            // coalesce bursts of changes, but dont let a steady stream of them hold off the update forever
+            if ( !fFirstPendingLiveUpdate.isValid() )
+                fFirstPendingLiveUpdate.start();
+            if ( !fLiveUpdateTimer->isActive() || ( fFirstPendingLiveUpdate.elapsed() < 2000 ) )
+                fLiveUpdateTimer->start();
+        }
+
+        void CDirModel::slotApplyLiveUpdates()
+        {
+            if ( isLoading() || processesRunning() )   // rows are still referenced, try again later
+            {
+                fLiveUpdateTimer->start();
+                return;
+            }
+
+            auto pending = std::move( fPendingLiveUpdates );
+            fPendingLiveUpdates.clear();
+            fFirstPendingLiveUpdate.invalidate();
+
+            for ( auto &&ii : pending )
+                liveUpdateDir( ii );
+        }
+
+        void CDirModel::liveUpdateDir( const QString &dirPath )
+        {
+            sidecarIndex()->invalidate( dirPath );
+
+            QFileInfo dirInfo( dirPath );
+            if ( !dirInfo.exists() )
+            {
+                removePathItem( dirPath );
+                return;
+            }
+
+            if ( fScannedPaths.find( dirPath ) == fScannedPaths.end() )   // never loaded or since removed
+                return;
+
+            if ( fUnfetchedDirs.find( dirPath ) != fUnfetchedDirs.end() )   // contents get read when its expanded
+                return;
 
-                auto row = getItemRow( dirInfo );
-                tree.push_back( std::move( row ) );
+            std::unordered_set< QString > onDisk;
+            auto entries = QDir( dirPath ).entryInfoList( dirModelFilter(), QDir::AllDirs | QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable );
+            for ( auto &&ii : entries )
+                onDisk.insert( ii.absoluteFilePath() );
 
-                if ( progressDlg() )
-                    progressDlg()->setLabelText( tr( "Searching Directory '%1'" ).arg( QDir( fRootPath ).relativeFilePath( dirInfo.absoluteFilePath() ) ) );
+            // removed, or modified since the row was built
+            std::list< QString > toRemove;
+            auto prefix = dirPath + "/";
+            for ( auto ii = fScannedPaths.lower_bound( prefix ); ( ii != fScannedPaths.end() ) && ( *ii ).startsWith( prefix ); ++ii )
+            {
+                QFileInfo fi( *ii );
+                if ( fi.absolutePath() != dirPath )
+                    continue;
 
-                if ( isSkippedPathName( dirInfo ) )
+                if ( onDisk.find( *ii ) == onDisk.end() )
+                    toRemove.push_back( *ii );
+                else if ( fi.isFile() )
                 {
-                    //qDebug().noquote().nospace() << "Pre Directory B: returning false" << dirInfo.absoluteFilePath() << tree;
-                    return false;
+                    auto dateItem = getItem( getItemFromPath( fi ), EColumns::eFSModDate );
+                    if ( dateItem && ( dateItem->text() != fi.lastModified().toString( "MM/dd/yyyy hh:mm:ss.zzz" ) ) )
+                        toRemove.push_back( *ii );
                 }
+            }
 
-                //qDebug().noquote().nospace() << "Pre Directory B: returning true" << dirInfo.absoluteFilePath() << tree;
-                return true;
-            };
+            for ( auto &&ii : toRemove )
+                removePathItem( ii );
+
+            for ( auto &&ii : entries )
+            {
+                if ( fScannedPaths.find( ii.absoluteFilePath() ) == fScannedPaths.end() )
+                    liveAddPath( ii );
+            }
+            clearPathStatusCache( dirPath );
+        }
+
+        void CDirModel::liveAddPath( const QFileInfo &fileInfo )
+        {
+            fDirScanTree = liveUpdateParentTree( fileInfo.absolutePath() );
+            if ( fDirScanTree.empty() )
+                return;
+
+            liveScan( fileInfo );
+            fDirScanTree.clear();
+            fDirScanSkipDepth = 0;
+        }
 
-            std::unordered_set< QString > alreadyAdded;
-            info.fPreFileFunction = [ this, &tree, &alreadyAdded ]( const QFileInfo &fileInfo )
+        void CDirModel::liveScan( const QFileInfo &fileInfo )
+        {
+            SDirScanEntry entry;
+            entry.fFileInfo = fileInfo;
+            entry.fSkipped = isSkippedPathName( fileInfo );
+            if ( fileInfo.isDir() && fLoadOnDemand )
+            {
+                entry.fType = SDirScanEntry::EType::eDirStart;
+                loadDirStart( entry );
+                if ( !entry.fSkipped && !fDirScanSkipDepth )
+                {
+                    // show the directory now, its contents are read in fetchMore
+                    auto dirItem = attachTreeNodes( fDirScanTree );
+                    if ( filesView() && dirItem )
+                        filesView()->setExpanded( dirItem->index(), false );
+                    fUnfetchedDirs.insert( fileInfo.absoluteFilePath() );
+                }
+                entry.fType = SDirScanEntry::EType::eDirEnd;
+                loadDirEnd( entry );
+            }
+            else if ( fileInfo.isDir() )
+            {
+                entry.fType = SDirScanEntry::EType::eDirStart;
+                loadDirStart( entry );
+                if ( !entry.fSkipped )
+                {
+                    auto ii = QDirIterator( fileInfo.absoluteFilePath(), dirModelFilter(), QDir::AllDirs | QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable );
+                    while ( ii.hasNext() )
+                    {
+                        ii.next();
+                        liveScan( ii.fileInfo() );
+                    }
+                }
+                entry.fType = SDirScanEntry::EType::eDirEnd;
+                loadDirEnd( entry );
+            }
+            else if ( fileInfo.isFile() )
             {
-                tree.push_back( std::move( getItemRow( fileInfo ) ) );   // mkv file
+                entry.fType = SDirScanEntry::EType::eFile;
+                loadFile( entry );
+            }
+        }
 
-                if ( isSkippedPathName( fileInfo ) )
-                    return false;
+        void CDirModel::fetchDirectory( const QString &dirPath )
+        {
+            fUnfetchedDirs.erase( dirPath );
 
-                // need to be children of file
-                auto attachFile = preFileFunction( fileInfo, alreadyAdded, tree, false );
+            QFileInfo dirInfo( dirPath );
+            fDirScanTree = liveUpdateParentTree( dirPath );
+            if ( fDirScanTree.empty() )
+                return;
 
-                //qDebug().noquote().nospace() << "Pre File A: " << fileInfo.absoluteFilePath() << tree;
+            fScannedPaths.insert( dirPath );
+            watchDir( dirPath );
 
-                if ( attachFile )
-                    attachTreeNodes( tree );
+            auto ii = QDirIterator( dirPath, dirModelFilter(), QDir::AllDirs | QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable );
+            while ( ii.hasNext() )
+            {
+                ii.next();
+                liveScan( ii.fileInfo() );
+            }
+            postDirFunction( true, dirInfo, fDirScanTree, false );
+
+            fDirScanTree.clear();
+            fDirScanSkipDepth = 0;
+        }
+
+        void CDirModel::fetchAll()
+        {
+            if ( fUnfetchedDirs.empty() )
+                return;
+
+            NSABUtils::CAutoWaitCursor awc;
+            while ( !fUnfetchedDirs.empty() )
+                fetchDirectory( *fUnfetchedDirs.begin() );
+        }
 
-                if ( progressDlg() )
-                    progressDlg()->setValue( progressDlg()->value() + 1 );
+        bool CDirModel::isUnfetched( const QModelIndex &parent ) const
+        {
+            if ( fUnfetchedDirs.empty() || !parent.isValid() )
+                return false;
+            return fUnfetchedDirs.find( filePath( parent ) ) != fUnfetchedDirs.end();
+        }
 
-                //qDebug().noquote().nospace() << "Pre File B: " << fileInfo.absoluteFilePath() << tree;
+        bool CDirModel::hasChildren( const QModelIndex &parent ) const
+        {
+            if ( isUnfetched( parent ) )
+                return true;
+            return QStandardItemModel::hasChildren( parent );
+        }
 
+        bool CDirModel::canFetchMore( const QModelIndex &parent ) const
+        {
+            if ( isUnfetched( parent ) )
                 return true;
-            };
+            return QStandardItemModel::canFetchMore( parent );
+        }
+
+        void CDirModel::fetchMore( const QModelIndex &parent )
+        {
+            if ( !isUnfetched( parent ) )
+                return QStandardItemModel::fetchMore( parent );
 
-            info.fPostDirFunction = [ this, &tree ]( const QFileInfo &dirInfo, bool aOK )
+            NSABUtils::CAutoWaitCursor awc;
+            fetchDirectory( filePath( parent ) );
+        }
+
+        TParentTree CDirModel::liveUpdateParentTree( const QString &dirPath )
+        {
+            // the chain of directories from the root down to dirPath, reusing the rows already in the model
+            auto rootPath = fRootPath.absolutePath();
+            std::list< QFileInfo > dirs;
+            for ( auto curr = QFileInfo( dirPath ); ; curr = QFileInfo( curr.absolutePath() ) )
             {
-                postDirFunction( aOK, dirInfo, tree, false );
-                //qDebug().noquote().nospace() << "Post Dir A: " << dirInfo.absoluteFilePath() << tree << "AOK? " << aOK;
-                tree.pop_back();
-                //qDebug().noquote().nospace() << "Post Dir B: " << dirInfo.absoluteFilePath() << tree;
-            };
+                dirs.push_front( curr );
+                if ( curr.absoluteFilePath() == rootPath )
+                    break;
+                if ( curr.isRoot() )
+                    return {};
+            }
 
-            info.fPostFileFunction = [ this, &tree ]( const QFileInfo &fileInfo, bool aOK )
+            TParentTree retVal;
+            for ( auto &&ii : dirs )
             {
-                //qDebug() << fileInfo.absoluteFilePath();
-                postFileFunction( aOK, fileInfo, tree, false );
+                auto item = getItemFromPath( ii );
+                if ( item && ( item->data( ECustomRoles::eAbsFilePath ).toString() == ii.absoluteFilePath() ) )
+                    retVal.emplace_back( ii, this, item );
+                else
+                    retVal.push_back( std::move( getItemRow( ii ) ) );
+            }
+            return retVal;
+        }
+
+        void CDirModel::removePathItem( const QString &path )
+        {
+            auto prefix = path + "/";
+            for ( auto ii = fScannedPaths.lower_bound( path ); ( ii != fScannedPaths.end() ) && ( ( *ii == path ) || ( *ii ).startsWith( prefix ) ); )
+            {
+                if ( fWatchedFiles.erase( *ii ) )
+                    fFileSystemWatcher->removePath( *ii );
+                ii = fScannedPaths.erase( ii );
+            }
+            for ( auto ii = fUnfetchedDirs.lower_bound( path ); ( ii != fUnfetchedDirs.end() ) && ( ( *ii == path ) || ( *ii ).startsWith( prefix ) ); )
+                ii = fUnfetchedDirs.erase( ii );
+            fDirScanAlreadyAdded.erase( path );
+            clearPathStatusCache( path );
 
-                //qDebug().noquote().nospace() << "Post File A: " << fileInfo.absoluteFilePath() << tree << "AOK? " << aOK;
-                while ( tree.back().fIsFile )
-                    tree.pop_back();
-                //qDebug().noquote().nospace() << "Post File B: " << dirInfo.absoluteFilePath() << tree;
+            auto pos = fPathMapping.find( path );
+            auto item = ( pos == fPathMapping.end() ) ? nullptr : ( *pos ).second;
+            if ( pos != fPathMapping.end() )
+                fPathMapping.erase( pos );
+            if ( !item || ( item->data( ECustomRoles::eAbsFilePath ).toString() != path ) )   // stale mapping from a rename
+                return;
+
+            // forget every item going away with the row, not all of them are mapped under its path (subtitles under their video)
+            std::unordered_set< QStandardItem * > removed;
+            std::function< void( QStandardItem * ) > collect = [ &removed, &collect ]( QStandardItem *curr )
+            {
+                removed.insert( curr );
+                for ( int ii = 0; ii < curr->rowCount(); ++ii )
+                {
+                    for ( int jj = 0; jj < curr->columnCount(); ++jj )
+                    {
+                        if ( curr->child( ii, jj ) )
+                            collect( curr->child( ii, jj ) );
+                    }
+                }
             };
+            collect( item );
+            for ( auto ii = fPathMapping.begin(); ii != fPathMapping.end(); )
+            {
+                if ( removed.find( ( *ii ).second ) != removed.end() )
+                    ii = fPathMapping.erase( ii );
+                else
+                    ++ii;
+            }
+            fMsgItems.remove_if( [ &removed ]( QStandardItem *curr ) { return removed.find( curr ) != removed.end(); } );
 
-            std::optional< QDateTime > lastUpdate;
-            iterateEveryFile( fileInfo, info, lastUpdate, false );
+            auto parent = item->parent() ? item->parent() : invisibleRootItem();
+            parent->removeRow( item->row() );
         }
 
         void CDirModel::appendRow( QStandardItem *parent, QList< QStandardItem * > &items )
@@ -575,18 +925,20 @@ namespace NMediaManager
 
         bool CDirModel::isSkippedPathName( const QFileInfo &fi, bool allowIgnore ) const
         {
-            if ( allowIgnore && NPreferences::NCore::CPreferences::instance()->getIgnorePathNamesToSkip( ignoreExtrasOnSearch() ) )
+            auto prefs = NPreferences::NCore::CPreferences::instance()->snapshot();
+            if ( allowIgnore && prefs->ignorePathNamesToSkip( ignoreExtrasOnSearch() ) )
                 return false;
 
-            return NPreferences::NCore::CPreferences::instance()->isSkippedPath( ignoreExtrasOnSearch(), fi );
+            return prefs->skippedPathMatcher( ignoreExtrasOnSearch() )->matches( fi.fileName() );
         }
 
         bool CDirModel::isIgnoredPathName( const QFileInfo &fileInfo, bool allowIgnore ) const
         {
-            if ( allowIgnore && NPreferences::NCore::CPreferences::instance()->getIgnorePathNamesToIgnore() )
+            auto prefs = NPreferences::NCore::CPreferences::instance()->snapshot();
+            if ( allowIgnore && prefs->fIgnorePathNamesToIgnore )
                 return false;
 
-            return NPreferences::NCore::CPreferences::instance()->isIgnoredPath( fileInfo );
+            return prefs->fIgnoredPathMatcher->matches( fileInfo.fileName() );
         }
 
         STreeNode CDirModel::getItemRow( const QFileInfo &fileInfo ) const
@@ -594,38 +946,75 @@ namespace NMediaManager
             return STreeNode( fileInfo, this, isRootPath( fileInfo ) );
         }
 
-        STreeNode::STreeNode( const QFileInfo &fileInfo, const CDirModel *model, bool isRoot ) :
+        STreeNode CDirModel::getItemRow( const SDirScanEntry &entry ) const
+        {
+            if ( !entry.fStat.has_value() )
+                return getItemRow( entry.fFileInfo );
+
+            auto isRoot = entry.fStat.value().fIsDir && isRootPath( entry.fFileInfo );
+            return STreeNode( entry.fFileInfo, this, isRoot, &entry.fStat.value() );
+        }
+
+        STreeNode::STreeNode( const QFileInfo &fileInfo, const CDirModel *model, bool isRoot, const SDirScanStat *stat ) :
             fFileInfo( fileInfo ),
             fModel( model )
         {
-            fIsFile = fileInfo.isFile();
+            auto isDir = stat ? stat->fIsDir : fileInfo.isDir();
+            fIsFile = stat ? !stat->fIsDir : fileInfo.isFile();
             //qDebug() << fileInfo.absoluteFilePath() << isRoot;
-            QString name;
 
-            auto path = QDir::toNativeSeparators( fileInfo.absoluteFilePath() );
-            if ( !NSABUtils::NFileUtils::isIPAddressNetworkPath( fileInfo ) )
-                path = QDir::toNativeSeparators( fileInfo.canonicalFilePath() );
+            QString name;
+            if ( isRoot )
+            {
+                name = QDir::toNativeSeparators( fileInfo.absoluteFilePath() );
+                if ( !NSABUtils::NFileUtils::isIPAddressNetworkPath( fileInfo ) )
+                    name = QDir::toNativeSeparators( fileInfo.canonicalFilePath() );
+            }
+            else
+                name = fModel->getTreeNodeName( fileInfo );
 
-            auto nameItem = SDirNodeItem( isRoot ? path : fModel->getTreeNodeName( fileInfo ), EColumns::eFSName );
-            nameItem.fIcon = model->iconProvider()->icon( fileInfo );
+            auto nameItem = SDirNodeItem( name, EColumns::eFSName );
+            nameItem.fIcon = model->iconProvider()->icon( fileInfo, isDir );
             nameItem.setData( fileInfo.absoluteFilePath(), ECustomRoles::eAbsFilePath );
-            nameItem.setData( fileInfo.isDir(), ECustomRoles::eIsDir );
+            nameItem.setData( isDir, ECustomRoles::eIsDir );
             nameItem.fEditable = std::make_pair( EType::ePath, static_cast< NSABUtils::EMediaTags >( -1 ) );
             nameItem.fCheckable = { true, false, Qt::CheckState::Checked };
             fItems.push_back( nameItem );
-            fItems.emplace_back( fileInfo.isFile() ? NSABUtils::NFileUtils::byteSizeString( fileInfo ) : QString(), EColumns::eFSSize );
-            if ( fileInfo.isFile() )
+
+            QString sizeString;
+            if ( fIsFile )
+                sizeString = stat ? NSABUtils::NFileUtils::byteSizeString( static_cast< uint64_t >( stat->fSize ) ) : NSABUtils::NFileUtils::byteSizeString( fileInfo );
+            fItems.emplace_back( sizeString, EColumns::eFSSize );
+            if ( fIsFile )
             {
                 fItems.back().fAlignment = Qt::AlignRight | Qt::AlignVCenter;
             }
-            fItems.emplace_back( model->iconProvider()->type( fileInfo ), EColumns::eFSType );
-            fItems.emplace_back( fileInfo.lastModified().toString( "MM/dd/yyyy hh:mm:ss.zzz" ), EColumns::eFSModDate );
+            fItems.emplace_back( model->internString( model->iconProvider()->type( fileInfo, isDir ) ), EColumns::eFSType );
+
+            auto modified = stat ? QDateTime::fromMSecsSinceEpoch( stat->fModified ) : fileInfo.lastModified();
+            fItems.emplace_back( modified.toString( "MM/dd/yyyy hh:mm:ss.zzz" ), EColumns::eFSModDate );
 
             auto modelItems = model->addAdditionalItems( fileInfo );
             fItems.insert( fItems.end(), modelItems.begin(), modelItems.end() );
             model->postAddItems( fileInfo, fItems );
         }
 
+        STreeNode::STreeNode( const QFileInfo &fileInfo, const CDirModel *model, QStandardItem *existingItem ) :
+            fFileInfo( fileInfo ),
+            fModel( model )
+        {
+            fIsFile = fileInfo.isFile();
+            fLoaded = true;
+            auto parent = existingItem->parent() ? existingItem->parent() : model->invisibleRootItem();
+            for ( int ii = 0; ii < parent->columnCount(); ++ii )
+            {
+                auto curr = parent->child( existingItem->row(), ii );
+                if ( !curr )
+                    break;
+                fRealItems << curr;
+            }
+        }
+
         QString STreeNode::text() const
         {
             return rootItem() ? rootItem()->text() : NCore::CTransformResult::getNoItems();
@@ -653,7 +1042,7 @@ namespace NMediaManager
             {
                 for ( auto &&ii : fItems )
                 {
-                    auto currItem = ii.createStandardItem();
+                    auto currItem = ii.createStandardItem( fModel->mediaTagsEditable() );
 
                     auto nameItem = fRealItems.isEmpty() ? nullptr : fRealItems.front();
 
@@ -1073,6 +1462,7 @@ namespace NMediaManager
             auto item = invisibleRootItem();
             if ( idx.isValid() )
                 item = getPathItemFromIndex( idx );
+            preProcess( item, displayOnly );
             fProcessResults.first = process( item, displayOnly, nullptr );
             postProcess( displayOnly );
             if ( displayOnly && progressDlg() )
@@ -1119,6 +1509,9 @@ namespace NMediaManager
 
         void CDirModel::clear()
         {
+            stopDirScan();
+            fScannedPaths.clear();
+            fInternedStrings.clear();
             fPathMapping.clear();
             QStandardItemModel::clear();
         }
@@ -1131,12 +1524,46 @@ namespace NMediaManager
             if ( !NPreferences::NCore::CPreferences::instance()->isMediaFile( fi ) )
                 return {};
 
+            auto cached = NPreferences::NCore::CMediaInfoCache::instance()->find( fi, tags );
+            if ( cached.has_value() )
+                return cached.value();
+
+            // matroska headers can stand in for ffprobe, but only when they have every requested tag
+            // they are read like any other probe, in the pool when loading in the background
+            // a cached entry without the tags means the headers were already read and came up short
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            auto headersRead = NPreferences::NCore::CMediaInfoCache::instance()->find( fi, {} ).has_value();
+            if ( !headersRead && !prefs->getCachedMediaInfo( fi ) && NPreferences::NCore::CMKVProbe::canProbe( fi ) && NPreferences::NCore::CMKVProbe::canSupply( tags ) )
+            {
+                if ( !prefs->getLoadMediaInfo() )
+                    return {};
+
+                if ( prefs->getBackgroundLoadMediaInfo() )
+                {
+                    // slotUpdateMediaInfo refreshes the row when the headers have been read
+                    NPreferences::NCore::CMediaProbePool::instance()->requestContainerTags( fi, NPreferences::NCore::CMediaProbePool::EPriority::eBackground );
+                    return {};
+                }
+
+                auto probed = NPreferences::NCore::CMKVProbe::probe( fi );
+                if ( probed.has_value() )
+                {
+                    NPreferences::NCore::CMediaInfoCache::instance()->add( fi, probed.value() );
+                    cached = NPreferences::NCore::CMediaInfoCache::instance()->find( fi, tags );
+                    if ( cached.has_value() )
+                        return cached.value();
+                }
+            }
+
             NSABUtils::CAutoWaitCursor awc;
             auto mediaInfo = getMediaInfo( fi );
             if ( !mediaInfo )
                 return {};
             if ( !mediaInfo->aOK() )
                 return {};
+
+            // cache every tag, so the next session or page doesnt need to run ffprobe
+            NPreferences::NCore::CMediaInfoCache::instance()->add( fi, mediaInfo->getMediaTags( std::list< NSABUtils::EMediaTags >() ) );
             return mediaInfo->getMediaTags( tags );
         }
 
@@ -1175,6 +1602,24 @@ namespace NMediaManager
             }
         }
 
+        // the rows on screen get probed ahead of the rest of the directory
+        void CDirModel::slotUpdateViewportPriority()
+        {
+            auto view = filesView();
+            if ( !view || ( view->model() != this ) )
+                return;
+
+            QStringList paths;
+            auto viewportHeight = view->viewport()->height();
+            for ( auto idx = view->indexAt( QPoint( 1, 1 ) ); idx.isValid() && ( view->visualRect( idx ).top() < viewportHeight ); idx = view->indexBelow( idx ) )
+            {
+                auto fi = fileInfo( idx );
+                if ( !fi.isDir() )
+                    paths << fi.absoluteFilePath();
+            }
+            NPreferences::NCore::CMediaProbePool::instance()->setVisible( paths );
+        }
+
         bool CDirModel::canShowMediaInfo() const
         {
             return true;
@@ -1194,6 +1639,9 @@ namespace NMediaManager
             if ( !NPreferences::NCore::CPreferences::instance()->isMediaFile( fi ) )
                 return;
 
+            if ( force )
+                NPreferences::NCore::CMediaProbePool::instance()->prioritize( fi.absoluteFilePath(), NPreferences::NCore::CMediaProbePool::EPriority::eExplicit );
+
             auto mediaInfo = getDefaultMediaTags( fi );
             auto mediaData = getMediaDataInfo();
 
@@ -1233,7 +1681,7 @@ namespace NMediaManager
             for ( ; ( mediaTagIter != mediaTags.end() ) && ( columnPosIter != mediaColumns.end() ); ++mediaTagIter, ++columnPosIter )
             {
                 auto &&currTag = ( *mediaTagIter );
-                retVal.emplace_back( mediaInfo[ currTag ], offset++ );
+                retVal.emplace_back( isRepeatedTag( currTag ) ? internString( mediaInfo[ currTag ] ) : mediaInfo[ currTag ], offset++ );
                 if ( ( currTag == NSABUtils::EMediaTags::eTitle ) || ( currTag == NSABUtils::EMediaTags::eDate ) || ( currTag == NSABUtils::EMediaTags::eComment ) )
                     retVal.back().fEditable = std::make_pair( EType::eMediaTag, currTag );
 
@@ -1248,12 +1696,48 @@ namespace NMediaManager
         {
         }
 
-        bool CDirModel::process( const QModelIndex &idx, const std::function< void( int count, int eventsPerPath ) > &startProgress, const std::function< void( bool finalStep, bool canceled ) > &endProgress, QWidget *parent )
+        bool CDirModel::isRepeatedTag( NSABUtils::EMediaTags tag )
+        {
+            // titles, comments, lengths and bitrates are close to unique per file, interning them only adds a hash node
+            static const std::unordered_set< NSABUtils::EMediaTags > sRepeatedTags = {
+                NSABUtils::EMediaTags::eAllVideoCodecs,
+                NSABUtils::EMediaTags::eAllAudioCodecsDisp,
+                NSABUtils::EMediaTags::eAudioCodecDisp,
+                NSABUtils::EMediaTags::eAllSubtitleCodecs,
+                NSABUtils::EMediaTags::eAllSubtitleLanguages,
+                NSABUtils::EMediaTags::eResolution,
+                NSABUtils::EMediaTags::eWidth,
+                NSABUtils::EMediaTags::eHeight,
+                NSABUtils::EMediaTags::eAspectRatio,
+                NSABUtils::EMediaTags::eAudioChannelCount,
+                NSABUtils::EMediaTags::eAudioSampleRateString,
+                NSABUtils::EMediaTags::eHDRInfo,
+                NSABUtils::EMediaTags::eGenre,
+            };
+            return sRepeatedTags.find( tag ) != sRepeatedTags.end();
+        }
+
+        QString CDirModel::internString( const QString &value ) const
         {
-            process( idx, true );
-            if ( fProcessResults.second && fProcessResults.second->rowCount() == 0 )
-            {
-                QMessageBox::information( parent, tr( "Nothing to change" ), tr( "No files or directories could be processed" ) );
+            if ( value.isEmpty() )
+                return value;
+            return *fInternedStrings.insert( value ).first;
+        }
+
+        bool CDirModel::mediaTagsEditable() const
+        {
+            if ( !fMediaTagsEditable.has_value() )
+                fMediaTagsEditable = !NPreferences::NCore::CPreferences::instance()->getMKVPropEditEXE().isEmpty();
+            return fMediaTagsEditable.value();
+        }
+
+        bool CDirModel::process( const QModelIndex &idx, const std::function< void( int count, int eventsPerPath ) > &startProgress, const std::function< void( bool finalStep, bool canceled ) > &endProgress, QWidget *parent )
+        {
+            fetchAll();
+            process( idx, true );
+            if ( fProcessResults.second && fProcessResults.second->rowCount() == 0 )
+            {
+                QMessageBox::information( parent, tr( "Nothing to change" ), tr( "No files or directories could be processed" ) );
                 endProgress( true, false );
                 return false;
             }
@@ -1393,7 +1877,7 @@ namespace NMediaManager
 
                 std::unordered_map< NSABUtils::EMediaTags, QString > tags = { { NSABUtils::EMediaTags::eTitle, title }, { NSABUtils::EMediaTags::eDate, year }, { NSABUtils::EMediaTags::eComment, comment } };
 
-                if ( NPreferences::NCore::CPreferences::instance()->getLoadMediaInfo() )
+                if ( NPreferences::NCore::CPreferences::instance()->snapshot()->fLoadMediaInfo )
                     aOK = NSABUtils::setMediaTags( fileName, tags, NPreferences::NCore::CPreferences::instance()->getMKVPropEditEXE(), &localMsg );
             }
 
@@ -1427,40 +1911,506 @@ namespace NMediaManager
             return aOK;
         }
 
-        void CDirModel::addProcessError( const QString &msg )
+        void CDirModel::addProcessError( const std::shared_ptr< SProcessInfo > &processInfo, const QString &msg )
         {
-            if ( fProcessQueue.empty() )
+            if ( !processInfo )
                 return;
+            for ( auto &&ii : processInfo->items() )
+                appendError( ii, tr( "%1: FAILED TO PROCESS" ).arg( msg ) );
+        }
 
-            if ( !fProcessQueue.front()->fItem )
+        void CDirModel::queueProcess( std::shared_ptr< SProcessInfo > processInfo )
+        {
+            if ( !processInfo )
                 return;
-            appendError( fProcessQueue.front()->fItem, tr( "%1: FAILED TO PROCESS" ).arg( msg ) );
+            if ( !processInfo->fJournalID && fBasePage )
+                processInfo->fJournalID = CProcessJournal::instance()->queued( fBasePage->getPageName(), *processInfo );
+            fProcessQueue.push_back( processInfo );
+            QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
+        }
+
+        void CDirModel::clearProcessQueue()
+        {
+            for ( auto &&ii : fProcessQueue )
+                CProcessJournal::instance()->finished( ii->fJournalID, false );
+            fProcessQueue.clear();
+        }
+
+        void CDirModel::resumeProcesses( const std::list< SJournalJob > &jobs )
+        {
+            fProcessResults.first = true;
+            fProcessResults.second = std::make_shared< QStandardItemModel >();
+            if ( progressDlg() )
+            {
+                disconnect( progressDlg(), &NSABUtils::CDoubleProgressDlg::canceled, this, &CDirModel::slotProgressCanceled );
+                connect( progressDlg(), &NSABUtils::CDoubleProgressDlg::canceled, this, &CDirModel::slotProgressCanceled );
+            }
+
+            for ( auto &&job : jobs )
+            {
+                auto processInfo = std::make_shared< SProcessInfo >();
+                processInfo->fJournalID = job.fID;
+                processInfo->fCmd = job.fCmd;
+                processInfo->fArgs = job.fArgs;
+                processInfo->fOldName = job.fOldName;
+                processInfo->fNewNames = job.fNewNames;
+                processInfo->fAncillary = job.fAncillary;
+                processInfo->fTimeStamps = job.fTimeStamps;
+                processInfo->fBackupOrig = job.fBackupOrig;
+                processInfo->fSetMetainfoTagsOnSuccess = job.fSetMetainfoTagsOnSuccess;
+                processInfo->fForceUnbuffered = job.fForceUnbuffered;
+                processInfo->fPostProcessType = job.fPostProcessType;
+                processInfo->fMaximum = job.fMaximum;
+                processInfo->fProgressLabel = job.fProgressLabel;
+                processInfo->fResourceClass = static_cast< EProcessResourceClass >( job.fResourceClass );
+                processInfo->fMinThreads = job.fMinThreads;
+                processInfo->fMaxThreads = job.fMaxThreads;
+
+                processInfo->fOutputsComplete = job.fOutputsComplete;
+
+                processInfo->fItem = new QStandardItem( ( job.fOutputsComplete ? tr( "Finish '%1'" ) : tr( "Resume '%1'" ) ).arg( getDispName( processInfo->fOldName ) ) );
+                processInfo->fItem->setData( processInfo->fOldName, ECustomRoles::eOldName );
+                processInfo->fItem->setData( processInfo->fNewNames, ECustomRoles::eNewName );
+                fProcessResults.second->appendRow( processInfo->fItem );
+
+                if ( job.fOutputsComplete )
+                {
+                    // the outputs were written, only the backup, renames, tags and timestamps are left
+                    processInfo->cleanup( this, true );
+                    CProcessJournal::instance()->finished( job.fID, true );
+                    if ( progressDlg() )
+                        progressDlg()->setValue( progressDlg()->value() + 1 );
+                    continue;
+                }
+
+                if ( !QFileInfo::exists( processInfo->fOldName ) || !restoreProcess( processInfo, job ) )
+                {
+                    appendError( processInfo->fItem, tr( "%1: Can not be resumed" ).arg( getDispName( processInfo->fOldName ) ) );
+                    fProcessResults.first = false;
+                    CProcessJournal::instance()->finished( job.fID, false );
+                    if ( progressDlg() )
+                        progressDlg()->setValue( progressDlg()->value() + 1 );
+                    continue;
+                }
+                queueProcess( processInfo );
+            }
+            if ( fProcessQueue.empty() && !jobs.empty() )
+            {
+                fProcessesActive = true;   // nothing could be resumed, still report the results
+                QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
+            }
+        }
+
+        bool CDirModel::processesRunning() const
+        {
+            if ( !fProcessQueue.empty() || !fMovingStagedOutputs.empty() )
+                return true;
+            for ( auto &&ii : fProcessSlots )
+            {
+                if ( ii->fInfo )
+                    return true;
+            }
+            return false;
+        }
+
+        SProcessSlot *CDirModel::freeProcessSlot()
+        {
+            auto maxSlots = static_cast< size_t >( std::max( 1, maxConcurrentProcesses() ) );
+            for ( size_t ii = 0; ( ii < maxSlots ) && ( ii < fProcessSlots.size() ); ++ii )
+            {
+                auto &&slot = fProcessSlots[ ii ];
+                if ( !slot->fInfo && ( slot->fProcess->state() == QProcess::NotRunning ) )
+                    return slot.get();
+            }
+            if ( fProcessSlots.size() >= maxSlots )
+                return nullptr;
+
+            auto slot = std::make_unique< SProcessSlot >();
+            slot->fProcess = new QProcess( this );
+            auto retVal = slot.get();
+            connect( slot->fProcess, &QProcess::errorOccurred, this, [ this, retVal ]( QProcess::ProcessError error ) { processErrorOccured( retVal, error ); } );
+            connect( slot->fProcess, qOverload< int, QProcess::ExitStatus >( &QProcess::finished ), this, [ this, retVal ]( int exitCode, QProcess::ExitStatus exitStatus ) { processFinished( retVal, exitCode, exitStatus ); } );
+            connect( slot->fProcess, &QProcess::readyReadStandardError, this, [ this, retVal ]() { processStandardError( retVal ); } );
+            connect( slot->fProcess, &QProcess::readyReadStandardOutput, this, [ this, retVal ]() { processStandardOutput( retVal ); } );
+            fProcessSlots.push_back( std::move( slot ) );
+            return retVal;
+        }
+
+        SProcessSlot *CDirModel::primaryProcessSlot() const
+        {
+            SProcessSlot *retVal = nullptr;
+            for ( auto &&ii : fProcessSlots )
+            {
+                if ( ii->fInfo && ( !retVal || ( ii->fStartOrder < retVal->fStartOrder ) ) )
+                    retVal = ii.get();
+            }
+            return retVal;
+        }
+
+        std::shared_ptr< SProcessInfo > CDirModel::currentProcessInfo() const
+        {
+            auto slot = fLogSlot ? fLogSlot : primaryProcessSlot();
+            return slot ? slot->fInfo : std::shared_ptr< SProcessInfo >();
         }
 
         void CDirModel::slotRunNextProcessInQueue()
         {
-            if ( fProcess->state() != QProcess::NotRunning )
+            if ( fProcessQueue.empty() )
+            {
+                if ( fProcessesActive && !processesRunning() )
+                {
+                    fProcessesActive = false;
+                    fLogFlushTimer->stop();
+                    updateProcessUtilization();
+                    addToLog( fProcessUtilization.report(), true );
+                    emit sigProcessesFinished( fProcessResults.first, true, false, true );
+                }
                 return;
+            }
 
-            if ( progressDlg() && !fFirstProcess )
-                progressDlg()->setValue( progressDlg()->value() + 1 );
-            fFirstProcess = false;
-            if ( fProcessQueue.empty() )
+            // a job waits while an earlier job on the same files is running or still queued, so cleanup stays in order per file
+            std::unordered_set< QString > busyFiles;
+            auto addFiles = []( const std::shared_ptr< SProcessInfo > &processInfo, std::unordered_set< QString > &files )
+            {
+                auto paths = processInfo->fNewNames;
+                paths << processInfo->fOldName;
+                paths.removeDuplicates();
+
+                bool retVal = false;
+                for ( auto &&ii : paths )
+                {
+                    if ( ii.isEmpty() )
+                        continue;
+                    retVal = !files.insert( ii ).second || retVal;
+                }
+                return retVal;
+            };
+            auto threadBudget = NPreferences::NCore::CPreferences::instance()->getProcessThreadBudget();
+            auto processesPerDisk = NPreferences::NCore::CPreferences::instance()->getProcessesPerDisk();
+            if ( !fProcessesActive )
+                fProcessUtilization.start( threadBudget, processesPerDisk );
+
+            int threadsInUse = 0;
+            int numRunning = 0;
+            std::unordered_map< QString, int > processesPerDevice;
+            for ( auto &&ii : fMovingStagedOutputs )
+                addFiles( ii, busyFiles );
+            for ( auto &&ii : fProcessSlots )
+            {
+                if ( !ii->fInfo )
+                    continue;
+                addFiles( ii->fInfo, busyFiles );
+                threadsInUse += ii->fThreads;
+                numRunning++;
+                if ( ii->fInfo->fResourceClass != EProcessResourceClass::eCPU )
+                    processesPerDevice[ ii->fDevice ]++;
+            }
+
+            // the free threads are shared between the jobs that can start now, rather than the first one taking them all
+            auto numStartable = std::min< int >( static_cast< int >( fProcessQueue.size() ), std::max( 1, maxConcurrentProcesses() ) - numRunning );
+
+            std::list< SProcessSlot * > toStart;
+            for ( auto &&pos = fProcessQueue.begin(); ( numStartable > 0 ) && ( pos != fProcessQueue.end() ); )
+            {
+                auto &&curr = *pos;
+                if ( addFiles( curr, busyFiles ) )
+                {
+                    ++pos;
+                    continue;
+                }
+
+                auto device = storageDevice( curr->fOldName );
+                bool usesDisk = curr->fResourceClass != EProcessResourceClass::eCPU;
+                if ( usesDisk && ( processesPerDevice[ device ] >= processesPerDisk ) )
+                {
+                    ++pos;
+                    continue;
+                }
+
+                auto available = threadBudget - threadsInUse;
+                if ( ( available < curr->fMinThreads ) && ( threadsInUse > 0 ) )   // an idle machine runs any job, even one larger than the budget
+                {
+                    ++pos;
+                    continue;
+                }
+
+                auto slot = freeProcessSlot();
+                if ( !slot )
+                    break;
+
+                auto threads = std::max( 1, std::min( { curr->fMaxThreads, std::max( available, 1 ), std::max( curr->fMinThreads, available / numStartable ) } ) );
+                slot->fInfo = curr;
+                slot->fStartOrder = fNextProcessStartOrder++;
+                slot->fThreads = threads;
+                slot->fDevice = device;
+                curr->setThreads( threads );
+
+                threadsInUse += threads;
+                if ( usesDisk )
+                    processesPerDevice[ device ]++;
+                numStartable--;
+
+                toStart.push_back( slot );
+                pos = fProcessQueue.erase( pos );
+            }
+
+            for ( auto &&ii : toStart )
+            {
+                fProcessUtilization.fNumJobs++;
+                startProcess( ii );
+            }
+            updateProcessUtilization();
+            updateProcessProgressLabel();
+        }
+
+        QString CDirModel::storageDevice( const QString &path ) const
+        {
+            auto dir = QFileInfo( path ).absolutePath();
+            auto pos = fStorageDevices.find( dir );
+            if ( pos != fStorageDevices.end() )
+                return ( *pos ).second;
+
+            auto storage = QStorageInfo( dir );
+            auto retVal = storage.isValid() ? QString::fromLocal8Bit( storage.device() ) : dir;
+            fStorageDevices[ dir ] = retVal;
+            return retVal;
+        }
+
+        QString CDirModel::scratchDir( const QString &finalPath, qint64 bytesNeeded )
+        {
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            if ( !prefs->getUseScratchDir() )
+                return {};
+
+            auto dir = QFileInfo( prefs->getScratchDir() );
+            if ( !dir.isDir() || !dir.isWritable() )
+                return {};
+
+            auto retVal = dir.absoluteFilePath();
+            if ( storageDevice( QDir( retVal ).absoluteFilePath( "." ) ) == storageDevice( finalPath ) )   // already on the scratch disk
+                return {};
+
+            auto storage = QStorageInfo( retVal );
+            auto minFree = static_cast< qint64 >( prefs->getScratchDirMinFreeGB() ) * 1024 * 1024 * 1024;
+            if ( !storage.isValid() || ( ( storage.bytesAvailable() - fScratchBytesReserved - bytesNeeded ) < minFree ) )
+            {
+                addToLog( tr( "Not enough free space on the scratch disk '%1' for '%2', writing next to the source" ).arg( retVal ).arg( getDispName( finalPath ) ), false );
+                return {};
+            }
+            return retVal;
+        }
+
+        std::shared_ptr< QTemporaryDir > CDirModel::createTempDir( const QString &sourceFile, qint64 bytesNeeded )
+        {
+            std::shared_ptr< QTemporaryDir > retVal;
+            if ( NPreferences::NCore::CPreferences::instance()->keepTempDir() )
             {
-                emit sigProcessesFinished( fProcessResults.first, true, false, true );
+                retVal = std::make_shared< QTemporaryDir >();
+                retVal->setAutoRemove( false );
+                return retVal;
+            }
+
+            auto sourceDir = QFileInfo( sourceFile ).absoluteDir();
+            auto scratch = scratchDir( sourceDir.absoluteFilePath( "." ), bytesNeeded );
+            auto tempDir = scratch.isEmpty() ? sourceDir : QDir( scratch );
+            retVal = std::make_shared< QTemporaryDir >( tempDir.absoluteFilePath( "./TempDir-XXXXXX" ) );
+            retVal->setAutoRemove( true );
+            return retVal;
+        }
+
+        void CDirModel::stageOutputs( const std::shared_ptr< SProcessInfo > &processInfo )
+        {
+            // intermediate steps write into their job's temporary dir, which is already placed
+            if ( processInfo->fIntermediate || processInfo->fStagingDir || processInfo->fNewNames.isEmpty() )
                 return;
+
+            int numOutputs = 0;
+            for ( auto &&ii : processInfo->fNewNames )
+            {
+                if ( processInfo->fArgs.contains( ii ) )
+                    numOutputs++;
             }
+            if ( !numOutputs )   // written by the post process, not the command
+                return;
 
-            auto &&curr = fProcessQueue.front();
+            // the outputs are estimated at the size of the source each
+            auto bytesNeeded = QFileInfo( processInfo->fOldName ).size() * numOutputs;
+            auto scratch = scratchDir( processInfo->primaryNewName(), bytesNeeded );
+            if ( scratch.isEmpty() )
+                return;
 
-            fProcessFinishedHandled = false;
-            if ( progressDlg() )
+            auto stagingDir = std::make_shared< QTemporaryDir >( QDir( scratch ).absoluteFilePath( "Staging-XXXXXX" ) );
+            stagingDir->setAutoRemove( true );
+            if ( !stagingDir->isValid() )
+                return;
+
+            for ( auto &&ii : processInfo->fNewNames )
+            {
+                auto pos = processInfo->fArgs.indexOf( ii );
+                if ( pos == -1 )
+                    continue;
+
+                auto stagedName = stagingDir->filePath( QFileInfo( ii ).fileName() );
+                for ( ; pos != -1; pos = processInfo->fArgs.indexOf( ii, pos + 1 ) )
+                    processInfo->fArgs[ pos ] = stagedName;
+                processInfo->fStagedNames.emplace_back( ii, stagedName );
+            }
+            processInfo->fStagingDir = stagingDir;
+            processInfo->fStagedBytes = bytesNeeded;
+            fScratchBytesReserved += bytesNeeded;
+            addToLog( tr( "Writing the outputs of '%1' to the scratch disk '%2'" ).arg( getDispName( processInfo->fOldName ) ).arg( stagingDir->path() ), true );
+        }
+
+        bool CDirModel::moveStagedFile( const QString &from, const QString &to, QString &msg )
+        {
+            std::error_code ec;
+            std::filesystem::rename( std::filesystem::u8path( from.toStdString() ), std::filesystem::u8path( to.toStdString() ), ec );
+            if ( !ec )   // same file system, replaces any existing file in one step
+                return true;
+
+            // copied next to the destination under a temporary name, any existing file is only replaced once the copy is complete
+            auto partialName = to + ".partial";
+            QFile::remove( partialName );
+            bool copied = false;
+#ifdef Q_OS_LINUX
+            // one sequential copy, the kernel reflinks or copies server side when both file systems allow it
+            {
+                QFile src( from );
+                QFile dest( partialName );
+                if ( !src.open( QFile::ReadOnly ) || !dest.open( QFile::WriteOnly | QFile::Truncate ) )
+                {
+                    msg = src.isOpen() ? dest.errorString() : src.errorString();
+                    return false;
+                }
+
+                auto size = src.size();
+                auto remaining = size;
+                bool unsupported = false;
+                while ( remaining > 0 )
+                {
+                    auto numCopied = ::copy_file_range( src.handle(), nullptr, dest.handle(), nullptr, static_cast< size_t >( std::min< qint64 >( remaining, 1LL << 30 ) ), 0 );
+                    if ( numCopied < 0 )
+                    {
+                        unsupported = ( remaining == size ) && ( ( errno == EXDEV ) || ( errno == ENOSYS ) || ( errno == EOPNOTSUPP ) || ( errno == EINVAL ) );
+                        if ( !unsupported )
+                            msg = QString::fromLocal8Bit( strerror( errno ) );
+                        break;
+                    }
+                    if ( numCopied == 0 )
+                        break;
+                    remaining -= numCopied;
+                }
+                dest.close();
+                src.close();
+
+                if ( !unsupported )
+                {
+                    if ( remaining != 0 )
+                    {
+                        if ( msg.isEmpty() )
+                            msg = tr( "Short copy to '%1'" ).arg( partialName );
+                        QFile::remove( partialName );
+                        return false;
+                    }
+                    copied = true;
+                }
+                else
+                    QFile::remove( partialName );
+            }
+#endif
+            if ( !copied && !QFile::copy( from, partialName ) )
+            {
+                msg = tr( "Could not copy '%1' to '%2'" ).arg( from ).arg( partialName );
+                QFile::remove( partialName );
+                return false;
+            }
+
+            std::filesystem::rename( std::filesystem::u8path( partialName.toStdString() ), std::filesystem::u8path( to.toStdString() ), ec );
+            if ( ec )
             {
-                progressDlg()->setLabelText( getProgressLabel( curr ) );
-                if ( curr->fMaximum != 0 )
-                    progressDlg()->setSecondaryMaximum( curr->fMaximum );
+                msg = tr( "Could not replace '%1' - %2" ).arg( to ).arg( QString::fromStdString( ec.message() ) );
+                QFile::remove( partialName );
+                return false;
+            }
+            QFile::remove( from );
+            return true;
+        }
+
+        void CDirModel::removeOrphanedStagingDirs()
+        {
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            if ( !prefs->getUseScratchDir() )
+                return;
+
+            QDirIterator ii( prefs->getScratchDir(), { "Staging-*" }, QDir::Dirs | QDir::NoDotAndDotDot );
+            while ( ii.hasNext() )
+            {
+                ii.next();
+                QDir( ii.filePath() ).removeRecursively();
+            }
+        }
+
+        void CDirModel::updateProcessUtilization()
+        {
+            int threadsInUse = 0;
+            std::unordered_map< QString, int > processesPerDevice;
+            for ( auto &&ii : fProcessSlots )
+            {
+                if ( !ii->fInfo )
+                    continue;
+                threadsInUse += ii->fThreads;
+                if ( ii->fInfo->fResourceClass != EProcessResourceClass::eCPU )
+                    processesPerDevice[ ii->fDevice ]++;
             }
+            fProcessUtilization.update( threadsInUse, processesPerDevice );
+        }
+
+        void SProcessUtilization::start( int threadBudget, int processesPerDisk )
+        {
+            *this = SProcessUtilization();
+            fThreadBudget = threadBudget;
+            fProcessesPerDisk = processesPerDisk;
+            fTimer.start();
+        }
+
+        void SProcessUtilization::update( int threadsInUse, const std::unordered_map< QString, int > &processesPerDevice )
+        {
+            if ( !fTimer.isValid() )
+                return;
 
+            auto now = fTimer.elapsed();
+            fThreadMSecs += static_cast< double >( fThreadsInUse ) * ( now - fLastUpdate );
+            fLastUpdate = now;
+            fThreadsInUse = threadsInUse;
+            fPeakThreads = std::max( fPeakThreads, threadsInUse );
+            for ( auto &&ii : processesPerDevice )
+                fPeakPerDevice[ ii.first ] = std::max( fPeakPerDevice[ ii.first ], ii.second );
+        }
+
+        QString SProcessUtilization::report() const
+        {
+            auto elapsed = std::max< qint64 >( 1, fLastUpdate );
+            auto averageThreads = fThreadMSecs / elapsed;
+            auto retVal = QObject::tr( "Process Utilization: %1 jobs in %2, average %3 of %4 budgeted threads (%5%), peak %6 threads" )
+                              .arg( fNumJobs )
+                              .arg( NSABUtils::CTimeString( std::chrono::milliseconds( fLastUpdate ) ).toString( "hh:mm:ss", false ) )
+                              .arg( averageThreads, 0, 'f', 1 )
+                              .arg( fThreadBudget )
+                              .arg( fThreadBudget ? ( 100.0 * averageThreads / fThreadBudget ) : 0.0, 0, 'f', 0 )
+                              .arg( fPeakThreads );
+            for ( auto &&ii : fPeakPerDevice )
+                retVal += QObject::tr( "; disk '%1' peak %2 of %3 processes" ).arg( ii.first ).arg( ii.second ).arg( fProcessesPerDisk );
+            return retVal;
+        }
+
+        void CDirModel::startProcess( SProcessSlot *slot )
+        {
+            auto &&curr = slot->fInfo;
+            if ( !curr )
+                return;
+
+            fProcessesActive = true;
+            stageOutputs( curr );
             auto tmp = QStringList() << curr->fCmd << curr->fArgs;
             for ( auto &&ii : tmp )
             {
@@ -1468,13 +2418,41 @@ namespace NMediaManager
                     ii = "\"" + ii + "\"";
             }
             addToLog( "Running Command:" + tmp.join( " " ), true );
+            slot->fLog = std::make_unique< CProcessLogBuffer >( curr->fOldName, tmp.join( " " ) );
+            if ( !slot->fLog->fileName().isEmpty() )
+                addToLog( tr( "Full output: '%1'" ).arg( slot->fLog->fileName() ), true );
+            if ( !fLogFlushTimer->isActive() )
+                fLogFlushTimer->start();
 
             if ( curr->fForceUnbuffered )
-                fProcess->setCreateProcessArgumentsModifier( NSABUtils::getForceUnbufferedProcessModifier() );
+                slot->fProcess->setCreateProcessArgumentsModifier( NSABUtils::getForceUnbufferedProcessModifier() );
             else
-                fProcess->setCreateProcessArgumentsModifier( {} );
+                slot->fProcess->setCreateProcessArgumentsModifier( {} );
+            slot->fStdOutRemaining = { QString(), false };
+            slot->fStdErrRemaining = { QString(), false };
+            slot->fProgress.reset( CFFmpegProgressParser::usesProgressPipe( curr->fArgs ) ? new CFFmpegProgressParser : nullptr );
+            CProcessJournal::instance()->started( curr->fJournalID );
+            slot->fProcess->start( curr->fCmd, curr->fArgs, QProcess::ReadWrite );
+        }
+
+        void CDirModel::updateProcessProgressLabel()
+        {
+            auto primary = primaryProcessSlot();
+            if ( !progressDlg() || !primary )
+                return;
+
+            auto numRunning = std::count_if( fProcessSlots.begin(), fProcessSlots.end(), []( const std::unique_ptr< SProcessSlot > &ii ) { return ii->fInfo != nullptr; } );
+            auto label = getProgressLabel( primary->fInfo );
+            if ( numRunning > 1 )
+                label += tr( "<p>%1 other jobs running</p>" ).arg( numRunning - 1 );
+            progressDlg()->setLabelText( label );
+
+            if ( fPrimaryStartOrder == primary->fStartOrder )
+                return;
+            fPrimaryStartOrder = primary->fStartOrder;
             fLastProgress.reset();
-            fProcess->start( curr->fCmd, curr->fArgs, QProcess::ReadWrite );
+            if ( primary->fInfo->fMaximum != 0 )
+                progressDlg()->setSecondaryMaximum( primary->fInfo->fMaximum );
         }
 
         QString CDirModel::getProgressLabel( std::shared_ptr< SProcessInfo > /*processInfo*/ ) const
@@ -1517,12 +2495,17 @@ namespace NMediaManager
 
         void CDirModel::slotProgressCanceled()
         {
-            fProcess->kill();
+            clearProcessQueue();
+            for ( auto &&ii : fProcessSlots )
+            {
+                if ( ii->fProcess->state() != QProcess::NotRunning )
+                    ii->fProcess->kill();
+            }
         }
 
         std::list< SDirNodeItem > CDirModel::addAdditionalItems( const QFileInfo &fileInfo ) const
         {
-            if ( showMediaItems() && canShowMediaInfo() && ( NSABUtils::CMediaInfoMgr::instance()->isMediaCached( fileInfo ) || NPreferences::NCore::CPreferences::instance()->getLoadMediaInfo() ) )
+            if ( showMediaItems() && canShowMediaInfo() && ( NSABUtils::CMediaInfoMgr::instance()->isMediaCached( fileInfo ) || NPreferences::NCore::CPreferences::instance()->snapshot()->fLoadMediaInfo ) )
             {
                 return getMediaInfoItems( fileInfo, firstMediaItemColumn() );
             }
@@ -1535,55 +2518,116 @@ namespace NMediaManager
             return retVal;
         }
 
-        void CDirModel::processFinished( const QString &msg, bool error )
+        void CDirModel::processFinished( SProcessSlot *slot, const QString &msg, bool error )
         {
-            if ( fProcessQueue.empty() )
+            if ( !slot->fInfo )   // errorOccurred and finished can both fire for one run
                 return;
 
+            auto processInfo = slot->fInfo;
+            flushProcessLog( slot );
+            slot->fLog.reset();
             addToLog( msg, !error );
             if ( error )
-                addProcessError( msg );
+                addProcessError( processInfo, msg );
 
             bool wasCanceled = progressCanceled();
-            fProcessResults.first = !error && !wasCanceled;
-            fProcessQueue.front()->cleanup( this, !error && !wasCanceled );
-
-            if ( !fProcessQueue.empty() )
-            {
-                fProcessQueue.pop_front();
-            }
+            bool aOK = !error && !wasCanceled;
+            fProcessResults.first = fProcessResults.first && aOK;
+            if ( processInfo->fSegmentedProgress )
+                segmentedJobFinished( processInfo, slot, aOK );
+            slot->fInfo.reset();
+            slot->fThreads = 0;
+            updateProcessUtilization();
+
+            // the scratch disk is always another device, so the move is a full copy and must not hold up the GUI
+            if ( aOK && processInfo->fStagingDir && !processInfo->fStagedNames.empty() )
+                moveStagedOutputs( processInfo );
+            else
+                finishProcess( processInfo, aOK );
 
             if ( wasCanceled )
-                fProcessQueue.clear();
+                clearProcessQueue();
 
             QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
         }
 
-        void CDirModel::slotProcessErrorOccured( QProcess::ProcessError error )
+        void CDirModel::finishProcess( const std::shared_ptr< SProcessInfo > &processInfo, bool aOK )
         {
-            auto msg = tr( "Error Running Command: %1(%2)" ).arg( errorString( error ) ).arg( error );
-            processFinished( msg, true );
-            fProcessFinishedHandled = true;
+            processInfo->cleanup( this, aOK );
+            CProcessJournal::instance()->finished( processInfo->fJournalID, aOK );
+
+            // an intermediate step only counts when it ends its group without the final step
+            auto &&group = processInfo->fSegmentedProgress;
+            bool jobDone = !processInfo->fIntermediate || ( group && group->fFailed && ( group->fPending == 0 ) );
+            if ( progressDlg() && jobDone )
+                progressDlg()->setValue( progressDlg()->value() + static_cast< int >( processInfo->items().size() ) );   // a combined run finishes every variant it carries
         }
 
-        void CDirModel::slotProcessFinished( int exitCode, QProcess::ExitStatus exitStatus )
+        void CDirModel::moveStagedOutputs( const std::shared_ptr< SProcessInfo > &processInfo )
         {
-            if ( fProcessFinishedHandled )
-                return;
+            fMovingStagedOutputs.push_back( processInfo );
+            addToLog( tr( "Moving the outputs of '%1' from the scratch disk" ).arg( getDispName( processInfo->fOldName ) ), true );
 
-            auto msg = tr( "Running Finished: %1 Exit Code: %2" ).arg( statusString( exitStatus ) ).arg( exitCode );
-            processFinished( msg, ( exitCode != 0 ) || ( exitStatus != QProcess::NormalExit ) );
+            auto stagedNames = processInfo->fStagedNames;
+            fStagingPool.start(
+                [ this, processInfo, stagedNames ]()
+                {
+                    std::list< std::pair< QString, QString > > errors;
+                    for ( auto &&ii : stagedNames )
+                    {
+                        QString msg;
+                        if ( !moveStagedFile( ii.second, ii.first, msg ) )
+                            errors.emplace_back( ii.first, msg );
+                    }
+                    QMetaObject::invokeMethod( this, [ this, processInfo, errors ]() { stagedOutputsMoved( processInfo, errors ); }, Qt::QueuedConnection );
+                } );
         }
 
-        void CDirModel::slotProcessStarted()
+        void CDirModel::stagedOutputsMoved( const std::shared_ptr< SProcessInfo > &processInfo, const std::list< std::pair< QString, QString > > &errors )
         {
-            if ( fProcessQueue.empty() )
+            fMovingStagedOutputs.remove( processInfo );
+            processInfo->fStagedNames.clear();   // already moved, cleanup only reports the failures
+            processInfo->fStagedMoveErrors = errors;
+            finishProcess( processInfo, true );
+            QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
+        }
+
+        void CDirModel::segmentedJobFinished( const std::shared_ptr< SProcessInfo > &processInfo, SProcessSlot *slot, bool aOK )
+        {
+            auto &&group = processInfo->fSegmentedProgress;
+            group->fPending--;
+            if ( aOK )
+            {
+                if ( slot->fProgress && slot->fProgress->progress().fOutTimeUS.has_value() )
+                    group->fCompletedUS += slot->fProgress->progress().fOutTimeUS.value();
                 return;
+            }
+
+            // one failed step fails the source, the queued steps of the group are dropped
+            group->fFailed = true;
+            for ( auto &&ii = fProcessQueue.begin(); ii != fProcessQueue.end(); )
+            {
+                if ( ( *ii )->fSegmentedProgress != group )
+                {
+                    ++ii;
+                    continue;
+                }
+                CProcessJournal::instance()->finished( ( *ii )->fJournalID, false );
+                group->fPending--;
+                ii = fProcessQueue.erase( ii );
+            }
+        }
+
+        void CDirModel::processErrorOccured( SProcessSlot *slot, QProcess::ProcessError error )
+        {
+            auto msg = tr( "Error Running Command: %1(%2)" ).arg( errorString( error ) ).arg( error );
+            processFinished( slot, msg, true );
         }
 
-        void CDirModel::slotProcesssStateChanged( QProcess::ProcessState newState )
+        void CDirModel::processFinished( SProcessSlot *slot, int exitCode, QProcess::ExitStatus exitStatus )
         {
-            (void)newState;
+            auto msg = tr( "Running Finished: %1 Exit Code: %2" ).arg( statusString( exitStatus ) ).arg( exitCode );
+            processFinished( slot, msg, ( exitCode != 0 ) || ( exitStatus != QProcess::NormalExit ) );
         }
 
         void SProcessInfo::cleanup( CDirModel *model, bool aOK )
@@ -1591,7 +2635,42 @@ namespace NMediaManager
             if ( fOldName.isEmpty() || fNewNames.isEmpty() )
                 return;
 
-            if ( aOK && fPostProcess )
+            model->queueLiveUpdate( QFileInfo( fOldName ).absolutePath() );
+            for ( auto &&ii : fNewNames )
+                model->queueLiveUpdate( QFileInfo( ii ).absolutePath() );
+
+            auto appendErrorToAll = [ this ]( const QString &msg )
+            {
+                for ( auto &&ii : items() )
+                    CDirModel::appendError( ii, msg );
+            };
+
+            // once the process succeeded each output stands on its own, one bad output of a combined run does not fail the others
+            auto dropOutput = [ this, model ]( const QString &newName, const QString &msg, bool removeFile )
+            {
+                CDirModel::appendError( itemFor( newName ), msg );
+                model->fProcessResults.first = false;
+                if ( removeFile )
+                    QFile::remove( newName );
+                fNewNames.removeAll( newName );
+            };
+
+            if ( fStagingDir )
+            {
+                // the outputs were moved by the staging pool before the cleanup was started
+                for ( auto &&ii : fStagedMoveErrors )
+                {
+                    if ( aOK )
+                        dropOutput( ii.first, QObject::tr( "%1: FAILED TO MOVE FROM THE SCRATCH DISK - %2" ).arg( model->getDispName( ii.first ) ).arg( ii.second ), true );
+                }
+                model->fScratchBytesReserved -= fStagedBytes;
+                fStagedBytes = 0;
+                fStagedNames.clear();
+                fStagedMoveErrors.clear();
+                fStagingDir.reset();   // removes anything left behind
+            }
+
+            if ( aOK && fPostProcess && !fNewNames.isEmpty() )
             {
                 QString msg;
                 aOK = fPostProcess( this, msg );
@@ -1599,9 +2678,9 @@ namespace NMediaManager
                 {
                     for ( auto &&ii : fNewNames )
                     {
-                        CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO CREATE" ).arg( model->getDispName( ii ) ) );
+                        CDirModel::appendError( itemFor( ii ), QObject::tr( "%1: FAILED TO CREATE" ).arg( model->getDispName( ii ) ) );
                     }
-                    CDirModel::appendError( fItem, QObject::tr( "Message: %1" ).arg( msg ) );
+                    appendErrorToAll( QObject::tr( "Message: %1" ).arg( msg ) );
                 }
             }
 
@@ -1614,49 +2693,66 @@ namespace NMediaManager
                 return;
             }
 
-            if ( fBackupOrig )
+            if ( fOutputsComplete )
             {
-                if ( !NSABUtils::NFileUtils::backup( fOldName ) )
+                // the crash may have come part way through the renames below, an output already renamed is done
+                // the original is backed up before any rename, so it is not backed up again
+                bool renamed = false;
+                for ( auto &&ii : fNewNames )
                 {
-                    CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO BACKUP" ).arg( model->getDispName( fOldName ) ) );
-                    model->fProcessResults.first = false;
-                    return;
+                    auto finalName = ii.mid( 0, ii.length() - 4 );
+                    if ( ( QFileInfo( ii ).suffix() == "new" ) && !QFileInfo::exists( ii ) && QFileInfo::exists( finalName ) )
+                    {
+                        ii = finalName;
+                        renamed = true;
+                    }
                 }
+                if ( renamed || !QFileInfo::exists( fOldName ) )
+                    fBackupOrig = false;
             }
 
-            for ( auto &&ii : fNewNames )
+            for ( auto &&ii : QStringList( fNewNames ) )
             {
                 if ( !QFileInfo::exists( ii ) )
+                    dropOutput( ii, QObject::tr( "%1: New file '%2' does not exist" ).arg( model->getDispName( fOldName ) ).arg( model->getDispName( ii ) ), false );
+            }
+            if ( fNewNames.isEmpty() )
+                return;
+
+            // from here on a crash leaves finished outputs, resuming completes the steps below rather than removing them
+            CProcessJournal::instance()->outputsComplete( fJournalID );
+
+            if ( fBackupOrig )
+            {
+                if ( !NSABUtils::NFileUtils::backup( fOldName ) )
                 {
-                    CDirModel::appendError( fItem, QObject::tr( "%1:  New file does not exist" ).arg( model->getDispName( fOldName ) ).arg( model->getDispName( ii ) ) );
+                    appendErrorToAll( QObject::tr( "%1: FAILED TO BACKUP" ).arg( model->getDispName( fOldName ) ) );
                     model->fProcessResults.first = false;
                     return;
                 }
             }
 
-            for ( auto &&ii : fNewNames )
+            for ( auto &&ii : QStringList( fNewNames ) )
             {
-                if ( QFileInfo( ii ).suffix() == "new" )
+                if ( QFileInfo( ii ).suffix() != "new" )
+                    continue;
+
+                auto newName = ii.mid( 0, ii.length() - 4 );
+                if ( QFileInfo( newName ).exists() )
                 {
-                    auto newName = ii.mid( 0, ii.length() - 4 );
-                    if ( QFileInfo( newName ).exists() )
+                    if ( !NSABUtils::NFileUtils::backup( newName ) )
                     {
-                        if ( !NSABUtils::NFileUtils::backup( newName ) )
-                        {
-                            CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO BACKUP" ).arg( model->getDispName( newName ) ) );
-                            model->fProcessResults.first = false;
-                            return;
-                        }
+                        dropOutput( ii, QObject::tr( "%1: FAILED TO BACKUP" ).arg( model->getDispName( newName ) ), false );
+                        continue;
                     }
+                }
 
-                    if ( !QFile::rename( ii, newName ) )
-                    {
-                        CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO MOVE ITEM TO %2" ).arg( model->getDispName( ii ) ).arg( model->getDispName( newName ) ) );
-                        model->fProcessResults.first = false;
-                        return;
-                    }
-                    ii = newName;
+                if ( !QFile::rename( ii, newName ) )
+                {
+                    dropOutput( ii, QObject::tr( "%1: FAILED TO MOVE ITEM TO %2" ).arg( model->getDispName( ii ) ).arg( model->getDispName( newName ) ), false );
+                    continue;
                 }
+                fNewNames.replace( fNewNames.indexOf( ii ), newName );
             }
 
             QString msg;
@@ -1666,17 +2762,16 @@ namespace NMediaManager
                 {
                     if ( !model->setMediaTags( ii, QString(), QString(), QString(), &msg, true ) )
                     {
-                        CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO SET MKV Tags - %2" ).arg( model->getDispName( ii ) ).arg( msg ) );
+                        CDirModel::appendError( itemFor( ii ), QObject::tr( "%1: FAILED TO SET MKV Tags - %2" ).arg( model->getDispName( ii ) ).arg( msg ) );
                         model->fProcessResults.first = false;
-                        return;
                     }
                 }
             }
 
             QStringList msgs;
-            if ( !model->postExtProcess( this, msgs ) )
+            if ( !fNewNames.isEmpty() && !model->postExtProcess( this, msgs ) )
             {
-                CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO Post Process ITEM TO %2 - %3" ).arg( model->getDispName( fOldName ) ).arg( model->getDispName( fNewNames.join( ", " ) ).arg( msgs.join( "\n" ) ) ) );
+                appendErrorToAll( QObject::tr( "%1: FAILED TO Post Process ITEM TO %2 - %3" ).arg( model->getDispName( fOldName ) ).arg( model->getDispName( fNewNames.join( ", " ) ).arg( msgs.join( "\n" ) ) ) );
                 model->fProcessResults.first = false;
             }
 
@@ -1684,18 +2779,58 @@ namespace NMediaManager
             {
                 if ( QFileInfo::exists( ii ) && !NSABUtils::NFileUtils::setTimeStamps( ii, fTimeStamps ) )
                 {
-                    CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO MODIFY TIMESTAMP ON GENERATED FILE '%2'" ).arg( model->getDispName( fOldName ) ).arg( model->getDispName( ii ) ) );
+                    CDirModel::appendError( itemFor( ii ), QObject::tr( "%1: FAILED TO MODIFY TIMESTAMP ON GENERATED FILE '%2'" ).arg( model->getDispName( fOldName ) ).arg( model->getDispName( ii ) ) );
                     model->fProcessResults.first = false;
                 }
             }
 
             if ( QFileInfo::exists( fOldName ) && !NSABUtils::NFileUtils::setTimeStamps( fOldName, fTimeStamps ) )
             {
-                CDirModel::appendError( fItem, QObject::tr( "%1: FAILED TO MODIFY TIMESTAMP" ).arg( model->getDispName( fOldName ) ) );
+                appendErrorToAll( QObject::tr( "%1: FAILED TO MODIFY TIMESTAMP" ).arg( model->getDispName( fOldName ) ) );
                 model->fProcessResults.first = false;
             }
         }
 
+        QStandardItem *SProcessInfo::itemFor( const QString &newName ) const
+        {
+            for ( auto &&ii : fOutputItems )
+            {
+                if ( ii.second.contains( newName ) || ii.second.contains( newName + ".new" ) )
+                    return ii.first;
+            }
+            return fItem;
+        }
+
+        std::list< QStandardItem * > SProcessInfo::items() const
+        {
+            std::list< QStandardItem * > retVal;
+            for ( auto &&ii : fOutputItems )
+            {
+                if ( ii.first && ( std::find( retVal.begin(), retVal.end(), ii.first ) == retVal.end() ) )
+                    retVal.push_back( ii.first );
+            }
+            if ( retVal.empty() && fItem )
+                retVal.push_back( fItem );
+            return retVal;
+        }
+
+        void SProcessInfo::setThreads( int numThreads )
+        {
+            // a multi output run has one -threads per encoder, they share the grant
+            // only the output side ones count, a -threads ahead of the last -i sizes the shared decoder and is left alone
+            auto outputStart = fArgs.lastIndexOf( "-i" );
+            outputStart = ( outputStart == -1 ) ? 0 : ( outputStart + 2 );
+            std::list< int > positions;
+            for ( auto pos = fArgs.indexOf( "-threads", outputStart ); ( pos != -1 ) && ( ( pos + 1 ) < fArgs.count() ); pos = fArgs.indexOf( "-threads", pos + 2 ) )
+                positions.push_back( pos + 1 );
+            if ( positions.empty() )
+                return;
+
+            auto perEncoder = std::max( 1, numThreads / static_cast< int >( positions.size() ) );
+            for ( auto &&ii : positions )
+                fArgs[ ii ] = QString::number( perEncoder );
+        }
+
         QString SProcessInfo::primaryNewName() const
         {
             if ( fNewNames.isEmpty() )
@@ -1878,16 +3013,54 @@ namespace NMediaManager
             fBasePage->appendToLog( stdOut ? msg : tr( "Error: %1" ).arg( msg ), stdOut );
         }
 
-        void CDirModel::slotProcessStandardError()
+        void CDirModel::processStandardError( SProcessSlot *slot )
+        {
+            auto currData = slot->fProcess->readAllStandardError();
+            auto currText = slot->fLog ? slot->fLog->decode( currData, false ) : QString::fromUtf8( currData );
+            if ( slot->fLog )
+                slot->fLog->append( currText, false );
+            fLogSlot = slot;
+            if ( progressDlg() )
+                processLog( currText, progressDlg() );
+            fLogSlot = nullptr;
+        }
+
+        void CDirModel::processStandardOutput( SProcessSlot *slot )
+        {
+            auto currData = slot->fProcess->readAllStandardOutput();
+            if ( slot->fProgress )   // stdout only carries the key=value progress blocks
+            {
+                if ( slot->fProgress->addData( currData ) )
+                    processFFmpegProgress( slot );
+                return;
+            }
+
+            auto currText = slot->fLog ? slot->fLog->decode( currData, true ) : QString::fromUtf8( currData );
+            if ( slot->fLog )
+                slot->fLog->append( currText, true );
+            fLogSlot = slot;
+            if ( progressDlg() )
+                processLog( currText, progressDlg() );
+            fLogSlot = nullptr;
+        }
+
+        void CDirModel::flushProcessLog( SProcessSlot *slot )
         {
-            auto currText = fProcess->readAllStandardError();
-            fBasePage->appendToLog( currText, stdErrRemaining(), false, true );
+            if ( !slot->fLog || !slot->fLog->hasPending() )
+                return;
+
+            auto stdErr = slot->fLog->takePending( false );
+            if ( !stdErr.isEmpty() )
+                fBasePage->appendProcessOutput( stdErr, slot->fStdErrRemaining );
+            auto stdOut = slot->fLog->takePending( true );
+            if ( !stdOut.isEmpty() )
+                fBasePage->appendProcessOutput( stdOut, slot->fStdOutRemaining );
         }
 
-        void CDirModel::slotProcessStandardOutput()
+        void CDirModel::slotFlushProcessLogs()
         {
-            auto currText = fProcess->readAllStandardOutput();
-            fBasePage->appendToLog( currText, stdOutRemaining(), true, true );
+            for ( auto &&ii : fProcessSlots )
+                flushProcessLog( ii.get() );
         }
 
         void CDirModel::resizeColumns() const
@@ -1983,7 +3156,7 @@ namespace NMediaManager
             beginResetModel();
             fIsLoading = isLoading;
             endResetModel();
-            if ( filesView() )
+            if ( filesView() && !fLoadOnDemand )   // expanding everything would fetch everything
                 filesView()->expandAll();
         }
 
@@ -2197,12 +3370,13 @@ namespace NMediaManager
 
         void CDirModel::addMessageForFile( const QString &msg )
         {
-            if ( fProcessQueue.empty() )
+            auto processInfo = currentProcessInfo();
+            if ( !processInfo )
                 return;
             if ( msg.isEmpty() )
                 return;
 
-            auto fi = QFileInfo( fProcessQueue.front()->fOldName );
+            auto fi = QFileInfo( processInfo->fOldName );
             fMessagesForFiles[ fi.absoluteFilePath() ] << msg;
         }
 
@@ -2214,11 +3388,56 @@ namespace NMediaManager
             return retVal;
         }
 
+        std::optional< QString > CIconProvider::cacheKey( const QFileInfo &info, bool isDir ) const
+        {
+            if ( info.isRoot() )
+                return {};
+            if ( isDir )
+                return QString( "/" );
+
+            auto suffix = info.suffix().toLower();
+#ifdef Q_OS_WINDOWS
+            if ( ( suffix == "exe" ) || ( suffix == "lnk" ) || ( suffix == "ico" ) )   // per file icons
+                return {};
+#endif
+            return suffix;
+        }
+
         QIcon CIconProvider::icon( const QFileInfo &info ) const
+        {
+            return icon( info, info.isDir() );
+        }
+
+        QString CIconProvider::type( const QFileInfo &info ) const
+        {
+            return type( info, info.isDir() );
+        }
+
+        QIcon CIconProvider::icon( const QFileInfo &info, bool isDir ) const
         {
             if ( NSABUtils::NFileUtils::isIPAddressNetworkPath( info ) )
                 return {};
-            return QFileIconProvider::icon( info );
+
+            auto key = cacheKey( info, isDir );
+            if ( !key.has_value() )
+                return QFileIconProvider::icon( info );
+
+            auto pos = fIconCache.find( key.value() );
+            if ( pos == fIconCache.end() )
+                pos = fIconCache.insert( { key.value(), QFileIconProvider::icon( info ) } ).first;
+            return ( *pos ).second;
+        }
+
+        QString CIconProvider::type( const QFileInfo &info, bool isDir ) const
+        {
+            auto key = cacheKey( info, isDir );
+            if ( !key.has_value() )
+                return QFileIconProvider::type( info );
+
+            auto pos = fTypeCache.find( key.value() );
+            if ( pos == fTypeCache.end() )
+                pos = fTypeCache.insert( { key.value(), QFileIconProvider::type( info ) } ).first;
+            return ( *pos ).second;
         }
 
         QStringList CDirModel::getMediaHeaders() const
@@ -2348,52 +3567,125 @@ namespace NMediaManager
         void CDirModel::processLog( const QString &string, NSABUtils::CDoubleProgressDlg *progressDlg )
         {
             auto newProgress = getCurrentProgress( string );
-            if ( newProgress.has_value() )
+            if ( fLogSlot && ( fLogSlot != primaryProcessSlot() ) )   // the other running jobs only log
+                return;
+
+            auto slot = fLogSlot ? fLogSlot : primaryProcessSlot();
+            if ( slot && slot->fProgress )   // progress comes from processFFmpegProgress, not the log
+                return;
+
+            if ( !newProgress.has_value() )
             {
-                if ( newProgress.value().second.has_value() )
-                {
-                    progressDlg->setSecondaryMaximum( newProgress.value().second.value() );
-                }
-                progressDlg->setSecondaryValue( newProgress.value().first );
+                progressDlg->setSecondaryFormat( getSecondaryProgressFormat( progressDlg ) );
+                return;
             }
+            updateSecondaryProgress( progressDlg, newProgress.value(), [ this, &string ]( const std::pair< uint64_t, std::optional< uint64_t > > &currProgress ) { return getMSRemaining( string, currProgress ); }, {} );
+        }
 
-            auto format = getSecondaryProgressFormat( progressDlg );
+        void CDirModel::processFFmpegProgress( SProcessSlot *slot )
+        {
+            auto primary = primaryProcessSlot();
+            if ( !progressDlg() || !primary || !slot->fInfo )
+                return;
+
+            auto &&group = slot->fInfo->fSegmentedProgress;
+            if ( group && ( primary->fInfo->fSegmentedProgress == group ) )
+            {
+                processSegmentedProgress( group );
+                return;
+            }
+
+            if ( slot != primary )
+                return;
 
-            if ( newProgress.has_value() )
+            auto &&progress = slot->fProgress->progress();
+            auto seconds = progress.outSeconds();
+            if ( !seconds.has_value() )
+                return;
+
+            auto msRemaining = [ &progress ]( const std::pair< uint64_t, std::optional< uint64_t > > &currProgress ) -> std::optional< std::chrono::milliseconds >
+            {
+                if ( !currProgress.second.has_value() || !progress.fSpeed.has_value() || ( progress.fSpeed.value() <= 0.0 ) || !progress.fOutTimeUS.has_value() )
+                    return {};
+                auto remainingUS = static_cast< double >( currProgress.second.value() ) * 1000000.0 - static_cast< double >( progress.fOutTimeUS.value() );
+                return std::chrono::milliseconds( static_cast< uint64_t >( std::round( std::max( 0.0, remainingUS ) / 1000.0 / progress.fSpeed.value() ) ) );
+            };
+            updateSecondaryProgress( progressDlg(), { seconds.value(), {} }, msRemaining, progress.summary() );
+        }
+
+        void CDirModel::processSegmentedProgress( const std::shared_ptr< SSegmentedProgress > &group )
+        {
+            // position is the encoded time over every segment, the speeds add up since the segments run side by side
+            auto doneUS = static_cast< double >( group->fCompletedUS );
+            double speed = 0.0;
+            int numRunning = 0;
+            for ( auto &&ii : fProcessSlots )
             {
-                if ( !newProgress.value().second.has_value() )
-                    newProgress.value().second = progressDlg->secondaryMax();
+                if ( !ii->fInfo || ( ii->fInfo->fSegmentedProgress != group ) || !ii->fProgress )
+                    continue;
+                auto &&progress = ii->fProgress->progress();
+                if ( progress.fOutTimeUS.has_value() )
+                    doneUS += static_cast< double >( progress.fOutTimeUS.value() );
+                if ( progress.fSpeed.has_value() )
+                    speed += progress.fSpeed.value();
+                numRunning++;
+            }
 
-                auto msecsRemaining = this->getMSRemaining( string, newProgress.value() );
-                if ( !msecsRemaining.has_value() )
+            auto msRemaining = [ doneUS, speed ]( const std::pair< uint64_t, std::optional< uint64_t > > &currProgress ) -> std::optional< std::chrono::milliseconds >
+            {
+                if ( !currProgress.second.has_value() || ( speed <= 0.0 ) )
+                    return {};
+                auto remainingUS = static_cast< double >( currProgress.second.value() ) * 1000000.0 - doneUS;
+                return std::chrono::milliseconds( static_cast< uint64_t >( std::round( std::max( 0.0, remainingUS ) / 1000.0 / speed ) ) );
+            };
+            auto details = tr( "%1 segments %2x" ).arg( numRunning ).arg( speed, 0, 'f', 2 );
+            updateSecondaryProgress( progressDlg(), { static_cast< uint64_t >( doneUS / 1000000.0 ), {} }, msRemaining, details );
+        }
+
+        void CDirModel::updateSecondaryProgress( NSABUtils::CDoubleProgressDlg *progressDlg, std::pair< uint64_t, std::optional< uint64_t > > newProgress, const std::function< std::optional< std::chrono::milliseconds >( const std::pair< uint64_t, std::optional< uint64_t > > & ) > &msRemaining, const QString &details )
+        {
+            if ( newProgress.second.has_value() )
+            {
+                progressDlg->setSecondaryMaximum( newProgress.second.value() );
+            }
+            progressDlg->setSecondaryValue( newProgress.first );
+
+            auto format = getSecondaryProgressFormat( progressDlg );
+
+            if ( !newProgress.second.has_value() )
+                newProgress.second = progressDlg->secondaryMax();
+
+            auto msecsRemaining = msRemaining( newProgress );
+            if ( !msecsRemaining.has_value() )
+            {
+                if ( fLastProgress.has_value() )
                 {
-                    if ( fLastProgress.has_value() )
-                    {
-                        auto msecs = fLastProgress.value().first.msecsTo( QDateTime::currentDateTime() );
-                        auto numSteps = newProgress.value().first - fLastProgress.value().second;
-                        auto msecsPerStep = static_cast< double >( msecs ) / static_cast< double >( numSteps );
-                        auto remainingMsecs = static_cast< uint64_t >( msecsPerStep * ( newProgress.value().second.value() - newProgress.value().first ) );
+                    auto msecs = fLastProgress.value().first.msecsTo( QDateTime::currentDateTime() );
+                    auto numSteps = newProgress.first - fLastProgress.value().second;
+                    auto msecsPerStep = static_cast< double >( msecs ) / static_cast< double >( numSteps );
+                    auto remainingMsecs = static_cast< uint64_t >( msecsPerStep * ( newProgress.second.value() - newProgress.first ) );
 
-                        msecsRemaining = std::chrono::milliseconds( remainingMsecs );
-                    }
-                    fLastProgress = std::make_pair( QDateTime::currentDateTime(), newProgress.value().first );
+                    msecsRemaining = std::chrono::milliseconds( remainingMsecs );
                 }
+                fLastProgress = std::make_pair( QDateTime::currentDateTime(), newProgress.first );
+            }
 
-                if ( msecsRemaining.has_value() )
+            if ( msecsRemaining.has_value() )
+            {
+                auto ts = NSABUtils::CTimeString( msecsRemaining.value() );
+                if ( this->currentUnitsAreSeconds() )
                 {
-                    auto ts = NSABUtils::CTimeString( msecsRemaining.value() );
-                    if ( this->currentUnitsAreSeconds() )
-                    {
-                        auto currTS = NSABUtils::CTimeString( progressDlg->secondaryValue() * 1000 );
-                        auto endTS = NSABUtils::CTimeString( progressDlg->secondaryMax() * 1000 );
-                        format = QString( "Processing Position: %1 of %2 ETA: %3  " ).arg( currTS.toString( "hh:mm:ss", false ) ).arg( endTS.toString( "hh:mm:ss", false ) ).arg( ts.toString( "hh:mm:ss", false ) );
-                    }
-                    else
-                    {
-                        format = format + ts.toString( " ETA: hh:mm:ss  ", false );
-                    }
+                    auto currTS = NSABUtils::CTimeString( progressDlg->secondaryValue() * 1000 );
+                    auto endTS = NSABUtils::CTimeString( progressDlg->secondaryMax() * 1000 );
+                    format = QString( "Processing Position: %1 of %2 ETA: %3  " ).arg( currTS.toString( "hh:mm:ss", false ) ).arg( endTS.toString( "hh:mm:ss", false ) ).arg( ts.toString( "hh:mm:ss", false ) );
+                }
+                else
+                {
+                    format = format + ts.toString( " ETA: hh:mm:ss  ", false );
                 }
             }
+            if ( !details.isEmpty() )
+                format += details + "  ";
             progressDlg->setSecondaryFormat( format );
         }
     }
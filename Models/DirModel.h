@@ -24,6 +24,9 @@
 #define _DIRMODEL_H
 
 #include "DirNodeItem.h"
+#include "DirScanner.h"
+#include "FFmpegProgress.h"
+#include "ProcessLog.h"
 
 #include <QStandardItemModel>
 class QTemporaryDir;
@@ -31,17 +34,24 @@ class QTemporaryDir;
 #include "SABUtils/QtHashUtils.h"
 #include <unordered_set>
 #include <unordered_map>
+#include <set>
+#include <list>
+#include <vector>
+#include <memory>
 #include <optional>
 #include <QProcess>   // qprocess enums
 #include <QMessageBox>   // needed for icon type
 #include <QDialogButtonBox>   // StandardButtons
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QPointer>
 #include <QDir>
 #include <QDate>
 #include <functional>
 #include <optional>
 #include <QMutex>
 #include <QFileIconProvider>
+#include <QThreadPool>
 #include <functional>
 
 namespace NSABUtils
@@ -57,6 +67,7 @@ class QMediaPlaylist;
 class QDirIterator;
 class QPlainTextEdit;
 class QProcess;
+class QFileSystemWatcher;
 class QFileInfo;
 class QDir;
 
@@ -80,6 +91,7 @@ namespace NMediaManager
     namespace NModels
     {
         class CDirModel;
+        class CSidecarIndex;
 
         enum ECustomRoles
         {
@@ -124,7 +136,8 @@ namespace NMediaManager
         struct STreeNode
         {
             STreeNode() {}
-            STreeNode( const QFileInfo &file, const CDirModel *model, bool isRoot );
+            STreeNode( const QFileInfo &file, const CDirModel *model, bool isRoot, const SDirScanStat *stat = nullptr );   // with a stat the file system columns dont touch the disk
+            STreeNode( const QFileInfo &file, const CDirModel *model, QStandardItem *existingItem );   // already loaded row
 
             ~STreeNode() {}
 
@@ -149,33 +162,109 @@ namespace NMediaManager
 
         using TParentTree = std::list< STreeNode >;
 
+        // how a queued external process loads the machine, the scheduler packs jobs against the thread and per disk budgets
+        enum class EProcessResourceClass
+        {
+            eCPU,   // encoders, bounded by the thread budget
+            eMixed,   // decode heavy but seek bound, e.g. thumbnail extraction
+            eDisk   // streams the whole file, e.g. mkvalidator
+        };
+
+        struct SJournalJob;
+        // shared by the jobs that encode one source as segments, so they report as one job
+        struct SSegmentedProgress
+        {
+            int64_t fCompletedUS{ 0 };   // encoded time of the finished segments
+            int fPending{ 0 };   // jobs of the group queued or running
+            bool fFailed{ false };
+        };
+
         struct SProcessInfo
         {
             SProcessInfo() {}
             void cleanup( CDirModel *model, bool aOK );
             QString primaryNewName() const;
+            void setThreads( int numThreads );   // updates the ffmpeg -threads values when fArgs carry them
+            QStandardItem *itemFor( const QString &newName ) const;   // the item of the variant that owns the output, fItem when not combined
+            std::list< QStandardItem * > items() const;   // every variant's item, just fItem when not combined
 
             bool fBackupOrig{ true };
             bool fSetMetainfoTagsOnSuccess{ false };
             bool fForceUnbuffered{ false };
+            EProcessResourceClass fResourceClass{ EProcessResourceClass::eDisk };
+            int fMinThreads{ 1 };   // estimated cost, the job waits until this many threads are free
+            int fMaxThreads{ 1 };   // the most threads the job can use
             QString fCmd;
             QStringList fArgs;
             QStandardItem *fItem{ nullptr };
+            std::list< std::pair< QStandardItem *, QStringList > > fOutputItems;   // set on a combined run, the item and outputs of each variant
             QString fOldName;
             QStringList fAncillary;
             QStringList fNewNames;
             int fMaximum{ 0 };
             QString fProgressLabel;
+            quint64 fJournalID{ 0 };   // 0 until the job is written to the process journal
+            QString fPostProcessType;   // names fPostProcess so a resumed job can restore it
+            bool fIntermediate{ false };   // one step of a larger job, does not count as a finished job
+            bool fOutputsComplete{ false };   // resumed after a crash during the cleanup, the process itself is not rerun
+            std::shared_ptr< SSegmentedProgress > fSegmentedProgress;
 
             std::function< bool( const SProcessInfo *processInfo, QString &msg ) > fPostProcess;
             std::shared_ptr< QTemporaryDir > fTempDir;
             std::unordered_map< QFileDevice::FileTime, QDateTime > fTimeStamps;
+
+            std::shared_ptr< QTemporaryDir > fStagingDir;   // set while the outputs are written to the scratch disk
+            std::list< std::pair< QString, QString > > fStagedNames;   // final name, scratch name
+            std::list< std::pair< QString, QString > > fStagedMoveErrors;   // final name, message, the outputs that could not be moved off the scratch disk
+            qint64 fStagedBytes{ 0 };   // scratch space reserved for the outputs
+        };
+
+        // one concurrent external process, with its own partial line buffers for the log
+        struct SProcessSlot
+        {
+            QProcess *fProcess{ nullptr };
+            std::shared_ptr< SProcessInfo > fInfo;   // empty when the slot is idle
+            uint64_t fStartOrder{ 0 };
+            int fThreads{ 0 };
+            QString fDevice;
+            std::pair< QString, bool > fStdOutRemaining{ QString(), false };
+            std::pair< QString, bool > fStdErrRemaining{ QString(), false };
+            std::unique_ptr< CFFmpegProgressParser > fProgress;   // set when the job reports through -progress pipe:1
+            std::unique_ptr< CProcessLogBuffer > fLog;
+        };
+
+        // thread and disk usage over one run of the process queue, logged when the queue drains
+        struct SProcessUtilization
+        {
+            void start( int threadBudget, int processesPerDisk );
+            void update( int threadsInUse, const std::unordered_map< QString, int > &processesPerDevice );
+            QString report() const;
+
+            QElapsedTimer fTimer;
+            qint64 fLastUpdate{ 0 };
+            int fThreadBudget{ 0 };
+            int fProcessesPerDisk{ 0 };
+            int fThreadsInUse{ 0 };
+            int fPeakThreads{ 0 };
+            double fThreadMSecs{ 0.0 };
+            int fNumJobs{ 0 };
+            std::unordered_map< QString, int > fPeakPerDevice;
         };
 
         class CIconProvider : public QFileIconProvider
         {
         public:
             virtual QIcon icon( const QFileInfo &info ) const override;
+            virtual QString type( const QFileInfo &info ) const override;
+            QIcon icon( const QFileInfo &info, bool isDir ) const;
+            QString type( const QFileInfo &info, bool isDir ) const;
+
+        private:
+            std::optional< QString > cacheKey( const QFileInfo &info, bool isDir ) const;
+
+            // one shared icon and type name per suffix, rather than one per row
+            mutable std::unordered_map< QString, QIcon > fIconCache;
+            mutable std::unordered_map< QString, QString > fTypeCache;
         };
 
         using TItemStatus = std::pair< NPreferences::EItemStatus, QString >;
@@ -208,6 +297,7 @@ namespace NMediaManager
             bool process( const QModelIndex &idx, const std::function< void( int count, int eventsPerPath ) > &startProgress, const std::function< void( bool finalStep, bool canceled ) > &endProgress, QWidget *parent );
 
             virtual QStringList dirModelFilter() const = 0;
+            virtual QStringList sidecarFilter() const { return QStringList(); }   // files only looked up next to the media, recorded by the scan instead of shown
 
             void reloadModel();
             void setRootPath( const QString &path );
@@ -266,6 +356,20 @@ namespace NMediaManager
             virtual void processLog( const QString &string, NSABUtils::CDoubleProgressDlg *progressDlg ) final;
 
             virtual bool currentUnitsAreSeconds() const { return false; }
+
+            void queueLiveUpdate( const QString &dirPath );
+
+            QString internString( const QString &value ) const;   // repeated cell text (codecs, resolutions, types) shares one buffer, the set is emptied with the model
+            static bool isRepeatedTag( NSABUtils::EMediaTags tag );   // the low cardinality media columns worth interning
+            bool mediaTagsEditable() const;
+
+            virtual bool hasChildren( const QModelIndex &parent = QModelIndex() ) const override;
+            virtual bool canFetchMore( const QModelIndex &parent ) const override;
+            virtual void fetchMore( const QModelIndex &parent ) override;
+            void fetchAll();   // loads every directory not yet expanded, for operations on the whole tree
+            bool reloadNeededAfterProcessing() const;
+            void resumeProcesses( const std::list< SJournalJob > &jobs );   // requeues jobs left unfinished by the last session
+            static void removeOrphanedStagingDirs();   // Staging-* dirs on the scratch disk left by a crash, only safe while no job is running
         Q_SIGNALS:
             void sigDirLoadFinished( bool canceled );
             void sigProcessesFinished( bool status, bool showProcessResults, bool cancelled, bool reloadModel );
@@ -276,21 +380,20 @@ namespace NMediaManager
             void slotLoadRootDirectory();
 
             void slotRunNextProcessInQueue();
-            void slotProcessErrorOccured( QProcess::ProcessError error );
-            void slotProcessFinished( int exitCode, QProcess::ExitStatus exitStatus );
-            void slotProcessStandardError();
-            void slotProcessStandardOutput();
-
-            void slotProcessStarted();
-            void slotProcesssStateChanged( QProcess::ProcessState newState );
             void slotProgressCanceled();
             virtual void slotDataChanged( const QModelIndex &start, const QModelIndex &end, const QVector< int > &roles );
             virtual void slotUpdateMediaInfo( const QString &path );
+            void slotDirectoryChanged( const QString &dirPath );
+            void slotFileChanged( const QString &filePath );
+            void slotApplyLiveUpdates();
+            void slotUpdateViewportPriority();
+            void slotFlushProcessLogs();
 
         protected:
             virtual QString getSecondaryProgressFormat( NSABUtils::CDoubleProgressDlg *progressDlg ) const;
             virtual std::optional< std::pair< uint64_t, std::optional< uint64_t > > > getCurrentProgress( const QString & /*string*/ ) { return {}; }
             virtual std::optional< std::chrono::milliseconds > getMSRemaining( const QString & /*string*/, const std::pair< uint64_t, std::optional< uint64_t > > & /*currProgress*/ ) const { return {}; }
+            void updateSecondaryProgress( NSABUtils::CDoubleProgressDlg *progressDlg, std::pair< uint64_t, std::optional< uint64_t > > newProgress, const std::function< std::optional< std::chrono::milliseconds >( const std::pair< uint64_t, std::optional< uint64_t > > & ) > &msRemaining, const QString &details );
 
             std::shared_ptr< NSABUtils::CMediaInfo > getMediaInfo( const QFileInfo &fi, bool force = false ) const;
             std::shared_ptr< NSABUtils::CMediaInfo > getMediaInfo( const QModelIndex &idx, bool force = false ) const;
@@ -379,6 +482,7 @@ namespace NMediaManager
             virtual int computeNumberOfItems() const final;
             virtual std::pair< std::function< bool( const QVariant & ) >, int > getExcludeFuncForItemCount() const;
 
+            virtual void preProcess( const QStandardItem * /*item*/, bool /*displayOnly*/ ){};
             virtual void postProcess( bool /*displayOnly*/ );
             virtual bool postExtProcess( const SProcessInfo *processInfo, QStringList &msgList );
             virtual QString getProgressLabel( std::shared_ptr< SProcessInfo > processInfo ) const;
@@ -397,24 +501,59 @@ namespace NMediaManager
             virtual QString getMyTransformedName( const QStandardItem *item, bool parentsOnly ) const;
             virtual QString computeMergedPath( const QString &parentDir, const QString &myName ) const;
 
-            void processFinished( const QString &msg, bool withError );
+            virtual int maxConcurrentProcesses() const { return 1; }   // external processes run at once, per source file they still run in queue order
+            virtual bool restoreProcess( std::shared_ptr< SProcessInfo > /*processInfo*/, const SJournalJob & /*job*/ ) { return true; }   // rebuilds what the journal can not store, false drops the job
+            bool processesRunning() const;
+            void queueProcess( std::shared_ptr< SProcessInfo > processInfo );
+            void clearProcessQueue();   // the pending jobs are journaled as not run
+
+            SProcessSlot *freeProcessSlot();
+            QString storageDevice( const QString &path ) const;
+            QString scratchDir( const QString &finalPath, qint64 bytesNeeded );   // empty when files for finalPath should not go to the scratch disk
+            std::shared_ptr< QTemporaryDir > createTempDir( const QString &sourceFile, qint64 bytesNeeded );   // on the scratch disk when possible, otherwise next to the source
+            void stageOutputs( const std::shared_ptr< SProcessInfo > &processInfo );   // points the outputs in the args at the scratch disk
+            static bool moveStagedFile( const QString &from, const QString &to, QString &msg );   // an existing file at to is only replaced once the copy is complete
+            void moveStagedOutputs( const std::shared_ptr< SProcessInfo > &processInfo );   // in the staging pool, the job finishes once they are moved
+            void stagedOutputsMoved( const std::shared_ptr< SProcessInfo > &processInfo, const std::list< std::pair< QString, QString > > &errors );
+            void finishProcess( const std::shared_ptr< SProcessInfo > &processInfo, bool aOK );   // cleanup and journal, after the process and any staged move
+            void updateProcessUtilization();
+            void startProcess( SProcessSlot *slot );
+            SProcessSlot *primaryProcessSlot() const;   // the oldest running job, it drives the progress dialog
+            std::shared_ptr< SProcessInfo > currentProcessInfo() const;
+            void updateProcessProgressLabel();
+
+            void processErrorOccured( SProcessSlot *slot, QProcess::ProcessError error );
+            void processFinished( SProcessSlot *slot, int exitCode, QProcess::ExitStatus exitStatus );
+            void processStandardError( SProcessSlot *slot );
+            void processStandardOutput( SProcessSlot *slot );
+            void processFFmpegProgress( SProcessSlot *slot );
+            void processSegmentedProgress( const std::shared_ptr< SSegmentedProgress > &group );
+            void segmentedJobFinished( const std::shared_ptr< SProcessInfo > &processInfo, SProcessSlot *slot, bool aOK );
+            void flushProcessLog( SProcessSlot *slot );
+            void processFinished( SProcessSlot *slot, const QString &msg, bool withError );
 
             void appendRow( QStandardItem *parent, QList< QStandardItem * > &items );
             static void appendError( QStandardItem *parent, const QString &errorMsg );
 
-            struct SIterateInfo
-            {
-                std::function< bool( const QFileInfo &dir ) > fPreDirFunction;
-                std::function< void( const QFileInfo &dir, bool aOK ) > fPostDirFunction;
-                std::function< bool( const QFileInfo &dir ) > fPreFileFunction;
-                std::function< void( const QFileInfo &dir, bool aOK ) > fPostFileFunction;
-            };
-
-            void iterateEveryFile( const QFileInfo &fileInfo, const SIterateInfo &iterInfo, std::optional< QDateTime > &lastUpdateUI, bool countOnly ) const;
-            std::pair< uint64_t, uint64_t > computeNumberOfFiles( const QFileInfo &fileInfo );
-            void loadFileInfo( const QFileInfo &info );
-
-            std::unique_ptr< QDirIterator > getDirIteratorForPath( const QFileInfo &fileInfo ) const;
+            void startDirScan( const QFileInfo &rootInfo );
+            void stopDirScan();
+            QByteArray dirScanIndexKey() const;   // changes when the skipped/ignored path preferences do
+            CSidecarIndex *sidecarIndex() const;   // filled by the current scan
+            void slotDirScanBatchReady( uint64_t generation, std::shared_ptr< TDirScanBatch > batch, int filesFound, bool finished );
+            void loadDirStart( const SDirScanEntry &entry );
+            void loadDirEnd( const SDirScanEntry &entry );
+            void loadFile( const SDirScanEntry &entry );
+
+            void watchDir( const QString &dirPath );
+            void watchFile( const QString &filePath );   // an in place rewrite does not change the directory, inotify only reports it on the file
+            void unwatchFiles();
+            void liveUpdateDir( const QString &dirPath );
+            void liveAddPath( const QFileInfo &fileInfo );
+            void liveScan( const QFileInfo &fileInfo );
+            TParentTree liveUpdateParentTree( const QString &dirPath );
+            void removePathItem( const QString &path );
+            void fetchDirectory( const QString &dirPath );
+            bool isUnfetched( const QModelIndex &parent ) const;
 
             QStandardItem *attachTreeNodes( TParentTree &parentTree );   // returns the root item (col 0) of the leaf node
 
@@ -422,6 +561,7 @@ namespace NMediaManager
             bool isSkippedPathName( const QFileInfo &ii, bool allowIgnore = true ) const;
 
             STreeNode getItemRow( const QFileInfo &path ) const;
+            STreeNode getItemRow( const SDirScanEntry &entry ) const;
 
             virtual QString getDispName( const QString &absPath ) const;
             virtual QString getDispName( const QFileInfo &fi ) const final;
@@ -445,7 +585,7 @@ namespace NMediaManager
 
             void updateParentCheckState( QStandardItem *item ) const;
 
-            void addProcessError( const QString &msg );
+            void addProcessError( const std::shared_ptr< SProcessInfo > &processInfo, const QString &msg );
 
         protected:
             QDir fRootPath;
@@ -455,16 +595,45 @@ namespace NMediaManager
             std::map< QString, QStandardItem * > fPathMapping;
 
             QTimer *fReloadTimer{ nullptr };
+            std::unique_ptr< CDirScanner > fDirScanner;
+            uint64_t fDirScanGeneration{ 0 };
+            TParentTree fDirScanTree;
+            std::unordered_set< QString > fDirScanAlreadyAdded;
+            int fDirScanSkipDepth{ 0 };
+            mutable std::shared_ptr< CSidecarIndex > fSidecarIndex;
+
+            QFileSystemWatcher *fFileSystemWatcher{ nullptr };
+            QTimer *fLiveUpdateTimer{ nullptr };
+            std::set< QString > fPendingLiveUpdates;
+            QElapsedTimer fFirstPendingLiveUpdate;
+            std::set< QString > fScannedPaths;
+            bool fLiveUpdatesAvailable{ true };
+            bool fWatchFiles{ true };   // cleared when the watches run out, the directories are still watched
+            std::unordered_set< QString > fWatchedFiles;
+            bool fLoadOnDemand{ false };
+            std::set< QString > fUnfetchedDirs;
+            mutable std::unordered_set< QString > fInternedStrings;
+            mutable std::optional< bool > fMediaTagsEditable;
+            QTimer *fViewportTimer{ nullptr };
+            QTimer *fLogFlushTimer{ nullptr };   // process output reaches the UI at this rate
+            QPointer< QTreeView > fViewportView;
             NUi::CBasePage *fBasePage{ nullptr };
-            QProcess *fProcess{ nullptr };
+            std::vector< std::unique_ptr< SProcessSlot > > fProcessSlots;
+            SProcessSlot *fLogSlot{ nullptr };   // the slot whose output is being logged
+            uint64_t fNextProcessStartOrder{ 0 };
+            std::optional< uint64_t > fPrimaryStartOrder;
+            SProcessUtilization fProcessUtilization;
+            mutable std::unordered_map< QString, QString > fStorageDevices;   // dir to device
+            qint64 fScratchBytesReserved{ 0 };   // by the jobs staged on the scratch disk that have not finished
+            std::list< std::shared_ptr< SProcessInfo > > fMovingStagedOutputs;   // finished jobs whose outputs are still being moved off the scratch disk
+            QThreadPool fStagingPool;
+            bool fProcessesActive{ false };
             std::pair< bool, std::shared_ptr< QStandardItemModel > > fProcessResults;
 
             mutable std::list< std::shared_ptr< SProcessInfo > > fProcessQueue;
             std::pair< QString, bool > fStdOutRemaining{ QString(), false };
             std::pair< QString, bool > fStdErrRemaining{ QString(), false };
 
-            bool fProcessFinishedHandled{ false };
-            mutable bool fFirstProcess{ true };
             mutable bool fIsLoading{ false };
 
             std::unordered_map< QString, QStringList > fMessagesForFiles;
@@ -49,7 +49,7 @@ namespace NMediaManager
             fRoles.emplace_back( value, role );
         }
 
-        QStandardItem *SDirNodeItem::createStandardItem() const
+        QStandardItem *SDirNodeItem::createStandardItem( bool mediaTagsEditable ) const
         {
             QStandardItem *retVal = nullptr;
             if ( !fEditable.has_value() )
@@ -64,14 +64,14 @@ namespace NMediaManager
                 if ( fEditable.value().first == EType::eMediaTag )
                 {
                     retVal->setData( static_cast< int >( fEditable.value().second ), NModels::ECustomRoles::eMediaTagTypeRole );
-                    auto mkvPropEdit = NPreferences::NCore::CPreferences::instance()->getMKVPropEditEXE();
-                    if ( mkvPropEdit.isEmpty() )
-                        editable = false;
+                    editable = mediaTagsEditable;
                 }
                 retVal->setEditable( editable );
             }
 
-            retVal->setIcon( fIcon );
+            // only store the roles that differ from the defaults, every one costs a QVariant per cell
+            if ( !fIcon.isNull() )
+                retVal->setIcon( fIcon );
             if ( fAlignment.has_value() )
                 retVal->setTextAlignment( fAlignment.value() );
             for ( auto &&ii : fRoles )
@@ -81,7 +81,8 @@ namespace NMediaManager
             if ( fCheckable.has_value() )
             {
                 retVal->setCheckable( fCheckable.value().fIsCheckable );
-                retVal->setData( fCheckable.value().fYesNoOnly, NModels::ECustomRoles::eYesNoCheckableOnly );
+                if ( fCheckable.value().fYesNoOnly )
+                    retVal->setData( true, NModels::ECustomRoles::eYesNoCheckableOnly );
                 retVal->setCheckState( fCheckable.value().fCheckState );
             }
             return retVal;
@@ -74,7 +74,7 @@ namespace NMediaManager
 
             void setData( const QVariant &value, int role );
 
-            QStandardItem *createStandardItem() const;
+            QStandardItem *createStandardItem( bool mediaTagsEditable ) const;
 
             QString fText;
             EColumns fType{ EColumns::eFSName };
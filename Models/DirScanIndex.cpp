@@ -0,0 +1,180 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DirScanIndex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+
+#include <tuple>
+
+#ifdef Q_OS_UNIX
+    #include <sys/stat.h>
+#endif
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        const quint32 CDirScanIndex::sMagic = 0x4d4d5349;   // MMSI
+        const quint32 CDirScanIndex::sVersion = 2;
+
+        CDirScanIndex::CDirScanIndex( const QString &rootPath, const QStringList &nameFilters, const QByteArray &prefsKey ) :
+            fRootPath( QDir( rootPath ).absolutePath() ),
+            fNameFilters( nameFilters ),
+            fPrefsKey( prefsKey ),
+            fScanStart( QDateTime::currentDateTimeUtc() )
+        {
+        }
+
+        QString CDirScanIndex::indexDir()
+        {
+            auto appDataDir = QDir( QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) );
+            auto retVal = appDataDir.absoluteFilePath( "ScanIndex" );
+            if ( !QDir( retVal ).exists() )
+                QDir( retVal ).mkpath( "." );
+            return retVal;
+        }
+
+        QString CDirScanIndex::fileName() const
+        {
+            // one index per root and name filter, so the pages with different filters dont invalidate each other
+            auto key = fRootPath + "|" + fNameFilters.join( ";" );
+            auto hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Md5 ).toHex();
+            return QDir( indexDir() ).absoluteFilePath( QString::fromLatin1( hash ) + ".idx" );
+        }
+
+        bool CDirScanIndex::load()
+        {
+            fPrevDirs.clear();
+
+            QFile file( fileName() );
+            if ( !file.open( QFile::ReadOnly ) )
+                return false;
+
+            QDataStream ds( &file );
+            ds.setVersion( QDataStream::Qt_5_12 );
+
+            quint32 magic = 0;
+            quint32 version = 0;
+            ds >> magic >> version;
+            if ( ( magic != sMagic ) || ( version != sVersion ) )
+                return false;
+
+            QString rootPath;
+            QByteArray prefsKey;
+            ds >> rootPath >> prefsKey >> fPrevScanStart;
+            if ( ( rootPath != fRootPath ) || ( prefsKey != fPrefsKey ) )   // skipped/ignored paths changed, start over
+                return false;
+
+            quint32 numDirs = 0;
+            ds >> numDirs;
+            for ( quint32 ii = 0; ( ii < numDirs ) && ( ds.status() == QDataStream::Ok ); ++ii )
+            {
+                QString path;
+                SDir dir;
+                quint32 numEntries = 0;
+                ds >> path >> dir.fModified >> dir.fInode >> numEntries;
+                dir.fEntries.reserve( numEntries );
+                for ( quint32 jj = 0; ( jj < numEntries ) && ( ds.status() == QDataStream::Ok ); ++jj )
+                {
+                    SEntry entry;
+                    ds >> entry.fName >> entry.fStat.fIsDir >> entry.fStat.fSize >> entry.fStat.fModified;
+                    dir.fEntries.push_back( std::move( entry ) );
+                }
+                fPrevDirs[ path ] = std::move( dir );
+            }
+
+            if ( ds.status() != QDataStream::Ok )
+            {
+                fPrevDirs.clear();
+                return false;
+            }
+            return true;
+        }
+
+        bool CDirScanIndex::save()
+        {
+            QSaveFile file( fileName() );
+            if ( !file.open( QFile::WriteOnly ) )
+                return false;
+
+            QDataStream ds( &file );
+            ds.setVersion( QDataStream::Qt_5_12 );
+
+            QMutexLocker locker( &fMutex );
+            ds << sMagic << sVersion << fRootPath << fPrefsKey << fScanStart;
+            ds << static_cast< quint32 >( fDirs.size() );
+            for ( auto &&ii : fDirs )
+            {
+                ds << ii.first << ii.second.fModified << ii.second.fInode << static_cast< quint32 >( ii.second.fEntries.size() );
+                for ( auto &&jj : ii.second.fEntries )
+                    ds << jj.fName << jj.fStat.fIsDir << jj.fStat.fSize << jj.fStat.fModified;
+            }
+            if ( ds.status() != QDataStream::Ok )
+            {
+                file.cancelWriting();
+                return false;
+            }
+            return file.commit();
+        }
+
+        const CDirScanIndex::SDir *CDirScanIndex::findUnchanged( const QFileInfo &dirInfo, qint64 &modified, quint64 &inode ) const
+        {
+            std::tie( modified, inode ) = dirStamp( dirInfo );
+
+            auto pos = fPrevDirs.find( dirInfo.absoluteFilePath() );
+            if ( pos == fPrevDirs.end() )
+                return nullptr;
+
+            if ( ( ( *pos ).second.fModified != modified ) || ( ( *pos ).second.fInode != inode ) )
+                return nullptr;
+
+            // file systems with coarse mtimes can change a directory in the same tick the previous scan read it
+            if ( !fPrevScanStart.isValid() || ( modified >= ( fPrevScanStart.toMSecsSinceEpoch() - 2000 ) ) )
+                return nullptr;
+            return &( *pos ).second;
+        }
+
+        void CDirScanIndex::insert( const QString &path, SDir &&dir )
+        {
+            QMutexLocker locker( &fMutex );
+            fDirs[ path ] = std::move( dir );
+        }
+
+        std::pair< qint64, quint64 > CDirScanIndex::dirStamp( const QFileInfo &dirInfo )
+        {
+            quint64 inode = 0;
+#ifdef Q_OS_UNIX
+            struct stat statBuf;
+            if ( ::stat( QFile::encodeName( dirInfo.absoluteFilePath() ).constData(), &statBuf ) == 0 )
+                inode = static_cast< quint64 >( statBuf.st_ino );
+#endif
+            return { dirInfo.lastModified().toMSecsSinceEpoch(), inode };
+        }
+    }
+}
@@ -0,0 +1,91 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _DIRSCANINDEX_H
+#define _DIRSCANINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDateTime>
+#include <QMutex>
+
+#include <unordered_map>
+#include <vector>
+#include "DirScanner.h"
+#include "SABUtils/QtHashUtils.h"
+
+class QFileInfo;
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        // persistent per root directory index of directory listings
+        // a directory whose mtime and inode match the index is not re-read on the next load, only its entries are stat'ed again
+        class CDirScanIndex
+        {
+        public:
+            struct SEntry
+            {
+                QString fName;
+                SDirScanStat fStat;   // as of the listing, refreshed when an unchanged directory is replayed
+            };
+
+            struct SDir
+            {
+                qint64 fModified{ 0 };   // msecs since epoch
+                quint64 fInode{ 0 };
+                std::vector< SEntry > fEntries;
+            };
+
+            CDirScanIndex( const QString &rootPath, const QStringList &nameFilters, const QByteArray &prefsKey );
+
+            bool load();
+            bool save();
+
+            // returns nullptr if the directory is not in the index or has changed since it was indexed
+            const SDir *findUnchanged( const QFileInfo &dirInfo, qint64 &modified, quint64 &inode ) const;
+            void insert( const QString &path, SDir &&dir );   // thread safe
+
+            static std::pair< qint64, quint64 > dirStamp( const QFileInfo &dirInfo );
+            static QString indexDir();
+
+        private:
+            QString fileName() const;
+
+            QString fRootPath;
+            QStringList fNameFilters;
+            QByteArray fPrefsKey;
+            QDateTime fPrevScanStart;
+            QDateTime fScanStart;
+
+            std::unordered_map< QString, SDir > fPrevDirs;
+            std::unordered_map< QString, SDir > fDirs;
+            QMutex fMutex;
+
+            static const quint32 sMagic;
+            static const quint32 sVersion;
+        };
+    }
+}
+#endif
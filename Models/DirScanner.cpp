@@ -0,0 +1,252 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DirScanner.h"
+#include "DirScanIndex.h"
+#include "SidecarIndex.h"
+
+#include <QDirIterator>
+
+#include <algorithm>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        int CDirScanner::sBatchSize = 512;
+        int CDirScanner::sBatchIntervalMS = 100;
+
+        CDirScanner::CDirScanner( const QFileInfo &rootInfo, const QStringList &nameFilters, TIsSkippedFunc isSkipped, TBatchReadyFunc batchReady, int numThreads, std::shared_ptr< CDirScanIndex > index, std::shared_ptr< CSidecarIndex > sidecars, QObject *parent ) :
+            QThread( parent ),
+            fRootInfo( rootInfo ),
+            fIsSkipped( isSkipped ),
+            fBatchReady( batchReady ),
+            fIndex( index ),
+            fSidecars( sidecars ),
+            fListFilters( nameFilters )
+        {
+            if ( fSidecars && !fSidecars->empty() && !nameFilters.isEmpty() )
+            {
+                fListFilters << fSidecars->nameFilters();
+                fNameMatchers = CSidecarIndex::matchers( nameFilters );
+            }
+            fPool.setMaxThreadCount( std::max( 1, numThreads ) );
+        }
+
+        CDirScanner::~CDirScanner()
+        {
+            cancel();
+            wait();
+            fPool.clear();
+            fPool.waitForDone();
+        }
+
+        void CDirScanner::cancel()
+        {
+            QMutexLocker locker( &fMutex );
+            fCanceled = true;
+            fListingReady.wakeAll();
+        }
+
+        void CDirScanner::run()
+        {
+            fCurrBatch = std::make_shared< TDirScanBatch >();
+            fLastFlush.start();
+
+            fRootInfo.refresh();
+            if ( fIndex )
+                fIndex->load();
+
+            if ( fRootInfo.isDir() )
+            {
+                emitDir( queueDir( fRootInfo, {} ) );
+                if ( fIndex && !isCanceled() )
+                    fIndex->save();
+            }
+            else if ( fRootInfo.isFile() )
+            {
+                SDirScanEntry file;
+                file.fType = SDirScanEntry::EType::eFile;
+                file.fFileInfo = fRootInfo;
+                file.fSkipped = fIsSkipped && fIsSkipped( fRootInfo );
+                if ( !file.fSkipped )
+                    fFilesFound++;
+                addEntry( std::move( file ) );
+            }
+
+            flush( true );
+        }
+
+        std::shared_ptr< CDirScanner::SDirListing > CDirScanner::queueDir( const QFileInfo &dirInfo, const std::optional< SDirScanStat > &stat )
+        {
+            auto retVal = std::make_shared< SDirListing >();
+            retVal->fDirInfo = dirInfo;
+            retVal->fStat = stat;
+            retVal->fSkipped = fIsSkipped && fIsSkipped( dirInfo );
+            if ( retVal->fSkipped )
+                retVal->fReady = true;
+            else
+                fPool.start( [ this, retVal ]() { listDir( retVal ); } );
+            return retVal;
+        }
+
+        void CDirScanner::listDir( std::shared_ptr< SDirListing > listing )
+        {
+            std::list< SListingEntry > entries;
+            QStringList fileNames;
+            QStringList subDirs;
+            auto addListingEntry = [ this, &entries, &fileNames, &subDirs ]( const QFileInfo &fileInfo, const SDirScanStat &stat )
+            {
+                auto isDir = stat.fIsDir;
+                if ( fSidecars )
+                    ( isDir ? subDirs : fileNames ) << fileInfo.fileName();
+                if ( !isDir && !fNameMatchers.empty() && !CSidecarIndex::matches( fNameMatchers, fileInfo.fileName() ) )
+                    return;   // only listed for the sidecar index
+
+                SListingEntry entry;
+                entry.fFileInfo = fileInfo;
+                entry.fStat = stat;
+                if ( isDir )
+                    entry.fDir = queueDir( entry.fFileInfo, stat );
+                else
+                {
+                    entry.fSkipped = fIsSkipped && fIsSkipped( entry.fFileInfo );
+                    if ( !entry.fSkipped )
+                        fFilesFound++;
+                }
+                entries.push_back( std::move( entry ) );
+            };
+
+            if ( !isCanceled() )
+            {
+                CDirScanIndex::SDir indexDir;
+                auto dirPath = listing->fDirInfo.absoluteFilePath();
+                auto unchanged = fIndex ? fIndex->findUnchanged( listing->fDirInfo, indexDir.fModified, indexDir.fInode ) : nullptr;
+                if ( unchanged )
+                {
+                    // same directory contents as the last load, no need to read it again
+                    // each entry is still stat'ed, a file rewritten in place does not change the directory's mtime
+                    QDir dir( dirPath );
+                    for ( auto &&ii : unchanged->fEntries )
+                    {
+                        if ( isCanceled() )
+                            break;
+                        QFileInfo fileInfo( dir, ii.fName );
+                        auto stat = ii.fStat;
+                        stat.fIsDir = fileInfo.isDir();
+                        if ( !stat.fIsDir && !fileInfo.isFile() )
+                            continue;   // removed since, the directory mtime will catch up on the next load
+                        stat.fSize = stat.fIsDir ? 0 : fileInfo.size();
+                        stat.fModified = fileInfo.lastModified().toMSecsSinceEpoch();
+                        addListingEntry( fileInfo, stat );
+                        indexDir.fEntries.push_back( { ii.fName, stat } );
+                    }
+                }
+                else
+                {
+                    QDirIterator ii( dirPath, fListFilters, QDir::AllDirs | QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable );
+                    while ( ii.hasNext() && !isCanceled() )
+                    {
+                        ii.next();
+                        auto fileInfo = ii.fileInfo();
+                        SDirScanStat stat;
+                        stat.fIsDir = fileInfo.isDir();   // stats the entry here, not on the GUI thread
+                        if ( !stat.fIsDir && !fileInfo.isFile() )
+                            continue;
+                        stat.fSize = stat.fIsDir ? 0 : fileInfo.size();
+                        stat.fModified = fileInfo.lastModified().toMSecsSinceEpoch();
+                        addListingEntry( fileInfo, stat );
+                        if ( fIndex )
+                            indexDir.fEntries.push_back( { fileInfo.fileName(), stat } );
+                    }
+                }
+                if ( fIndex && !isCanceled() )
+                    fIndex->insert( dirPath, std::move( indexDir ) );
+                if ( fSidecars && !isCanceled() )
+                    fSidecars->insert( dirPath, fileNames, subDirs );
+            }
+
+            QMutexLocker locker( &fMutex );
+            listing->fEntries = std::move( entries );
+            listing->fReady = true;
+            fListingReady.wakeAll();
+        }
+
+        void CDirScanner::emitDir( std::shared_ptr< SDirListing > listing )
+        {
+            {
+                QMutexLocker locker( &fMutex );
+                while ( !listing->fReady && !isCanceled() )
+                    fListingReady.wait( &fMutex, sBatchIntervalMS );
+            }
+            if ( isCanceled() )
+                return;
+
+            SDirScanEntry dirStart;
+            dirStart.fType = SDirScanEntry::EType::eDirStart;
+            dirStart.fFileInfo = listing->fDirInfo;
+            dirStart.fSkipped = listing->fSkipped;
+            dirStart.fStat = listing->fStat;
+            addEntry( std::move( dirStart ) );
+
+            auto entries = std::move( listing->fEntries );   // release as we go, the pool may be well ahead of us
+            for ( auto &&ii : entries )
+            {
+                if ( isCanceled() )
+                    return;
+
+                if ( ii.fDir )
+                    emitDir( ii.fDir );
+                else
+                {
+                    SDirScanEntry file;
+                    file.fType = SDirScanEntry::EType::eFile;
+                    file.fFileInfo = ii.fFileInfo;
+                    file.fSkipped = ii.fSkipped;
+                    file.fStat = ii.fStat;
+                    addEntry( std::move( file ) );
+                }
+                ii.fDir.reset();
+            }
+
+            SDirScanEntry dirEnd;
+            dirEnd.fType = SDirScanEntry::EType::eDirEnd;
+            dirEnd.fFileInfo = listing->fDirInfo;
+            addEntry( std::move( dirEnd ) );
+        }
+
+        void CDirScanner::addEntry( SDirScanEntry &&entry )
+        {
+            fCurrBatch->push_back( std::move( entry ) );
+            if ( ( static_cast< int >( fCurrBatch->size() ) >= sBatchSize ) || ( fLastFlush.elapsed() >= sBatchIntervalMS ) )
+                flush( false );
+        }
+
+        void CDirScanner::flush( bool finished )
+        {
+            if ( fBatchReady && ( finished || !fCurrBatch->empty() ) )
+                fBatchReady( fCurrBatch, fFilesFound, finished );
+            fCurrBatch = std::make_shared< TDirScanBatch >();
+            fLastFlush.restart();
+        }
+    }
+}
@@ -0,0 +1,143 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _DIRSCANNER_H
+#define _DIRSCANNER_H
+
+#include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFileInfo>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        class CDirScanIndex;
+        class CSidecarIndex;
+
+        // what the row needs from a stat, read on the scanner's threads, also for the entries of a directory replayed from the scan index
+        struct SDirScanStat
+        {
+            bool fIsDir{ false };
+            qint64 fSize{ 0 };
+            qint64 fModified{ 0 };   // msecs since epoch
+        };
+
+        struct SDirScanEntry
+        {
+            enum class EType
+            {
+                eDirStart,
+                eDirEnd,
+                eFile
+            };
+
+            EType fType{ EType::eFile };
+            QFileInfo fFileInfo;
+            bool fSkipped{ false };
+            std::optional< SDirScanStat > fStat;   // unset for entries that did not come from the scanner
+        };
+
+        using TDirScanBatch = std::vector< SDirScanEntry >;
+
+        // walks the directory tree on a worker thread, delivering plain file system data in batches
+        // the directories themselves are read by a pool of threads, so many readdir/stat calls are outstanding at once on network and RAID storage
+        // the results are delivered depth first in directory order, regardless of the order the pool finishes them
+        // the batch function is called from the worker thread, the receiver is responsible for getting back to the GUI thread
+        // each batch carries the running total of non-skipped files listed so far, the pool is ahead of the batches so it only ever grows past what has been delivered
+        // files matching the sidecar index filters are recorded there from the same listing, and only delivered when they also match the name filters
+        class CDirScanner : public QThread
+        {
+        public:
+            using TIsSkippedFunc = std::function< bool( const QFileInfo &fileInfo ) >;
+            using TBatchReadyFunc = std::function< void( std::shared_ptr< TDirScanBatch > batch, int filesFound, bool finished ) >;
+
+            CDirScanner( const QFileInfo &rootInfo, const QStringList &nameFilters, TIsSkippedFunc isSkipped, TBatchReadyFunc batchReady, int numThreads, std::shared_ptr< CDirScanIndex > index, std::shared_ptr< CSidecarIndex > sidecars, QObject *parent = nullptr );
+            virtual ~CDirScanner() override;
+
+            void cancel();
+            bool isCanceled() const { return fCanceled; }
+
+            static int sBatchSize;
+            static int sBatchIntervalMS;
+
+        protected:
+            virtual void run() override;
+
+        private:
+            struct SDirListing;
+            struct SListingEntry
+            {
+                QFileInfo fFileInfo;
+                SDirScanStat fStat;
+                bool fSkipped{ false };
+                std::shared_ptr< SDirListing > fDir;   // set for sub-directories
+            };
+
+            struct SDirListing
+            {
+                QFileInfo fDirInfo;
+                std::optional< SDirScanStat > fStat;   // unset for the root
+                bool fSkipped{ false };
+                bool fReady{ false };
+                std::list< SListingEntry > fEntries;
+            };
+
+            std::shared_ptr< SDirListing > queueDir( const QFileInfo &dirInfo, const std::optional< SDirScanStat > &stat );
+            void listDir( std::shared_ptr< SDirListing > listing );   // runs in the pool
+            void emitDir( std::shared_ptr< SDirListing > listing );   // runs in the scanner thread, waits on the pool as needed
+
+            void addEntry( SDirScanEntry &&entry );
+            void flush( bool finished );
+
+            QFileInfo fRootInfo;
+            TIsSkippedFunc fIsSkipped;
+            TBatchReadyFunc fBatchReady;
+            std::shared_ptr< CDirScanIndex > fIndex;
+            std::shared_ptr< CSidecarIndex > fSidecars;
+            QStringList fListFilters;   // name filters plus the sidecar filters
+            std::vector< QRegularExpression > fNameMatchers;
+
+            QThreadPool fPool;
+            QMutex fMutex;
+            QWaitCondition fListingReady;
+
+            std::shared_ptr< TDirScanBatch > fCurrBatch;
+            QElapsedTimer fLastFlush;
+            std::atomic< bool > fCanceled{ false };
+            std::atomic< int > fFilesFound{ 0 };
+        };
+    }
+}
+#endif
@@ -0,0 +1,142 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FFmpegProgress.h"
+
+#include <QLocale>
+#include <QString>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        std::optional< uint64_t > SFFmpegProgress::outSeconds() const
+        {
+            if ( !fOutTimeUS.has_value() || ( fOutTimeUS.value() < 0 ) )
+                return {};
+            return static_cast< uint64_t >( fOutTimeUS.value() / 1000000 );
+        }
+
+        QString SFFmpegProgress::summary() const
+        {
+            QStringList retVal;
+            if ( fFPS.has_value() && ( fFPS.value() > 0.0 ) )
+                retVal << QString( "%1 fps" ).arg( fFPS.value(), 0, 'f', 1 );
+            if ( fSpeed.has_value() )
+                retVal << QString( "%1x" ).arg( fSpeed.value(), 0, 'f', 2 );
+            if ( fBitrateKbps.has_value() )
+                retVal << QString( "%1 kbit/s" ).arg( QLocale().toString( static_cast< qlonglong >( fBitrateKbps.value() ) ) );
+            return retVal.join( " " );
+        }
+
+        bool CFFmpegProgressParser::usesProgressPipe( const QStringList &args )
+        {
+            auto pos = args.indexOf( "-progress" );
+            return ( pos != -1 ) && ( ( pos + 1 ) < args.count() ) && ( args[ pos + 1 ] == "pipe:1" );
+        }
+
+        QStringList CFFmpegProgressParser::progressPipeArgs()
+        {
+            return QStringList() << "-nostats"   // no human readable status line on stderr
+                                 << "-progress"
+                                 << "pipe:1"   // key=value blocks on stdout
+                ;
+        }
+
+        bool CFFmpegProgressParser::addData( const QByteArray &data )
+        {
+            fBlockCompleted = false;
+            fRemaining += data;
+
+            int start = 0;
+            for ( auto pos = fRemaining.indexOf( '\n', start ); pos != -1; pos = fRemaining.indexOf( '\n', start ) )
+            {
+                processLine( fRemaining.mid( start, pos - start ) );
+                start = pos + 1;
+            }
+            fRemaining.remove( 0, start );
+            return fBlockCompleted;
+        }
+
+        void CFFmpegProgressParser::processLine( const QByteArray &origLine )
+        {
+            auto line = origLine.trimmed();
+            auto equalPos = line.indexOf( '=' );
+            if ( equalPos <= 0 )
+                return;
+
+            auto key = line.left( equalPos );
+            auto value = line.mid( equalPos + 1 ).trimmed();
+            if ( value == "N/A" )
+                return;
+
+            bool aOK = false;
+            if ( key == "frame" )
+            {
+                auto curr = value.toULongLong( &aOK );
+                if ( aOK )
+                    fPending.fFrame = curr;
+            }
+            else if ( key == "fps" )
+            {
+                auto curr = value.toDouble( &aOK );
+                if ( aOK )
+                    fPending.fFPS = curr;
+            }
+            else if ( key == "bitrate" )   // 1234.5kbits/s
+            {
+                if ( value.endsWith( "kbits/s" ) )
+                    value.chop( 7 );
+                auto curr = value.toDouble( &aOK );
+                if ( aOK )
+                    fPending.fBitrateKbps = curr;
+            }
+            else if ( key == "total_size" )
+            {
+                auto curr = value.toULongLong( &aOK );
+                if ( aOK )
+                    fPending.fTotalSize = curr;
+            }
+            else if ( ( key == "out_time_us" ) || ( key == "out_time_ms" ) )   // out_time_ms is also microseconds
+            {
+                auto curr = value.toLongLong( &aOK );
+                if ( aOK )
+                    fPending.fOutTimeUS = curr;
+            }
+            else if ( key == "speed" )   // 1.23x
+            {
+                if ( value.endsWith( 'x' ) )
+                    value.chop( 1 );
+                auto curr = value.toDouble( &aOK );
+                if ( aOK )
+                    fPending.fSpeed = curr;
+            }
+            else if ( key == "progress" )
+            {
+                fPending.fEnded = ( value == "end" );
+                fLast = fPending;
+                fPending = SFFmpegProgress();
+                fBlockCompleted = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _FFMPEGPROGRESS_H
+#define _FFMPEGPROGRESS_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <optional>
+#include <cstdint>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        // one block of "ffmpeg -progress pipe:1 -nostats" output, fields ffmpeg reports as N/A are left unset
+        struct SFFmpegProgress
+        {
+            std::optional< uint64_t > fFrame;
+            std::optional< double > fFPS;
+            std::optional< double > fBitrateKbps;
+            std::optional< uint64_t > fTotalSize;
+            std::optional< int64_t > fOutTimeUS;
+            std::optional< double > fSpeed;
+            bool fEnded{ false };
+
+            std::optional< uint64_t > outSeconds() const;
+            QString summary() const;   // e.g. "48.2 fps 2.01x 3,456 kbit/s"
+        };
+
+        // streaming key=value parser, chunks may split lines anywhere
+        // a block ends with progress=continue or progress=end
+        class CFFmpegProgressParser
+        {
+        public:
+            static bool usesProgressPipe( const QStringList &args );
+            static QStringList progressPipeArgs();   // global options, they go before the first -i
+
+            bool addData( const QByteArray &data );   // true when at least one block completed
+            const SFFmpegProgress &progress() const { return fLast; }
+
+        private:
+            void processLine( const QByteArray &line );
+
+            QByteArray fRemaining;
+            SFFmpegProgress fPending;
+            SFFmpegProgress fLast;
+            bool fBlockCompleted{ false };
+        };
+    }
+}
+#endif
@@ -22,6 +22,10 @@
 
 #include "GenerateBIFModel.h"
 #include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/BIFPlanner.h"
+#include "ProcessJournal.h"
+#include "SidecarIndex.h"
+#include "FFmpegProgress.h"
 #include "SABUtils/FileUtils.h"
 #include "SABUtils/BackupFile.h"
 #include "SABUtils/DoubleProgressDlg.h"
@@ -33,6 +37,8 @@
 #include <QTimer>
 #include <QDebug>
 #include <QTemporaryDir>
+#include <QThread>
+#include <QEventLoop>
 
 #ifndef NDEBUG
     #define DEBUG_TEMP_DIR
@@ -56,6 +62,12 @@ namespace NMediaManager
             return QStringList() << "*.mkv";
         }
 
+        QStringList CGenerateBIFModel::sidecarFilter() const
+        {
+            return QStringList() << "*.bif"
+                                 << "*.gif";
+        }
+
         std::pair< bool, std::list< QStandardItem * > > CGenerateBIFModel::processItem( const QStandardItem *item, bool displayOnly )
         {
             if ( item->data( ECustomRoles::eIsDir ).toBool() )
@@ -65,7 +77,8 @@ namespace NMediaManager
             processInfo->fSetMetainfoTagsOnSuccess = false;
             processInfo->fOldName = item->data( ECustomRoles::eAbsFilePath ).toString();
             auto fi = QFileInfo( processInfo->fOldName );
-            auto sz = NPreferences::NCore::CPreferences::instance()->getThumbnailSize( fi );
+            auto source = NPreferences::NCore::CBIFPlanner::instance()->source( fi );   // resolved by preProcess
+            auto sz = NPreferences::NCore::CPreferences::instance()->getThumbnailSize( source.fWidth, source.fHeight, source.fAspectRatio );
 
             processInfo->fItem = new QStandardItem( QString( "Generate Thumbnail Videos from '%1'" ).arg( getDispName( processInfo->fOldName ) ) );
             processInfo->fItem->setData( processInfo->fOldName, ECustomRoles::eOldName );
@@ -91,10 +104,9 @@ namespace NMediaManager
 
             bool aOK = true;
             QStandardItem *myItem = nullptr;
-            fFirstProcess = true;
             if ( !displayOnly )
             {
-                processInfo->fMaximum = NSABUtils::CMediaInfo::getNumberOfSeconds( processInfo->fOldName );
+                processInfo->fMaximum = source.fSeconds;
 
                 bool isEmbyEXE = false;
                 processInfo->fCmd = NPreferences::NCore::CPreferences::instance()->getFFMpegEmbyEXE();
@@ -118,28 +130,22 @@ namespace NMediaManager
                 aOK = aOK && checkProcessItemExists( processInfo->fOldName, processInfo->fItem );
                 processInfo->fTimeStamps = NSABUtils::NFileUtils::timeStamps( processInfo->fOldName );
 
-                if ( NPreferences::NCore::CPreferences::instance()->keepTempDir() )
-                {
-                    processInfo->fTempDir = std::make_shared< QTemporaryDir >();
-                    processInfo->fTempDir->setAutoRemove( false );
-                }
-                else
-                {
-                    processInfo->fTempDir = std::make_shared< QTemporaryDir >( QFileInfo( processInfo->fOldName ).absoluteDir().absoluteFilePath( "./TempDir-XXXXXX" ) );
-                    processInfo->fTempDir->setAutoRemove( true );
-                }
+                processInfo->fTempDir = createTempDir( processInfo->fOldName, 0 );   // the frames are small next to the minimum kept free
                 //qDebug() << processInfo->fTempDir->path();
 
                 // eg -f matroska -threads 1 -skip_interval 10 -copyts -i file:"/volume2/video/Movies/Westworld (1973) [tmdbid=2362]/Westworld.mkv" -an -sn -vf "scale=w=320:h=133" -vsync cfr -r 0.1 -f image2 "/var/packages/EmbyServer/var/cache/temp/112d22a09fea457eaea27c4b0c88f790/img_%05d.jpg"
-                processInfo->fArgs = QStringList() << "-hide_banner" << "-f" << "matroska"   // input format
+                processInfo->fArgs = QStringList() << "-hide_banner" << CFFmpegProgressParser::progressPipeArgs() << "-f" << "matroska"   // input format
                     ;
                 auto hwAccel = NPreferences::NCore::CPreferences::instance()->getTranscodeHWAccel();
                 if ( !hwAccel.isEmpty() )
                 {
                     processInfo->fArgs << "-hwaccel" << hwAccel;
                 }
-                processInfo->fArgs << "-threads" << "1"   // num threads
+                processInfo->fArgs << "-threads" << "1"   // num threads, the scheduler raises it when threads are free
                     ;
+                processInfo->fResourceClass = EProcessResourceClass::eMixed;
+                processInfo->fMinThreads = 1;
+                processInfo->fMaxThreads = 2;
                 if ( isEmbyEXE )
                 {
                     processInfo->fArgs << "-skip_interval" << QString::number( NPreferences::NCore::CPreferences::instance()->imageInterval() );   // how often to skip
@@ -154,84 +160,109 @@ namespace NMediaManager
                                   << "-f"
                                   << "image2" << processInfo->fTempDir->filePath( "img_%05d.jpg" );
                 processInfo->fBackupOrig = false;
-                processInfo->fPostProcess = [ this ]( const SProcessInfo * processInfo, QString &msg ) -> bool
+                processInfo->fPostProcessType = "bif";
+                processInfo->fPostProcess = [ this ]( const SProcessInfo *processInfo, QString &msg ) { return generateOutputs( processInfo, msg ); };
+
+                queueProcess( processInfo );
+            }
+            myItem = processInfo->fItem;
+            return std::make_pair( aOK, std::list< QStandardItem * >( { myItem } ) );
+        }
+
+        bool CGenerateBIFModel::generateOutputs( const SProcessInfo *processInfo, QString &msg )
+        {
+            if ( !processInfo )
+                return false;
+
+            progressDlg()->setPrimaryValue( progressDlg()->primaryValue() + 1 );
+            if ( !processInfo || !processInfo->fTempDir )
+            {
+                msg = "Temporary directory not set";
+                return false;
+            }
+            auto dir = QDir( processInfo->fTempDir->path() );
+            if ( !dir.exists() )
+            {
+                msg = "Temporary directory does not exist";
+                return false;
+            }
+
+            bool aOK = true;
+            QString errorMsg;
+            auto allImages = NSABUtils::NFileUtils::findAllFiles( dir, { "img_*.jpg" }, false, true, &errorMsg );
+            if ( !allImages.has_value() || allImages.value().isEmpty() )
+            {
+                msg = QString( "No images exists in dir '%1' of the format 'img_*.jpg' - %2" ).arg( dir.absolutePath() ).arg( errorMsg );
+                return false;
+            }
+
+            if ( NPreferences::NCore::CPreferences::instance()->generateBIF() )
+            {
+                auto bifFile = std::make_shared< NSABUtils::NBIF::CFile >( allImages.value(), NPreferences::NCore::CPreferences::instance()->imageInterval() * 1000, msg );
+                if ( !bifFile->isValid() )
+                    return false;
+                aOK = bifFile->save( processInfo->primaryNewName(), msg );
+            }
+            progressDlg()->setPrimaryValue( progressDlg()->primaryValue() + 1 );
+            if ( aOK && NPreferences::NCore::CPreferences::instance()->generateGIF() )
+            {
+                auto fi = QFileInfo( processInfo->fNewNames.back() );
+                if ( !NSABUtils::NFileUtils::backup( processInfo->fNewNames.back() ) )
                 {
-                    if ( !processInfo )
-                        return false;
+                    CDirModel::appendError( processInfo->fItem, QObject::tr( "%1: FAILED TO BACKUP" ).arg( getDispName( processInfo->fNewNames.back() ) ) );
+                    return false;
+                }
 
-                    progressDlg()->setPrimaryValue( progressDlg()->primaryValue() + 1 );
-                    if ( !processInfo || !processInfo->fTempDir )
+                aOK = NSABUtils::CGIFWriterDlg::saveToGIF(
+                    nullptr, processInfo->fNewNames.back(), allImages.value(), NPreferences::NCore::CPreferences::instance()->gifDitherImage(), NPreferences::NCore::CPreferences::instance()->gifFlipImage(),
+                    NPreferences::NCore::CPreferences::instance()->gifLoopCount(), NPreferences::NCore::CPreferences::instance()->gifDelay(),
+                    [ this, fi, processInfo ]( size_t min, size_t max )
                     {
-                        msg = "Temporary directory not set";
-                        return false;
-                    }
-                    auto dir = QDir( processInfo->fTempDir->path() );
-                    if ( !dir.exists() )
+                        if ( progressDlg() )
+                        {
+                            progressDlg()->setCancelButtonText( tr( "Cancel Generating GIF" ) );
+                            progressDlg()->setLabelText( getProgressLabel( processInfo, false ) );
+                            progressDlg()->setSecondaryProgressLabel( "Current Frame" );
+                            progressDlg()->setSecondaryRange( static_cast< int >( min ), static_cast< int >( max ) );
+                        }
+                    },
+                    [ this ]( size_t value )
                     {
-                        msg = "Temporary directory does not exist";
-                        return false;
-                    }
-
-                    bool aOK = true;
-                    QString errorMsg;
-                    auto allImages = NSABUtils::NFileUtils::findAllFiles( dir, { "img_*.jpg" }, false, true, &errorMsg );
-                    if ( !allImages.has_value() || allImages.value().isEmpty() )
+                        if ( progressDlg() )
+                            progressDlg()->setSecondaryValue( static_cast< int >( value ) );
+                    },
+                    [ this ]() -> bool
                     {
-                        msg = QString( "No images exists in dir '%1' of the format 'img_*.jpg' - %2" ).arg( dir.absolutePath() ).arg( errorMsg );
+                        if ( progressDlg() )
+                            return progressDlg()->wasCanceled();
                         return false;
-                    }
+                    } );
+            }
+            progressDlg()->setPrimaryValue( progressDlg()->primaryValue() + 1 );
+            return aOK;
+        }
 
-                    if ( NPreferences::NCore::CPreferences::instance()->generateBIF() )
-                    {
-                        auto bifFile = std::make_shared< NSABUtils::NBIF::CFile >( allImages.value(), NPreferences::NCore::CPreferences::instance()->imageInterval() * 1000, msg );
-                        if ( !bifFile->isValid() )
-                            return false;
-                        aOK = bifFile->save( processInfo->primaryNewName(), msg );
-                    }
-                    progressDlg()->setPrimaryValue( progressDlg()->primaryValue() + 1 );
-                    if ( aOK && NPreferences::NCore::CPreferences::instance()->generateGIF() )
-                    {
-                        auto fi = QFileInfo( processInfo->fNewNames.back() );
-                        if ( !NSABUtils::NFileUtils::backup( processInfo->fNewNames.back() ) )
-                        {
-                            CDirModel::appendError( processInfo->fItem, QObject::tr( "%1: FAILED TO BACKUP" ).arg( getDispName( processInfo->fNewNames.back() ) ) );
-                            return false;
-                        }
+        bool CGenerateBIFModel::restoreProcess( std::shared_ptr< SProcessInfo > processInfo, const SJournalJob &job )
+        {
+            if ( job.fPostProcessType != "bif" )
+                return false;
 
-                        aOK = NSABUtils::CGIFWriterDlg::saveToGIF(
-                            nullptr, processInfo->fNewNames.back(), allImages.value(), NPreferences::NCore::CPreferences::instance()->gifDitherImage(), NPreferences::NCore::CPreferences::instance()->gifFlipImage(),
-                            NPreferences::NCore::CPreferences::instance()->gifLoopCount(), NPreferences::NCore::CPreferences::instance()->gifDelay(),
-                            [ this, fi, processInfo ]( size_t min, size_t max )
-                            {
-                                if ( progressDlg() )
-                                {
-                                    progressDlg()->setCancelButtonText( tr( "Cancel Generating GIF" ) );
-                                    progressDlg()->setLabelText( getProgressLabel( processInfo, false ) );
-                                    progressDlg()->setSecondaryProgressLabel( "Current Frame" );
-                                    progressDlg()->setSecondaryRange( static_cast< int >( min ), static_cast< int >( max ) );
-                                }
-                            },
-                            [ this ]( size_t value )
-                            {
-                                if ( progressDlg() )
-                                    progressDlg()->setSecondaryValue( static_cast< int >( value ) );
-                            },
-                            [ this ]() -> bool
-                            {
-                                if ( progressDlg() )
-                                    return progressDlg()->wasCanceled();
-                                return false;
-                            } );
-                    }
-                    progressDlg()->setPrimaryValue( progressDlg()->primaryValue() + 1 );
-                    return aOK;
-                };
-
-                fProcessQueue.push_back( processInfo );
-                QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
+            processInfo->fTempDir = createTempDir( processInfo->fOldName, 0 );
+
+            // the images go to a fresh temporary dir, the old one was removed with the partial outputs
+            auto oldImages = QDir( job.fTempDir ).filePath( "img_%05d.jpg" );
+            for ( auto &&ii : processInfo->fArgs )
+            {
+                if ( ii == oldImages )
+                    ii = processInfo->fTempDir->filePath( "img_%05d.jpg" );
             }
-            myItem = processInfo->fItem;
-            return std::make_pair( aOK, std::list< QStandardItem * >( { myItem } ) );
+            processInfo->fPostProcess = [ this ]( const SProcessInfo *processInfo, QString &msg ) { return generateOutputs( processInfo, msg ); };
+            return true;
+        }
+
+        int CGenerateBIFModel::maxConcurrentProcesses() const
+        {
+            return QThread::idealThreadCount();   // the thread and disk budgets decide how many really run
         }
 
         QString CGenerateBIFModel::getProgressLabel( std::shared_ptr< SProcessInfo > processInfo ) const
@@ -263,6 +294,50 @@ namespace NMediaManager
             CDirModel::preLoad( treeView );
         }
 
+        void CGenerateBIFModel::preProcess( const QStandardItem *item, bool displayOnly )
+        {
+            if ( !displayOnly )
+                return;   // the display pass already planned every checked file
+
+            QStringList paths;
+            addCheckedFiles( item, paths );
+
+            auto planner = NPreferences::NCore::CBIFPlanner::instance();
+            if ( !planner->plan( paths ) )
+                return;
+
+            // the probes run in the planner's pool, keep the GUI live until it reports back
+            QEventLoop loop;
+            connect( planner, &NPreferences::NCore::CBIFPlanner::sigPlanned, &loop, &QEventLoop::quit );
+            if ( progressDlg() )
+            {
+                connect( progressDlg(), &NSABUtils::CDoubleProgressDlg::canceled, &loop, [ planner ]() { planner->cancel(); } );
+                connect(
+                    planner, &NPreferences::NCore::CBIFPlanner::sigPlanProgress, &loop,
+                    [ this ]( int resolved, int total )
+                    {
+                        if ( progressDlg() )
+                            progressDlg()->setLabelText( tr( "Reading video information (%1 of %2)" ).arg( resolved ).arg( total ) );
+                    } );
+            }
+            if ( planner->isPlanning() )
+                loop.exec();
+        }
+
+        void CGenerateBIFModel::addCheckedFiles( const QStandardItem *item, QStringList &paths ) const
+        {
+            if ( !item )
+                return;
+            if ( ( item != invisibleRootItem() ) && ( item->checkState() == Qt::CheckState::Unchecked ) )
+                return;
+
+            if ( ( item != invisibleRootItem() ) && !item->data( ECustomRoles::eIsDir ).toBool() )
+                paths << item->data( ECustomRoles::eAbsFilePath ).toString();
+
+            for ( int ii = 0; ii < item->rowCount(); ++ii )
+                addCheckedFiles( item->child( ii ), paths );
+        }
+
         void CGenerateBIFModel::postProcess( bool /*displayOnly*/ )
         {
             if ( progressDlg() )
@@ -278,36 +353,17 @@ namespace NMediaManager
             if ( countOnly )
                 return true;
 
-            auto dir = fileInfo.absoluteDir();
             //qDebug() << fileInfo;
             if ( !fileInfo.exists() || !fileInfo.isFile() )
                 return false;
 
             bool needsBIF = false;
             if ( NPreferences::NCore::CPreferences::instance()->generateBIF() )
-            {
-                auto filter = QFileInfo( NPreferences::NCore::CPreferences::instance()->getImageFileName( fileInfo, "bif" ) ).fileName();
-                auto bifFiles = NSABUtils::NFileUtils::findAllFiles( dir, QStringList() << filter, false, false );
-                needsBIF = !bifFiles.has_value() || ( bifFiles.value().length() != 1 );
-                if ( !needsBIF && !bifFiles.value().empty() )
-                {
-                    auto bifFile = QFileInfo( bifFiles.value().front() );
-                    needsBIF = !bifFile.exists() || !bifFile.isFile();
-                }
-            }
+                needsBIF = !sidecarIndex()->exists( NPreferences::NCore::CPreferences::instance()->getImageFileName( fileInfo, "bif" ) );
 
             bool needsGIF = false;
             if ( NPreferences::NCore::CPreferences::instance()->generateGIF() )
-            {
-                auto filter = QFileInfo( NPreferences::NCore::CPreferences::instance()->getImageFileName( fileInfo, "gif" ) ).fileName();
-                auto gifFiles = NSABUtils::NFileUtils::findAllFiles( dir, QStringList() << filter, false, false );
-                needsGIF = !gifFiles.has_value() || ( gifFiles.value().length() != 1 );
-                if ( !needsGIF && !gifFiles.value().empty() )
-                {
-                    auto gifFile = QFileInfo( gifFiles.value().front() );
-                    needsGIF = !gifFile.exists() || !gifFile.isFile();
-                }
-            }
+                needsGIF = !sidecarIndex()->exists( NPreferences::NCore::CPreferences::instance()->getImageFileName( fileInfo, "gif" ) );
 
             return needsBIF || needsGIF;
         }
@@ -323,30 +379,5 @@ namespace NMediaManager
         void CGenerateBIFModel::attachTreeNodes( QStandardItem * /*nextParent*/, QStandardItem *& /*prevParent*/, const STreeNode & /*treeNode*/ )
         {
         }
-
-        std::optional< std::pair< uint64_t, std::optional< uint64_t > > > CGenerateBIFModel::getCurrentProgress( const QString &string )
-        {
-            // Skip-Option - Write output: pkt_pts_time:2570 pkt_dts_time:2570 input_pts_time:2570.2
-            // time=00:00:00.00
-            auto regEx = QRegularExpression( R"((input_pts_[Tt]ime\:(?<secs1>\d+))|(pkt_pts_[Tt]ime\:(?<secs2>\d+)))" );
-            QRegularExpressionMatch match;
-            auto pos = string.lastIndexOf( regEx, -1, &match );
-            if ( pos == -1 || !match.hasMatch() )
-                return {};
-
-            auto secs = match.captured( "secs1" );
-            if ( secs.isEmpty() )
-                secs = match.captured( "secs2" );
-            int numSeconds = 0;
-            if ( !secs.isEmpty() )
-            {
-                bool aOK;
-                int curr = secs.toInt( &aOK );
-                if ( aOK )
-                    numSeconds = curr;
-            }
-
-            return std::pair< uint64_t, std::optional< uint64_t > >( numSeconds, {} );
-        }
     }
 }
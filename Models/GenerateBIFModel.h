@@ -44,6 +44,7 @@ namespace NMediaManager
 
         private:
             virtual QStringList dirModelFilter() const override;
+            virtual QStringList sidecarFilter() const override;
 
             virtual bool ignoreExtrasOnSearch() const override { return false; }
 
@@ -57,6 +58,7 @@ namespace NMediaManager
 
             virtual void postLoad( QTreeView * /*treeView*/ ) override;
             virtual void preLoad( QTreeView * /*treeView*/ ) override;
+            virtual void preProcess( const QStandardItem *item, bool displayOnly ) override;
             virtual void postProcess( bool /*displayOnly*/ ) override;
 
             virtual void postFileFunction( bool /*aOK*/, const QFileInfo & /*fileInfo*/, TParentTree & /*tree*/, bool /*countOnly*/ ) override;
@@ -66,7 +68,11 @@ namespace NMediaManager
             virtual void attachTreeNodes( QStandardItem * /*nextParent*/, QStandardItem *& /*prevParent*/, const STreeNode & /*treeNode*/ ) override;
 
             virtual bool usesQueuedProcessing() const override { return true; }
-            virtual std::optional< std::pair< uint64_t, std::optional< uint64_t > > > getCurrentProgress( const QString &string ) override;
+            virtual int maxConcurrentProcesses() const override;
+            virtual bool restoreProcess( std::shared_ptr< SProcessInfo > processInfo, const SJournalJob &job ) override;
+            bool generateOutputs( const SProcessInfo *processInfo, QString &msg );
+
+            void addCheckedFiles( const QStandardItem *item, QStringList &paths ) const;
         };
     }
 }
@@ -24,6 +24,7 @@
 #include "Core/TransformResult.h"
 #include "Core/SearchTMDBInfo.h"
 #include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/PreferencesSnapshot.h"
 #include "SABUtils/QtUtils.h"
 #include "SABUtils/FileUtils.h"
 #include "SABUtils/BackupFile.h"
@@ -492,7 +493,7 @@ namespace NMediaManager
         {
             QStandardItem *myItem = nullptr;
             bool aOK = true;
-            bool processItem = !NPreferences::NCore::CPreferences::instance()->getOnlyTransformDirectories() || isDir( item );
+            bool processItem = !NPreferences::NCore::CPreferences::instance()->snapshot()->fOnlyTransformDirectories || isDir( item );
 
             QString oldName;
             QString newName;
@@ -892,7 +893,7 @@ namespace NMediaManager
                 TItemStatus retVal = { NPreferences::EItemStatus::eOK, QString() };
                 if ( idx.model()->index( idx.row(), 0, idx.parent() ).data( Qt::CheckStateRole ).toInt() == Qt::CheckState::Unchecked )
                     return retVal;
-                if ( NPreferences::NCore::CPreferences::instance()->getOnlyTransformDirectories() && !fileInfo.isDir() )
+                if ( NPreferences::NCore::CPreferences::instance()->snapshot()->fOnlyTransformDirectories && !fileInfo.isDir() )
                     return retVal;
 
                 auto searchOK = itemSearchOK( idx, &retVal.second );
@@ -1005,7 +1006,7 @@ namespace NMediaManager
 
         void CMediaNamingModel::postDirFunction( bool aOK, const QFileInfo & /*dirInfo*/, TParentTree &parentTree, bool /*countOnly*/ )
         {
-            if ( !NPreferences::NCore::CPreferences::instance()->getOnlyTransformDirectories() )
+            if ( !NPreferences::NCore::CPreferences::instance()->snapshot()->fOnlyTransformDirectories )
                 return;
 
             if ( !aOK )
@@ -1030,7 +1031,7 @@ namespace NMediaManager
 
         bool CMediaNamingModel::preFileFunction( const QFileInfo &fileInfo, std::unordered_set< QString > &alreadyAdded, TParentTree & /*tree*/, bool /*countOnly*/ )
         {
-            if ( !NPreferences::NCore::CPreferences::instance()->getOnlyTransformDirectories() )
+            if ( !NPreferences::NCore::CPreferences::instance()->snapshot()->fOnlyTransformDirectories )
                 return true;
             if ( isSearchableFile( fileInfo.fileName() ) )
             {
@@ -0,0 +1,310 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ProcessJournal.h"
+#include "DirModel.h"
+
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        static const quint32 sMagic = 0x4D4D504A;   // MMPJ
+        static const quint32 sVersion = 1;
+
+        QDataStream &operator<<( QDataStream &stream, const SJournalJob &job )
+        {
+            stream << job.fPageName << job.fCmd << job.fArgs << job.fOldName << job.fNewNames << job.fAncillary;
+            stream << static_cast< quint32 >( job.fTimeStamps.size() );
+            for ( auto &&ii : job.fTimeStamps )
+                stream << static_cast< qint32 >( ii.first ) << ii.second;
+            stream << job.fBackupOrig << job.fSetMetainfoTagsOnSuccess << job.fForceUnbuffered << job.fPostProcessType << job.fTempDir << static_cast< qint32 >( job.fMaximum ) << job.fProgressLabel;
+            stream << static_cast< qint32 >( job.fResourceClass ) << static_cast< qint32 >( job.fMinThreads ) << static_cast< qint32 >( job.fMaxThreads );
+            return stream;
+        }
+
+        QDataStream &operator>>( QDataStream &stream, SJournalJob &job )
+        {
+            stream >> job.fPageName >> job.fCmd >> job.fArgs >> job.fOldName >> job.fNewNames >> job.fAncillary;
+            quint32 numTimeStamps = 0;
+            stream >> numTimeStamps;
+            for ( quint32 ii = 0; ( ii < numTimeStamps ) && ( stream.status() == QDataStream::Ok ); ++ii )
+            {
+                qint32 type;
+                QDateTime value;
+                stream >> type >> value;
+                job.fTimeStamps[ static_cast< QFileDevice::FileTime >( type ) ] = value;
+            }
+            qint32 maximum, resourceClass, minThreads, maxThreads;
+            stream >> job.fBackupOrig >> job.fSetMetainfoTagsOnSuccess >> job.fForceUnbuffered >> job.fPostProcessType >> job.fTempDir >> maximum >> job.fProgressLabel;
+            stream >> resourceClass >> minThreads >> maxThreads;
+            job.fMaximum = maximum;
+            job.fResourceClass = resourceClass;
+            job.fMinThreads = minThreads;
+            job.fMaxThreads = maxThreads;
+            return stream;
+        }
+
+        CProcessJournal *CProcessJournal::instance()
+        {
+            static CProcessJournal retVal;
+            return &retVal;
+        }
+
+        CProcessJournal::CProcessJournal() :
+            fInstanceLock( lockFileName() )
+        {
+            fInstanceLock.setStaleLockTime( 0 );   // only stale when the PID in it is no longer running
+            fOwner = fInstanceLock.tryLock( 0 );
+            if ( fOwner )
+                load();
+        }
+
+        CProcessJournal::~CProcessJournal()
+        {
+            fFile.close();
+            if ( fOwner )
+                fInstanceLock.unlock();
+        }
+
+        QString CProcessJournal::journalFileName()
+        {
+            auto appDataDir = QDir( QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) );
+            if ( !appDataDir.exists() )
+                appDataDir.mkpath( "." );
+            return appDataDir.absoluteFilePath( "ProcessJournal.dat" );
+        }
+
+        QString CProcessJournal::lockFileName()
+        {
+            return journalFileName() + ".lock";
+        }
+
+        void CProcessJournal::load()
+        {
+            QFile file( journalFileName() );
+            if ( !file.open( QFile::ReadOnly ) )
+                return;
+
+            QDataStream stream( &file );
+            stream.setVersion( QDataStream::Qt_5_12 );
+
+            quint32 magic = 0;
+            quint32 version = 0;
+            stream >> magic >> version;
+            if ( ( magic != sMagic ) || ( version != sVersion ) )
+                return;
+
+            while ( !stream.atEnd() )
+            {
+                quint8 type;
+                quint64 id;
+                stream >> type >> id;
+
+                SJournalJob job;
+                bool aOK = false;
+                if ( static_cast< ERecord >( type ) == ERecord::eQueued )
+                    stream >> job;
+                else if ( static_cast< ERecord >( type ) == ERecord::eFinished )
+                    stream >> aOK;
+                if ( stream.status() != QDataStream::Ok )
+                    break;   // torn write from a crash, everything before it is intact
+
+                fNextID = std::max( fNextID, id + 1 );
+                switch ( static_cast< ERecord >( type ) )
+                {
+                    case ERecord::eQueued:
+                        job.fID = id;
+                        fUnfinished[ id ] = job;
+                        break;
+                    case ERecord::eStarted:
+                        if ( fUnfinished.find( id ) != fUnfinished.end() )
+                            fUnfinished[ id ].fStarted = true;
+                        break;
+                    case ERecord::eFinished:
+                        fUnfinished.erase( id );
+                        break;
+                    case ERecord::eOutputsComplete:
+                        if ( fUnfinished.find( id ) != fUnfinished.end() )
+                            fUnfinished[ id ].fOutputsComplete = true;
+                        break;
+                }
+            }
+            for ( auto &&ii : fUnfinished )
+                fFromLastSession.insert( ii.first );
+        }
+
+        bool CProcessJournal::openForAppend( bool truncate )
+        {
+            if ( fFile.isOpen() && !truncate )
+                return true;
+
+            fFile.close();
+            fFile.setFileName( journalFileName() );
+            auto exists = !truncate && QFileInfo::exists( fFile.fileName() );
+            if ( !fFile.open( exists ? ( QFile::WriteOnly | QFile::Append ) : ( QFile::WriteOnly | QFile::Truncate ) ) )
+                return false;
+            if ( !exists )
+            {
+                QDataStream stream( &fFile );
+                stream.setVersion( QDataStream::Qt_5_12 );
+                stream << sMagic << sVersion;
+                fFile.flush();
+            }
+            return true;
+        }
+
+        void CProcessJournal::append( ERecord type, quint64 id, const SJournalJob *job, bool aOK )
+        {
+            if ( !openForAppend( false ) )
+                return;
+
+            QDataStream stream( &fFile );
+            stream.setVersion( QDataStream::Qt_5_12 );
+            stream << static_cast< quint8 >( type ) << id;
+            if ( job )
+                stream << *job;
+            if ( type == ERecord::eFinished )
+                stream << aOK;
+            fFile.flush();
+        }
+
+        quint64 CProcessJournal::queued( const QString &pageName, const SProcessInfo &processInfo )
+        {
+            if ( !fOwner )
+                return 0;
+
+            SJournalJob job;
+            job.fPageName = pageName;
+            job.fCmd = processInfo.fCmd;
+            job.fArgs = processInfo.fArgs;
+            job.fOldName = processInfo.fOldName;
+            job.fNewNames = processInfo.fNewNames;
+            job.fAncillary = processInfo.fAncillary;
+            job.fTimeStamps = processInfo.fTimeStamps;
+            job.fBackupOrig = processInfo.fBackupOrig;
+            job.fSetMetainfoTagsOnSuccess = processInfo.fSetMetainfoTagsOnSuccess;
+            job.fForceUnbuffered = processInfo.fForceUnbuffered;
+            job.fPostProcessType = processInfo.fPostProcessType;
+            job.fTempDir = processInfo.fTempDir ? processInfo.fTempDir->path() : QString();
+            job.fMaximum = processInfo.fMaximum;
+            job.fProgressLabel = processInfo.fProgressLabel;
+            job.fResourceClass = static_cast< int >( processInfo.fResourceClass );
+            job.fMinThreads = processInfo.fMinThreads;
+            job.fMaxThreads = processInfo.fMaxThreads;
+
+            QMutexLocker locker( &fMutex );
+            job.fID = fNextID++;
+            fUnfinished[ job.fID ] = job;
+            append( ERecord::eQueued, job.fID, &job, true );
+            return job.fID;
+        }
+
+        void CProcessJournal::started( quint64 id )
+        {
+            if ( !id )
+                return;
+
+            QMutexLocker locker( &fMutex );
+            auto pos = fUnfinished.find( id );
+            if ( pos == fUnfinished.end() )
+                return;
+            ( *pos ).second.fStarted = true;
+            append( ERecord::eStarted, id, nullptr, true );
+        }
+
+        void CProcessJournal::outputsComplete( quint64 id )
+        {
+            if ( !id )
+                return;
+
+            QMutexLocker locker( &fMutex );
+            auto pos = fUnfinished.find( id );
+            if ( pos == fUnfinished.end() )
+                return;
+            ( *pos ).second.fOutputsComplete = true;
+            append( ERecord::eOutputsComplete, id, nullptr, true );
+        }
+
+        void CProcessJournal::finished( quint64 id, bool aOK )
+        {
+            if ( !id )
+                return;
+
+            QMutexLocker locker( &fMutex );
+            fUnfinished.erase( id );
+            fFromLastSession.erase( id );
+            append( ERecord::eFinished, id, nullptr, aOK );
+            compactIfIdle();
+        }
+
+        void CProcessJournal::compactIfIdle()
+        {
+            if ( !fUnfinished.empty() )
+                return;
+            openForAppend( true );
+        }
+
+        std::list< SJournalJob > CProcessJournal::unfinishedFromLastSession() const
+        {
+            QMutexLocker locker( &fMutex );
+            std::list< SJournalJob > retVal;
+            for ( auto &&ii : fFromLastSession )
+            {
+                auto pos = fUnfinished.find( ii );
+                if ( pos != fUnfinished.end() )
+                    retVal.push_back( ( *pos ).second );
+            }
+            return retVal;
+        }
+
+        void CProcessJournal::cleanupPartialOutputs( const SJournalJob &job ) const
+        {
+            // the temporary dir is created when the job is queued, only ones made next to the source are removed
+            if ( !job.fTempDir.isEmpty() && QFileInfo( job.fTempDir ).fileName().startsWith( "TempDir-" ) )
+                QDir( job.fTempDir ).removeRecursively();
+
+            if ( !job.fStarted || job.fOutputsComplete )   // complete outputs are kept, resuming only finishes their cleanup
+                return;
+
+            for ( auto &&ii : job.fNewNames )
+            {
+                if ( ( ii != job.fOldName ) && QFileInfo( ii ).isFile() )
+                    QFile::remove( ii );
+                QFile::remove( ii + ".partial" );   // a move from the scratch disk that was cut short
+            }
+        }
+
+        void CProcessJournal::discard( const std::list< SJournalJob > &jobs )
+        {
+            for ( auto &&ii : jobs )
+            {
+                cleanupPartialOutputs( ii );
+                finished( ii.fID, false );
+            }
+        }
+    }
+}
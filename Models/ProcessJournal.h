@@ -0,0 +1,122 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _PROCESSJOURNAL_H
+#define _PROCESSJOURNAL_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QFile>
+#include <QFileDevice>
+#include <QMutex>
+#include <QLockFile>
+
+#include <map>
+#include <set>
+#include <list>
+#include <unordered_map>
+#include "SABUtils/QtHashUtils.h"
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        struct SProcessInfo;
+
+        // what is needed to rerun a queued external process after a crash
+        struct SJournalJob
+        {
+            quint64 fID{ 0 };
+            QString fPageName;
+            QString fCmd;
+            QStringList fArgs;
+            QString fOldName;
+            QStringList fNewNames;
+            QStringList fAncillary;
+            std::unordered_map< QFileDevice::FileTime, QDateTime > fTimeStamps;
+            bool fBackupOrig{ true };
+            bool fSetMetainfoTagsOnSuccess{ false };
+            bool fForceUnbuffered{ false };
+            QString fPostProcessType;
+            QString fTempDir;
+            int fMaximum{ 0 };
+            QString fProgressLabel;
+            int fResourceClass{ 0 };
+            int fMinThreads{ 1 };
+            int fMaxThreads{ 1 };
+            bool fStarted{ false };
+            bool fOutputsComplete{ false };   // the process succeeded and its outputs are in place, only the cleanup was left
+        };
+
+        // write ahead journal of the external process queue
+        // every transition is appended and flushed before it happens, a torn record at the end is ignored on load
+        // the file is truncated whenever no journaled job is left unfinished
+        // only the first running instance owns the journal, it is held by a lock file carrying that instance's PID
+        // a second instance neither reads nor writes it, so it can never resume, remove or truncate the first one's jobs
+        class CProcessJournal
+        {
+            CProcessJournal();
+
+        public:
+            static CProcessJournal *instance();
+            ~CProcessJournal();
+
+            quint64 queued( const QString &pageName, const SProcessInfo &processInfo );
+            void started( quint64 id );
+            void outputsComplete( quint64 id );   // recorded before the backup and rename steps of the cleanup
+            void finished( quint64 id, bool aOK );
+
+            bool isOwner() const { return fOwner; }
+
+            std::list< SJournalJob > unfinishedFromLastSession() const;
+            void cleanupPartialOutputs( const SJournalJob &job ) const;   // removes what a started job left behind
+            void discard( const std::list< SJournalJob > &jobs );
+
+            static QString journalFileName();
+            static QString lockFileName();
+
+        private:
+            enum class ERecord : quint8
+            {
+                eQueued,
+                eStarted,
+                eFinished,
+                eOutputsComplete
+            };
+
+            void load();
+            void append( ERecord type, quint64 id, const SJournalJob *job, bool aOK );
+            void compactIfIdle();
+            bool openForAppend( bool truncate );
+
+            mutable QMutex fMutex;
+            QLockFile fInstanceLock;
+            bool fOwner{ false };
+            QFile fFile;
+            quint64 fNextID{ 1 };
+            std::map< quint64, SJournalJob > fUnfinished;
+            std::set< quint64 > fFromLastSession;
+        };
+    }
+}
+#endif
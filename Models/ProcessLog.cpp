@@ -0,0 +1,135 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ProcessLog.h"
+#include "Preferences/Core/Preferences.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QTextCodec>
+#include <QObject>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        CProcessLogBuffer::CProcessLogBuffer( const QString &jobName, const QString &cmdLine )
+        {
+            auto codec = QTextCodec::codecForName( "UTF-8" );
+            fDecoders[ 0 ].reset( codec->makeDecoder() );
+            fDecoders[ 1 ].reset( codec->makeDecoder() );
+
+            if ( !NPreferences::NCore::CPreferences::instance()->getLoggingEnabled() )
+                return;
+
+            static bool sPruned = false;
+            if ( !sPruned )
+            {
+                sPruned = true;
+                pruneJobLogs();
+            }
+
+            static int sJobNum = 0;
+            auto baseName = QString( "%1-%2-%3.log" ).arg( QDateTime::currentDateTime().toString( "MMddyyyyThhmmss" ) ).arg( ++sJobNum ).arg( QFileInfo( jobName ).completeBaseName() );
+            fFile = std::make_unique< QFile >( QDir( jobLogDir() ).absoluteFilePath( baseName ) );
+            if ( !fFile->open( QFile::WriteOnly | QFile::Truncate | QFile::Text ) )
+            {
+                fFile.reset();
+                return;
+            }
+            fFile->write( ( "Running Command:" + cmdLine + "\n" ).toUtf8() );
+        }
+
+        CProcessLogBuffer::~CProcessLogBuffer()
+        {
+            if ( fFile )
+                fFile->close();
+        }
+
+        QString CProcessLogBuffer::jobLogDir()
+        {
+            auto retVal = QDir( NPreferences::NCore::CPreferences::instance()->getLogDir() ).absoluteFilePath( "Jobs" );
+            if ( !QDir( retVal ).exists() )
+                QDir( retVal ).mkpath( "." );
+            return retVal;
+        }
+
+        void CProcessLogBuffer::pruneJobLogs()
+        {
+            auto cutoff = QDateTime::currentDateTime().addDays( -NPreferences::NCore::CPreferences::instance()->getJobLogRetentionDays() );
+            QDirIterator ii( jobLogDir(), { "*.log" }, QDir::Files );
+            while ( ii.hasNext() )
+            {
+                ii.next();
+                if ( ii.fileInfo().lastModified() < cutoff )
+                    QFile::remove( ii.filePath() );
+            }
+        }
+
+        QString CProcessLogBuffer::fileName() const
+        {
+            return fFile ? fFile->fileName() : QString();
+        }
+
+        QString CProcessLogBuffer::decode( const QByteArray &data, bool stdOut )
+        {
+            return fDecoders[ stdOut ? 1 : 0 ]->toUnicode( data );
+        }
+
+        void CProcessLogBuffer::append( const QString &text, bool stdOut )
+        {
+            if ( fFile )
+                fFile->write( text.toUtf8() );
+
+            auto &&pending = fPending[ stdOut ? 1 : 0 ];
+            pending += text;
+            if ( pending.length() <= kMaxPendingChars )
+                return;
+
+            // keep the newest whole lines, the dropped ones are only in the job log
+            auto cut = pending.length() - kMaxPendingChars;
+            auto lineEnd = pending.indexOf( '\n', cut );
+            cut = ( lineEnd == -1 ) ? cut : ( lineEnd + 1 );
+            fOmittedLines[ stdOut ? 1 : 0 ] += pending.leftRef( cut ).count( '\n' );
+            pending.remove( 0, cut );
+        }
+
+        QString CProcessLogBuffer::takePending( bool stdOut )
+        {
+            auto idx = stdOut ? 1 : 0;
+            QString retVal;
+            if ( fOmittedLines[ idx ] )
+            {
+                if ( fFile )
+                    retVal = QObject::tr( "... %1 lines omitted, see '%2'\n" ).arg( fOmittedLines[ idx ] ).arg( fFile->fileName() );
+                else
+                    retVal = QObject::tr( "... %1 lines omitted\n" ).arg( fOmittedLines[ idx ] );
+                fOmittedLines[ idx ] = 0;
+            }
+            retVal += fPending[ idx ];
+            fPending[ idx ].clear();
+            return retVal;
+        }
+    }
+}
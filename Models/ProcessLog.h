@@ -0,0 +1,62 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _PROCESSLOG_H
+#define _PROCESSLOG_H
+
+#include <QString>
+#include <QFile>
+#include <QTextDecoder>
+#include <memory>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        // the output of one external process
+        // everything is spilled to a per job file in the log dir, the UI only gets a bounded tail at the flush rate
+        class CProcessLogBuffer
+        {
+        public:
+            CProcessLogBuffer( const QString &jobName, const QString &cmdLine );
+            ~CProcessLogBuffer();
+
+            QString decode( const QByteArray &data, bool stdOut );   // keeps multi-byte sequences split across reads intact
+            void append( const QString &text, bool stdOut );
+            bool hasPending() const { return !fPending[ 0 ].isEmpty() || !fPending[ 1 ].isEmpty(); }
+            QString takePending( bool stdOut );   // the text to show, prefixed by a note when lines were dropped
+
+            QString fileName() const;
+
+            static QString jobLogDir();
+            static void pruneJobLogs();   // removes the job logs older than the retention preference
+            static const int kMaxPendingChars{ 64 * 1024 };   // per stream, between two flushes
+
+        private:
+            std::unique_ptr< QFile > fFile;
+            std::unique_ptr< QTextDecoder > fDecoders[ 2 ];
+            QString fPending[ 2 ];
+            int fOmittedLines[ 2 ]{ 0, 0 };
+        };
+    }
+}
+#endif
@@ -0,0 +1,157 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SidecarIndex.h"
+
+#include <QDir>
+#include <QDirIterator>
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        CSidecarIndex::CSidecarIndex( const QStringList &nameFilters ) :
+            fNameFilters( nameFilters ),
+            fMatchers( matchers( nameFilters ) )
+        {
+        }
+
+        CSidecarIndex::TMatchers CSidecarIndex::matchers( const QStringList &nameFilters )
+        {
+            TMatchers retVal;
+            for ( auto &&ii : nameFilters )
+                retVal.emplace_back( QRegularExpression::wildcardToRegularExpression( ii ), QRegularExpression::CaseInsensitiveOption );
+            return retVal;
+        }
+
+        bool CSidecarIndex::matches( const TMatchers &matchers, const QString &fileName )
+        {
+            for ( auto &&ii : matchers )
+            {
+                if ( ii.match( fileName ).hasMatch() )
+                    return true;
+            }
+            return false;
+        }
+
+        void CSidecarIndex::insert( const QString &dirPath, const QStringList &fileNames, const QStringList &subDirs )
+        {
+            SDir dir;
+            for ( auto &&ii : fileNames )
+            {
+                if ( isSidecar( ii ) )
+                    dir.fFiles << ii;
+            }
+            dir.fSubDirs = subDirs;
+
+            QMutexLocker locker( &fMutex );
+            fDirs[ dirPath ] = std::move( dir );
+        }
+
+        void CSidecarIndex::invalidate( const QString &dirPath )
+        {
+            QMutexLocker locker( &fMutex );
+            fDirs.erase( dirPath );
+        }
+
+        void CSidecarIndex::clear()
+        {
+            QMutexLocker locker( &fMutex );
+            fDirs.clear();
+        }
+
+        const CSidecarIndex::SDir &CSidecarIndex::getDir( const QString &dirPath )
+        {
+            auto pos = fDirs.find( dirPath );
+            if ( pos != fDirs.end() )
+                return ( *pos ).second;
+
+            SDir dir;
+            QDirIterator ii( dirPath, QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Readable );
+            while ( ii.hasNext() )
+            {
+                ii.next();
+                auto fileInfo = ii.fileInfo();
+                if ( fileInfo.isDir() )
+                    dir.fSubDirs << fileInfo.fileName();
+                else if ( isSidecar( fileInfo.fileName() ) )
+                    dir.fFiles << fileInfo.fileName();
+            }
+            return fDirs[ dirPath ] = std::move( dir );
+        }
+
+        QList< QFileInfo > CSidecarIndex::files( const QString &dirPath, const QStringList &nameFilters )
+        {
+            auto fileMatchers = matchers( nameFilters );
+
+            QMutexLocker locker( &fMutex );
+            QDir dir( dirPath );
+            QList< QFileInfo > retVal;
+            for ( auto &&ii : getDir( dirPath ).fFiles )
+            {
+                if ( matches( fileMatchers, ii ) )
+                    retVal << QFileInfo( dir, ii );
+            }
+            return retVal;
+        }
+
+        QList< QFileInfo > CSidecarIndex::findAllFiles( const QString &dirPath, const QStringList &nameFilters, TIsSkippedFunc isSkippedDir )
+        {
+            QList< QFileInfo > retVal;
+            QMutexLocker locker( &fMutex );
+            findAllFiles( dirPath, matchers( nameFilters ), isSkippedDir, retVal );
+            return retVal;
+        }
+
+        void CSidecarIndex::findAllFiles( const QString &dirPath, const TMatchers &fileMatchers, TIsSkippedFunc isSkippedDir, QList< QFileInfo > &retVal )
+        {
+            QDir dir( dirPath );
+            auto &&indexDir = getDir( dirPath );
+            for ( auto &&ii : indexDir.fFiles )
+            {
+                if ( matches( fileMatchers, ii ) )
+                    retVal << QFileInfo( dir, ii );
+            }
+
+            for ( auto &&ii : indexDir.fSubDirs )
+            {
+                auto subDir = QFileInfo( dir, ii );
+                if ( isSkippedDir && isSkippedDir( subDir ) )
+                    continue;
+                findAllFiles( subDir.absoluteFilePath(), fileMatchers, isSkippedDir, retVal );
+            }
+        }
+
+        bool CSidecarIndex::exists( const QString &filePath )
+        {
+            QFileInfo fi( filePath );
+            QMutexLocker locker( &fMutex );
+            auto &&indexDir = getDir( fi.absolutePath() );
+            for ( auto &&ii : indexDir.fFiles )
+            {
+                if ( ii.compare( fi.fileName(), Qt::CaseInsensitive ) == 0 )
+                    return true;
+            }
+            return false;
+        }
+    }
+}
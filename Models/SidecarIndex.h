@@ -0,0 +1,85 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _SIDECARINDEX_H
+#define _SIDECARINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QMutex>
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "SABUtils/QtHashUtils.h"
+
+namespace NMediaManager
+{
+    namespace NModels
+    {
+        // per directory index of the files that live next to the media (subtitles, idx/sub pairs, thumbnail videos)
+        // the directory scanner fills it from the listings it already reads, so the models never list a directory again
+        // a directory the scan did not read (load on demand, live updates) is read once on first use
+        class CSidecarIndex
+        {
+        public:
+            using TMatchers = std::vector< QRegularExpression >;
+            using TIsSkippedFunc = std::function< bool( const QFileInfo &dirInfo ) >;
+
+            CSidecarIndex( const QStringList &nameFilters );
+
+            static TMatchers matchers( const QStringList &nameFilters );   // case insensitive, like QDir name filters
+            static bool matches( const TMatchers &matchers, const QString &fileName );
+
+            bool isSidecar( const QString &fileName ) const { return matches( fMatchers, fileName ); }
+            bool empty() const { return fMatchers.empty(); }
+            const QStringList &nameFilters() const { return fNameFilters; }
+
+            // thread safe, only the sidecar files are kept
+            void insert( const QString &dirPath, const QStringList &fileNames, const QStringList &subDirs );
+            void invalidate( const QString &dirPath );
+            void clear();
+
+            QList< QFileInfo > files( const QString &dirPath, const QStringList &nameFilters );
+            QList< QFileInfo > findAllFiles( const QString &dirPath, const QStringList &nameFilters, TIsSkippedFunc isSkippedDir );   // includes sub-directories
+            bool exists( const QString &filePath );
+
+        private:
+            struct SDir
+            {
+                QStringList fFiles;
+                QStringList fSubDirs;
+            };
+
+            const SDir &getDir( const QString &dirPath );   // fMutex must be held
+            void findAllFiles( const QString &dirPath, const TMatchers &matchers, TIsSkippedFunc isSkippedDir, QList< QFileInfo > &retVal );
+
+            QStringList fNameFilters;
+            TMatchers fMatchers;
+            std::unordered_map< QString, SDir > fDirs;
+            QMutex fMutex;
+        };
+    }
+}
+#endif
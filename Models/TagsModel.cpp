@@ -23,6 +23,7 @@
 #include "TagsModel.h"
 #include "Core/SearchTMDBInfo.h"
 #include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/PreferencesSnapshot.h"
 #include "Core/TransformResult.h"
 
 #include "SABUtils/QtUtils.h"
@@ -116,7 +117,7 @@ namespace NMediaManager
 
         std::list< NSABUtils::EMediaTags > CTagsModel::getMediaColumnsList() const
         {
-            return NPreferences::NCore::CPreferences::instance()->getEnabledTags();
+            return NPreferences::NCore::CPreferences::instance()->snapshot()->fEnabledTags;
         }
 
         QStringList CTagsModel::headers() const
@@ -131,7 +132,7 @@ namespace NMediaManager
 
             bool isMediaFile = this->isMediaFile( fileInfo );
 
-            auto tagsToShow = NPreferences::NCore::CPreferences::instance()->getEnabledTags();
+            auto tagsToShow = NPreferences::NCore::CPreferences::instance()->snapshot()->fEnabledTags;
             auto mediaInfo = getMediaTags( fileInfo, tagsToShow );
             int colNum = EColumns::eMediaColumnLoc;
 
@@ -177,7 +178,8 @@ namespace NMediaManager
             if ( isRootPath( idx ) )
                 return {};
 
-            if ( !NPreferences::NCore::CPreferences::instance()->getVerifyMediaTags() )
+            auto prefs = NPreferences::NCore::CPreferences::instance()->snapshot();
+            if ( !prefs->fVerifyMediaTags )
                 return {};
 
             if ( !canShowMediaInfo() )
@@ -196,22 +198,22 @@ namespace NMediaManager
             QString expr;
             if ( idx.column() == getMediaTitleLoc() )
             {
-                validate = NPreferences::NCore::CPreferences::instance()->getVerifyMediaTitle() && !NPreferences::NCore::CPreferences::instance()->getVerifyMediaTitleExpr().isEmpty();
-                expr = NPreferences::NCore::CPreferences::instance()->getVerifyMediaTitleExpr();
+                validate = prefs->fVerifyMediaTitle && !prefs->fVerifyMediaTitleExpr.isEmpty();
+                expr = prefs->fVerifyMediaTitleExpr;
                 regExp = NPreferences::NCore::CPreferences::instance()->getVerifyMediaTitleExpr( fileInfo, mediaDate );
                 tagName = tr( "Title" );
             }
             else if ( idx.column() == getMediaDateLoc() )
             {
-                validate = NPreferences::NCore::CPreferences::instance()->getVerifyMediaDate() && !NPreferences::NCore::CPreferences::instance()->getVerifyMediaDateExpr().isEmpty();
-                expr = NPreferences::NCore::CPreferences::instance()->getVerifyMediaDateExpr();
+                validate = prefs->fVerifyMediaDate && !prefs->fVerifyMediaDateExpr.isEmpty();
+                expr = prefs->fVerifyMediaDateExpr;
                 regExp = NPreferences::NCore::CPreferences::instance()->getVerifyMediaDateExpr( fileInfo, mediaDate );
                 tagName = tr( "Date" );
             }
             else if ( idx.column() == getMediaCommentLoc() )
             {
-                validate = NPreferences::NCore::CPreferences::instance()->getVerifyMediaComment() && !NPreferences::NCore::CPreferences::instance()->getVerifyMediaCommentExpr().isEmpty();
-                expr = NPreferences::NCore::CPreferences::instance()->getVerifyMediaCommentExpr();
+                validate = prefs->fVerifyMediaComment && !prefs->fVerifyMediaCommentExpr.isEmpty();
+                expr = prefs->fVerifyMediaCommentExpr;
                 regExp = NPreferences::NCore::CPreferences::instance()->getVerifyMediaCommentExpr( fileInfo, mediaDate );
                 tagName = tr( "Comment" );
             }
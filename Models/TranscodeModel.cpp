@@ -21,11 +21,18 @@
 // SOFTWARE.
 
 #include "TranscodeModel.h"
+#include "FFmpegProgress.h"
+#include "ProcessJournal.h"
+#include "SidecarIndex.h"
 
 #include "Core/LanguageInfo.h"
 
 #include "Preferences/Core/Preferences.h"
 #include "Preferences/Core/TranscodeNeeded.h"
+#include "Preferences/Core/TranscodePlan.h"
+#include "Preferences/Core/PreferencesSnapshot.h"
+#include "Preferences/Core/ComplianceStore.h"
+#include "Preferences/Core/MediaInfoCache.h"
 #include "SABUtils/FileUtils.h"
 #include "SABUtils/DoubleProgressDlg.h"
 #include "SABUtils/MediaInfo.h"
@@ -35,6 +42,11 @@
 #include <QDir>
 #include <QTimer>
 #include <QDebug>
+#include <QThread>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <cmath>
 
 namespace NMediaManager
 {
@@ -52,7 +64,7 @@ namespace NMediaManager
         void CTranscodeModel::clear()
         {
             CDirModel::clear();
-            fSRTFileCache.clear();
+            fTranscodePlans.clear();
         }
 
         QStringList CTranscodeModel::dirModelFilter() const
@@ -60,54 +72,64 @@ namespace NMediaManager
             return NPreferences::NCore::CPreferences::instance()->getVideoExtensions( QStringList() << "*.nfo" );
         }
 
+        QStringList CTranscodeModel::sidecarFilter() const
+        {
+            return QStringList() << "*.srt"
+                                 << "*.idx"
+                                 << "*.sub";
+        }
+
         std::optional< NMediaManager::NModels::TItemStatus > CTranscodeModel::computeItemStatus( const QModelIndex &idx ) const
         {
             if ( isRootPath( idx ) )
                 return {};
 
-            auto mediaInfo = getMediaInfo( idx );
-            if ( !mediaInfo )
+            auto fileInfo = this->fileInfo( idx );
+            if ( NPreferences::NCore::CComplianceStore::instance()->isCompliant( fileInfo, NPreferences::NCore::CPreferences::instance()->snapshot()->fTranscodeRulesHash ) )
                 return {};
 
-            if ( !mediaInfo->aOK() )
+            auto plan = getTranscodePlan( fileInfo );
+            if ( !plan || !plan->isLoaded() )
                 return {};
 
-            auto transcodeNeeded = NMediaManager::NPreferences::NCore::STranscodeNeeded( mediaInfo );
-            auto fileInfo = this->fileInfo( idx );
-
             if ( idx.column() == 0 )   // filename
             {
-                auto msg = transcodeNeeded.getFormatMessage();
+                auto msg = plan->fFormatMessage;
                 if ( msg.has_value() )
                     return TItemStatus( NPreferences::EItemStatus::eWarning, msg.value() );
             }
             else if ( idx.column() == getMediaVideoCodecLoc() )
             {
-                auto msg = transcodeNeeded.getVideoCodecMessage();
+                auto msg = plan->fVideoCodecMessage;
                 if ( msg.has_value() )
                     return TItemStatus( NPreferences::EItemStatus::eWarning, msg.value() );
             }
             else if ( idx.column() == getMediaOverallBitrateLoc() )
             {
-                auto msg = transcodeNeeded.getBitrateMessage();
+                auto msg = plan->fBitrateMessage;
                 if ( msg.has_value() )
                     return TItemStatus( NPreferences::EItemStatus::eWarning, msg.value() );
             }
             else if ( idx.column() == getMediaResolutionLoc() )
             {
-                auto msg = transcodeNeeded.getVideoResolutionMessage();
+                auto msg = plan->fVideoResolutionMessage;
                 if ( msg.has_value() )
                     return TItemStatus( NPreferences::EItemStatus::eWarning, msg.value() );
             }
             else if ( idx.column() == getMediaAudioCodecLoc() )
             {
-                auto msg = transcodeNeeded.getAudioCodecMessage();
+                auto msg = plan->fAudioCodecMessage;
                 if ( msg.has_value() )
                     return TItemStatus( NPreferences::EItemStatus::eWarning, msg.value() );
             }
             return {};
         }
 
+        int CTranscodeModel::maxConcurrentProcesses() const
+        {
+            return std::max( 1, QThread::idealThreadCount() / 4 );   // each encode needs at least 4 of the budgeted threads
+        }
+
         QString CTranscodeModel::getProgressLabel( std::shared_ptr< SProcessInfo > processInfo ) const
         {
             if ( !processInfo )
@@ -229,9 +251,12 @@ namespace NMediaManager
 
             if ( !retVal )
             {
-                auto mediaInfo = getMediaInfo( fileInfo );
-                auto transcodeNeeded = NPreferences::NCore::STranscodeNeeded( mediaInfo );
-                retVal = !transcodeNeeded.isLoaded() || transcodeNeeded.transcodeNeeded() || transcodeNeeded.bitrateTooHigh() || transcodeNeeded.resolutionTooHigh();
+                auto snapshot = NPreferences::NCore::CPreferences::instance()->snapshot();
+                if ( NPreferences::NCore::CComplianceStore::instance()->isCompliant( fileInfo, snapshot->fTranscodeRulesHash ) )   // no need to probe it again
+                    return snapshot->fShowCompliantFiles;
+
+                auto plan = getTranscodePlan( fileInfo );
+                retVal = !plan || !plan->isLoaded() || plan->workNeeded() || snapshot->fShowCompliantFiles;
             }
             return retVal;
         }
@@ -265,10 +290,10 @@ namespace NMediaManager
         std::pair< bool, std::list< QStandardItem * > > CTranscodeModel::setupProcessItems( TTranscodeProcessInfoMap &processInfos, const QString &path, const std::list< NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NCore::SLanguageInfo, QString > > &subIDXFiles, bool displayOnly ) const
         {
             auto fi = QFileInfo( path );
-            auto mediaInfo = getMediaInfo( fi, true );
-            Q_ASSERT( mediaInfo );
-            auto transcodeNeeded = NPreferences::NCore::STranscodeNeeded( mediaInfo );
-            if ( !transcodeNeeded.transcodeNeeded() && !transcodeNeeded.bitrateTooHigh() && !transcodeNeeded.resolutionTooHigh() && srtFiles.empty() && subIDXFiles.empty() )
+            auto plan = getTranscodePlan( fi, !displayOnly );   // running needs the stream layout, the cached summary is enough to display
+            Q_ASSERT( plan );
+            auto &&transcodeNeeded = plan->fTranscodeNeeded;
+            if ( !plan->workNeeded() && srtFiles.empty() && subIDXFiles.empty() )
                 return { true, std::list< QStandardItem * >() };
 
             if ( transcodeNeeded.bitrateTooHigh() )
@@ -319,11 +344,11 @@ namespace NMediaManager
                 auto newBaseName = fi.completeBaseName();
                 if ( type == ETranscodeType::eHighBitrate )
                 {
-                    auto mediaInfo = getMediaInfo( fi );
-                    if ( !mediaInfo )
+                    auto plan = getTranscodePlan( fi );
+                    if ( !plan )
                         return { false, std::list< QStandardItem * >() };
 
-                    newBaseName += " " + NPreferences::NCore::CPreferences::instance()->getTargetBitrateDisplayString( mediaInfo );
+                    newBaseName += " " + plan->fTargetBitrateDisplay;
                 }
                 else if ( type == ETranscodeType::eHighRes )
                 {
@@ -344,8 +369,13 @@ namespace NMediaManager
 
                 if ( !displayOnly )
                 {
-                    auto mediaInfo = getMediaInfo( fi );
-                    processInfo->fMaximum = mediaInfo->getNumberOfSeconds();
+                    auto plan = getTranscodePlan( fi );
+                    if ( !plan )
+                        return { false, std::list< QStandardItem * >() };
+                    processInfo->fMaximum = plan->fSeconds;
+                    processInfo->fResourceClass = EProcessResourceClass::eCPU;
+                    processInfo->fMinThreads = 4;
+                    processInfo->fMaxThreads = 16;   // x264/x265 stop scaling past this
 
                     processInfo->fCmd = NPreferences::NCore::CPreferences::instance()->getFFMpegEXE();
                     if ( processInfo->fCmd.isEmpty() || !QFileInfo( processInfo->fCmd ).isExecutable() )
@@ -414,7 +444,6 @@ namespace NMediaManager
 
             if ( processInfos.empty() )
                 return std::make_pair( true, std::list< QStandardItem * >() );
-            fFirstProcess = true;
 
             if ( retVal.first )
             {
@@ -450,37 +479,128 @@ namespace NMediaManager
 
             if ( retVal.first && !displayOnly )
             {
-                auto pos = processInfos.find( ETranscodeType::eHighBitrate );
-                if ( pos != processInfos.end() )
-                    fProcessQueue.push_back( ( *pos ).second );
-                pos = processInfos.find( ETranscodeType::eHighRes );
-                if ( pos != processInfos.end() )
-                    fProcessQueue.push_back( ( *pos ).second );
-                pos = processInfos.find( ETranscodeType::eOther );
-                if ( pos != processInfos.end() )
-                    fProcessQueue.push_back( ( *pos ).second );
-                QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
+                std::list< std::shared_ptr< SProcessInfo > > toQueue;
+                for ( auto &&type : { ETranscodeType::eHighBitrate, ETranscodeType::eHighRes, ETranscodeType::eOther } )
+                {
+                    auto pos = processInfos.find( type );
+                    if ( pos != processInfos.end() )
+                        toQueue.push_back( ( *pos ).second );
+                }
+
+                auto combined = combineTranscodes( toQueue );
+                if ( combined )
+                    toQueue = { combined };
+                for ( auto &&ii : toQueue )
+                    queueProcess( ii );
             }
             return retVal;
         }
 
-        void CTranscodeModel::getActions( NPreferences::NCore::STranscodeNeeded &transcodeNeeded, TTranscodeProcessInfoMap &processInfos, ETranscodeType type )
+        int CTranscodeModel::outputArgsStart( const QStringList &args )
         {
-            auto pos = processInfos.find( type );
-            if ( pos == processInfos.end() )
-                return;
+            auto pos = args.lastIndexOf( "-i" );
+            if ( ( pos == -1 ) || ( ( pos + 1 ) >= args.count() ) )
+                return -1;
+            return pos + 2;
+        }
+
+        std::shared_ptr< SProcessInfo > CTranscodeModel::combineTranscodes( const std::list< std::shared_ptr< SProcessInfo > > &processInfos ) const
+        {
+            // one ffmpeg run with an output per variant, so the source is only decoded once
+            // only done when every variant reads the same inputs with the same input options
+            if ( processInfos.size() < 2 )
+                return {};
+
+            auto &&first = processInfos.front();
+            auto inputEnd = outputArgsStart( first->fArgs );
+            if ( inputEnd == -1 )
+                return {};
+            auto inputArgs = first->fArgs.mid( 0, inputEnd );
+
+            auto retVal = std::make_shared< SProcessInfo >( *first );
+            retVal->fNewNames.clear();
+            retVal->fOutputItems.clear();
+            retVal->fAncillary.clear();
+            retVal->fProgressLabel.clear();
+            retVal->fMinThreads = 0;
+            retVal->fMaxThreads = 0;
+
+            auto args = inputArgs;
+            QStringList progressLabels;
+            for ( auto &&ii : processInfos )
+            {
+                if ( ii->fPostProcess || !ii->fPostProcessType.isEmpty() )   // segmented encodes run as their own chain of jobs
+                    return {};
+                if ( ( ii->fCmd != first->fCmd ) || ( ii->fOldName != first->fOldName ) || ( outputArgsStart( ii->fArgs ) != inputEnd ) || ( ii->fArgs.mid( 0, inputEnd ) != inputArgs ) )
+                    return {};
+
+                args << ii->fArgs.mid( inputEnd );
+                retVal->fNewNames << ii->fNewNames;
+                retVal->fOutputItems.emplace_back( ii->fItem, ii->fNewNames );   // progress and errors still land on each variant's row
+                for ( auto &&jj : ii->fAncillary )
+                {
+                    if ( !retVal->fAncillary.contains( jj ) )
+                        retVal->fAncillary << jj;
+                }
+                progressLabels << ii->fProgressLabel;
+                retVal->fBackupOrig = retVal->fBackupOrig || ii->fBackupOrig;
+                retVal->fSetMetainfoTagsOnSuccess = retVal->fSetMetainfoTagsOnSuccess || ii->fSetMetainfoTagsOnSuccess;
+                retVal->fMinThreads += ii->fMinThreads;
+                retVal->fMaxThreads += ii->fMaxThreads;   // one encoder per output
+            }
+            retVal->fArgs = args;
+            retVal->fProgressLabel = progressLabels.join( "<br>" );
+            return retVal;
+        }
+
+        std::shared_ptr< const NPreferences::NCore::STranscodePlan > CTranscodeModel::getTranscodePlan( const QFileInfo &fi, bool force ) const
+        {
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            auto snapshot = prefs->snapshot();
+            auto path = fi.absoluteFilePath();
+            auto pos = fTranscodePlans.find( path );
+
+            // a plan from an earlier session is enough to show the file, it is only probed again when it is transcoded
+            if ( !force && !prefs->getCachedMediaInfo( fi ) )
+            {
+                if ( ( pos != fTranscodePlans.end() ) && ( ( *pos ).second->fRevision == snapshot->fRevision ) )
+                    return ( *pos ).second;
 
-            QStringList actions;
-            if ( type == ETranscodeType::eHighBitrate )
-                actions = transcodeNeeded.getHighBitrateAction();
-            else if ( type == ETranscodeType::eHighRes )
-                actions = transcodeNeeded.getHighResolutionAction();
+                auto summary = NPreferences::NCore::CMediaInfoCache::instance()->findTranscodeSummary( fi, snapshot->fTranscodeRulesHash );
+                if ( summary.has_value() )
+                {
+                    auto plan = std::make_shared< NPreferences::NCore::STranscodePlan >( path, summary.value(), prefs, snapshot->fRevision );
+                    fTranscodePlans[ path ] = plan;
+                    return plan;
+                }
+            }
+
+            auto mediaInfo = getMediaInfo( fi, force );
+            if ( !mediaInfo )
+                return {};
+
+            if ( ( pos != fTranscodePlans.end() ) && ( *pos ).second->isCurrent( mediaInfo, snapshot->fRevision ) )
+                return ( *pos ).second;
+
+            auto plan = prefs->getTranscodePlan( mediaInfo );
+            if ( plan->isLoaded() )   // a plan for media info still being probed goes stale as soon as it loads
+            {
+                fTranscodePlans[ path ] = plan;
+                NPreferences::NCore::CComplianceStore::instance()->setCompliant( fi, snapshot->fTranscodeRulesHash, !plan->workNeeded() );
+                NPreferences::NCore::CMediaInfoCache::instance()->addTranscodeSummary( fi, plan->summary( snapshot->fTranscodeRulesHash ) );
+            }
             else
-                actions = transcodeNeeded.getActions();
+                fTranscodePlans.erase( path );
+            return plan;
+        }
 
-            actions.removeAll( QString() );
+        void CTranscodeModel::getActions( const NPreferences::NCore::STranscodePlan &plan, TTranscodeProcessInfoMap &processInfos, ETranscodeType type )
+        {
+            auto pos = processInfos.find( type );
+            if ( pos == processInfos.end() )
+                return;
 
-            for ( auto &&ii : actions )
+            for ( auto &&ii : plan.actions( type ) )
             {
                 auto item = new QStandardItem( ii );
                 ( *pos ).second->fItem->appendRow( item );
@@ -493,17 +613,16 @@ namespace NMediaManager
                 return { true, {} };
 
             auto path = item->data( ECustomRoles::eAbsFilePath ).toString();
-            auto mediaInfo = getMediaInfo( path );
             //qDebug() << path;
 
             auto fi = QFileInfo( path );
-            auto transcodeNeeded = NPreferences::NCore::STranscodeNeeded( mediaInfo );
-            if ( !transcodeNeeded.transcodeNeeded() && !transcodeNeeded.bitrateTooHigh() && !transcodeNeeded.resolutionTooHigh() && srtFiles.empty() && subIDXFiles.empty() )
+            auto plan = getTranscodePlan( fi, !displayOnly );
+            if ( !plan || ( !plan->workNeeded() && srtFiles.empty() && subIDXFiles.empty() ) )
                 return { true, {} };
 
-            getActions( transcodeNeeded, processInfos, ETranscodeType::eHighBitrate );
-            getActions( transcodeNeeded, processInfos, ETranscodeType::eHighRes );
-            getActions( transcodeNeeded, processInfos, ETranscodeType::eOther );
+            getActions( *plan, processInfos, ETranscodeType::eHighBitrate );
+            getActions( *plan, processInfos, ETranscodeType::eHighRes );
+            getActions( *plan, processInfos, ETranscodeType::eOther );
 
             std::list< QStandardItem * > items;
             if ( !displayOnly )
@@ -521,20 +640,13 @@ namespace NMediaManager
 
                     processInfo->fTimeStamps = NSABUtils::NFileUtils::timeStamps( processInfo->fOldName );
 
-                    if ( transcodeType == ETranscodeType::eOther )
-                    {
-                        processInfo->fProgressLabel = transcodeNeeded.getProgressLabelHeader( getDispName( processInfo->fOldName ), tmp, getDispName( processInfo->primaryNewName() ) );
-                        processInfo->fArgs = NPreferences::NCore::CPreferences::instance()->getTranscodeArgs( mediaInfo, processInfo->fOldName, processInfo->primaryNewName(), srtFiles, subIDXFiles );
-                    }
-                    else if ( transcodeType == ETranscodeType::eHighBitrate )
+                    processInfo->fProgressLabel = plan->progressLabel( transcodeType, getDispName( processInfo->fOldName ), tmp, getDispName( processInfo->primaryNewName() ) );
+                    processInfo->fArgs = NPreferences::NCore::CPreferences::instance()->getTranscodeArgs( *plan, transcodeType, processInfo->fOldName, processInfo->primaryNewName(), srtFiles, subIDXFiles );
+                    if ( !processInfo->fArgs.isEmpty() )
                     {
-                        processInfo->fProgressLabel = transcodeNeeded.getHighBitrateProgressLabelHeader( getDispName( processInfo->fOldName ), tmp, getDispName( processInfo->primaryNewName() ) );
-                        processInfo->fArgs = NPreferences::NCore::CPreferences::instance()->getHighBitrateTranscodeArgs( mediaInfo, processInfo->fOldName, processInfo->primaryNewName(), srtFiles, subIDXFiles );
-                    }
-                    else if ( transcodeType == ETranscodeType::eHighRes )
-                    {
-                        processInfo->fProgressLabel = transcodeNeeded.getHighResolutionProgressLabelHeader( getDispName( processInfo->fOldName ), tmp, getDispName( processInfo->primaryNewName() ) );
-                        processInfo->fArgs = NPreferences::NCore::CPreferences::instance()->getHighResolutionTranscodeArgs( mediaInfo, processInfo->fOldName, processInfo->primaryNewName(), srtFiles, subIDXFiles );
+                        processInfo->fArgs = CFFmpegProgressParser::progressPipeArgs() + processInfo->fArgs;
+                        if ( plan->useSegmentedEncoding( transcodeType ) )
+                            setupSegmentedEncoding( processInfo, plan, transcodeType, srtFiles, subIDXFiles );
                     }
 
                     items.push_back( processInfo->fItem );
@@ -543,6 +655,159 @@ namespace NMediaManager
             return { true, items };
         }
 
+        bool CTranscodeModel::setupSegmentedEncoding( std::shared_ptr< SProcessInfo > processInfo, std::shared_ptr< const NPreferences::NCore::STranscodePlan > plan, ETranscodeType transcodeType, const std::list< NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NCore::SLanguageInfo, QString > > &subIDXFiles )
+        {
+            // processInfo becomes the first of three steps
+            //   split the video stream at keyframes, stream copy
+            //   encode the segments side by side, queued when the split finishes
+            //   concat mux the encoded video with the original audio, subtitles and metadata, queued when the last segment finishes
+            // when anything can not be set up, processInfo is left as a single run
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            auto totalSeconds = static_cast< int >( plan->fSeconds );
+            auto numSegments = prefs->getNumEncodeSegments();
+            auto segmentSeconds = std::max( 1, static_cast< int >( std::ceil( 1.0 * totalSeconds / numSegments ) ) );
+
+            auto tempDir = createTempDir( processInfo->fOldName, 2 * QFileInfo( processInfo->fOldName ).size() );   // the split video and the encoded segments
+            if ( !tempDir->isValid() )
+                return false;
+
+            auto concatList = tempDir->filePath( "segments.ffconcat" );
+            auto muxArgs = prefs->getSegmentedTranscodeArgs( *plan, transcodeType, processInfo->fOldName, processInfo->primaryNewName(), srtFiles, subIDXFiles, concatList );
+            if ( muxArgs.isEmpty() )
+                return false;
+
+            auto muxInfo = std::make_shared< SProcessInfo >( *processInfo );
+            muxInfo->fArgs = CFFmpegProgressParser::progressPipeArgs() + muxArgs;
+            muxInfo->fTempDir = tempDir;
+            muxInfo->fResourceClass = EProcessResourceClass::eDisk;
+            muxInfo->fMinThreads = 1;
+            muxInfo->fMaxThreads = 4;
+            muxInfo->fPostProcessType = "segment-mux";
+
+            // the joined file must cover the source and keep its stream layout
+            auto hasAudio = plan->fNumAudioStreams > 0;
+            auto numSubtitles = static_cast< int >( plan->fNumSubtitleStreams + srtFiles.size() + subIDXFiles.size() );
+            muxInfo->fPostProcess = [ this, totalSeconds, hasAudio, numSubtitles ]( const SProcessInfo *processInfo, QString &msg )
+            {
+                auto outInfo = getMediaInfo( processInfo->primaryNewName(), true );
+                if ( !outInfo )
+                {
+                    msg = tr( "Could not read the media info of '%1'" ).arg( getDispName( processInfo->primaryNewName() ) );
+                    return false;
+                }
+
+                auto outSeconds = static_cast< double >( outInfo->getNumberOfSeconds() );
+                auto tolerance = std::max( 2.0, 0.005 * totalSeconds );
+                if ( std::abs( outSeconds - totalSeconds ) > tolerance )
+                {
+                    msg = tr( "Joined segments are %1 seconds long, the source is %2 seconds" ).arg( outSeconds ).arg( totalSeconds );
+                    return false;
+                }
+
+                auto outResolution = outInfo->getResolution();
+                if ( ( outResolution.first <= 0 ) || ( outResolution.second <= 0 ) )
+                {
+                    msg = tr( "Joined segments have no video stream" );
+                    return false;
+                }
+
+                if ( hasAudio && ( outInfo->numAudioStreams() == 0 ) )
+                {
+                    msg = tr( "Joined segments lost the audio streams" );
+                    return false;
+                }
+
+                if ( static_cast< int >( outInfo->numSubtitleStreams() ) < numSubtitles )
+                {
+                    msg = tr( "Joined segments have %1 subtitle streams, expected %2" ).arg( outInfo->numSubtitleStreams() ).arg( numSubtitles );
+                    return false;
+                }
+                return true;
+            };
+
+            auto group = std::make_shared< SSegmentedProgress >();
+            group->fPending = 1;   // the split
+
+            processInfo->fArgs = prefs->getSegmentSplitArgs( processInfo->fOldName, tempDir->filePath( "seg_%03d.mkv" ), segmentSeconds );
+            processInfo->fNewNames = QStringList() << concatList;
+            processInfo->fAncillary.clear();
+            processInfo->fBackupOrig = false;
+            processInfo->fSetMetainfoTagsOnSuccess = false;
+            processInfo->fIntermediate = true;
+            processInfo->fSegmentedProgress = group;
+            processInfo->fTempDir = tempDir;
+            processInfo->fMaximum = 0;
+            processInfo->fResourceClass = EProcessResourceClass::eDisk;
+            processInfo->fMinThreads = 1;
+            processInfo->fMaxThreads = 1;
+            processInfo->fProgressLabel = muxInfo->fProgressLabel + tr( "<p>Splitting into %1 segments at keyframes</p>" ).arg( numSegments );
+            processInfo->fPostProcessType = "segment-split";
+            processInfo->fPostProcess = [ this, plan, transcodeType, muxInfo, group, totalSeconds ]( const SProcessInfo *processInfo, QString &msg )
+            {
+                auto dir = QDir( processInfo->fTempDir->path() );
+                auto segments = dir.entryInfoList( QStringList() << "seg_*.mkv", QDir::Files, QDir::Name );
+                if ( segments.isEmpty() )
+                {
+                    group->fFailed = true;
+                    msg = tr( "No segments were created" );
+                    return false;
+                }
+
+                auto encodedName = []( int segmentNum ) { return QString( "enc_%1.mkv" ).arg( segmentNum, 3, 10, QChar( '0' ) ); };
+
+                QFile file( processInfo->primaryNewName() );
+                if ( !file.open( QFile::WriteOnly | QFile::Truncate | QFile::Text ) )
+                {
+                    group->fFailed = true;
+                    msg = tr( "Could not write '%1'" ).arg( processInfo->primaryNewName() );
+                    return false;
+                }
+                QTextStream ts( &file );
+                ts << "ffconcat version 1.0\n";
+                for ( int ii = 0; ii < segments.count(); ++ii )
+                    ts << "file " << encodedName( ii ) << "\n";   // relative to the list
+                file.close();
+
+                auto prefs = NPreferences::NCore::CPreferences::instance();
+                auto maxThreads = std::max( 2, prefs->getProcessThreadBudget() / segments.count() );
+                for ( int ii = 0; ii < segments.count(); ++ii )
+                {
+                    auto encodeInfo = std::make_shared< SProcessInfo >();
+                    encodeInfo->fCmd = processInfo->fCmd;
+                    encodeInfo->fOldName = segments[ ii ].absoluteFilePath();
+                    encodeInfo->fNewNames << dir.absoluteFilePath( encodedName( ii ) );
+                    encodeInfo->fArgs = CFFmpegProgressParser::progressPipeArgs() + prefs->getSegmentEncodeArgs( *plan, transcodeType, encodeInfo->fOldName, encodeInfo->primaryNewName() );
+                    encodeInfo->fItem = processInfo->fItem;
+                    encodeInfo->fTimeStamps = processInfo->fTimeStamps;
+                    encodeInfo->fBackupOrig = false;
+                    encodeInfo->fIntermediate = true;
+                    encodeInfo->fSegmentedProgress = group;
+                    encodeInfo->fTempDir = processInfo->fTempDir;
+                    encodeInfo->fMaximum = totalSeconds;   // progress is shown over the whole source
+                    encodeInfo->fResourceClass = EProcessResourceClass::eCPU;
+                    encodeInfo->fMaxThreads = maxThreads;
+                    encodeInfo->fMinThreads = std::min( 4, maxThreads );
+                    encodeInfo->fProgressLabel = muxInfo->fProgressLabel + tr( "<p>Encoding %1 segments</p>" ).arg( segments.count() );
+                    encodeInfo->fPostProcessType = "segment-encode";
+                    encodeInfo->fPostProcess = [ this, muxInfo, group ]( const SProcessInfo * /*processInfo*/, QString & /*msg*/ )
+                    {
+                        if ( ( group->fPending == 0 ) && !group->fFailed )
+                            queueProcess( muxInfo );
+                        return true;
+                    };
+                    group->fPending++;
+                    queueProcess( encodeInfo );
+                }
+                return true;
+            };
+            return true;
+        }
+
+        bool CTranscodeModel::restoreProcess( std::shared_ptr< SProcessInfo > /*processInfo*/, const SJournalJob &job )
+        {
+            return job.fPostProcessType.isEmpty();   // the steps of a segmented encode share a temp dir that does not survive a restart
+        }
+
         std::pair< bool, QStandardItem * > CTranscodeModel::processHighResolution( TTranscodeProcessInfoMap &processInfos, const QStandardItem *videoFileItem, bool displayOnly )
         {
             if ( !videoFileItem )
@@ -555,15 +820,17 @@ namespace NMediaManager
                 return { true, nullptr };
 
             auto path = videoFileItem->data( ECustomRoles::eAbsFilePath ).toString();
-            auto mediaInfo = getMediaInfo( path );
             //qDebug() << path;
 
             auto fi = QFileInfo( path );
-            auto transcodeNeeded = NPreferences::NCore::STranscodeNeeded( mediaInfo );
+            auto plan = getTranscodePlan( fi );
+            if ( !plan )
+                return { true, nullptr };
+            auto &&transcodeNeeded = plan->fTranscodeNeeded;
             if ( !transcodeNeeded.resolutionTooHigh() )
                 return { true, nullptr };
 
-            getActions( transcodeNeeded, processInfos, ETranscodeType::eHighRes );
+            getActions( *plan, processInfos, ETranscodeType::eHighRes );
 
             auto pos = processInfos.find( ETranscodeType::eHighRes );
             if ( pos == processInfos.end() )
@@ -585,15 +852,17 @@ namespace NMediaManager
                 return { true, nullptr };
 
             auto path = videoFileItem->data( ECustomRoles::eAbsFilePath ).toString();
-            auto mediaInfo = getMediaInfo( path );
             //qDebug() << path;
 
             auto fi = QFileInfo( path );
-            auto transcodeNeeded = NPreferences::NCore::STranscodeNeeded( mediaInfo );
+            auto plan = getTranscodePlan( fi );
+            if ( !plan )
+                return { true, nullptr };
+            auto &&transcodeNeeded = plan->fTranscodeNeeded;
             if ( !transcodeNeeded.bitrateTooHigh() )
                 return { true, nullptr };
 
-            getActions( transcodeNeeded, processInfos, ETranscodeType::eHighBitrate );
+            getActions( *plan, processInfos, ETranscodeType::eHighBitrate );
             auto pos = processInfos.find( ETranscodeType::eHighRes );
             if ( pos == processInfos.end() )
                 return { true, nullptr };
@@ -772,76 +1041,6 @@ namespace NMediaManager
             return retVal;
         }
 
-        std::optional< std::pair< uint64_t, std::optional< uint64_t > > > CTranscodeModel::getCurrentProgress( const QString &string )
-        {
-            // time=00:00:00.00
-            auto numSeconds = getNumSeconds( string );
-            if ( !numSeconds.has_value() )
-                return {};
-            return std::pair< uint64_t, std::optional< uint64_t > >( numSeconds.value(), {} );
-        }
-
-        std::optional< uint64_t > CTranscodeModel::getNumSeconds( const QString &string ) const
-        {
-            auto regEx = QRegularExpression( "[Tt]ime\\=\\s*(?<hours>\\d{2}):(?<mins>\\d{2}):(?<secs>\\d{2})" );
-
-            QRegularExpressionMatch match;
-            auto pos = string.lastIndexOf( regEx, -1, &match );
-            if ( ( pos == -1 ) || !match.hasMatch() )
-                return 0;
-
-            auto hours = match.captured( "hours" );
-            auto mins = match.captured( "mins" );
-            auto secs = match.captured( "secs" );
-
-            uint64_t numSeconds = 0;
-            if ( !hours.isEmpty() )
-            {
-                bool aOK;
-                int curr = hours.toInt( &aOK );
-                if ( aOK )
-                    numSeconds += curr * 60 * 60;
-            }
-
-            if ( !mins.isEmpty() )
-            {
-                bool aOK;
-                int curr = mins.toInt( &aOK );
-                if ( aOK )
-                    numSeconds += curr * 60;
-            }
-
-            if ( !secs.isEmpty() )
-            {
-                bool aOK;
-                int curr = secs.toInt( &aOK );
-                if ( aOK )
-                    numSeconds += curr;
-            }
-            return numSeconds;
-        }
-
-        std::optional< std::chrono::milliseconds > CTranscodeModel::getMSRemaining( const QString &string, const std::pair< uint64_t, std::optional< uint64_t > > &currProgress ) const
-        {
-            if ( !currProgress.second.has_value() )
-                return {};
-
-            auto regEx2 = QRegularExpression( "[Ss]peed\\s*\\=\\s*(?<multiplier>\\d+(\\.\\d+)?)" );
-            QRegularExpressionMatch match;
-            auto pos = string.lastIndexOf( regEx2, -1, &match );
-            if ( ( pos == -1 ) || !match.hasMatch() )
-                return {};
-
-            auto mult = match.captured( "multiplier" );
-            bool aOK = false;
-            auto multVal = mult.toDouble( &aOK );
-            if ( !aOK || ( multVal == 0.0 ) )
-                return {};
-
-            auto msecsRemaining = std::chrono::milliseconds( static_cast< uint64_t >( std::round( ( currProgress.second.value() - currProgress.first ) * 1000 / multVal ) ) );
-            return msecsRemaining;
-        }
-
         void CTranscodeModel::autoDetermineLanguageAttributes( QStandardItem *mediaFileNode ) const
         {
             //if ( mediaFileNode )
@@ -902,38 +1101,19 @@ namespace NMediaManager
             if ( !videoFile.exists() || !videoFile.isFile() )
                 return {};
 
-            std::optional< QList< QFileInfo > > srtFiles;
-
             auto dir = videoFile.absoluteDir();
-            auto ii = fSRTFileCache.find( dir.absolutePath() );
-            if ( ii == fSRTFileCache.end() )
-            {
-                //qDebug().noquote().nospace() << "Finding SRT files for '" << getDispName( videoFile ) << "' in dir '" << getDispName( dir.absolutePath() ) << "'";
-
-                srtFiles = NSABUtils::NFileUtils::findAllFiles(
-                    dir, QStringList() << "*.srt", true, false, nullptr,
-                    []( const QDir &dir )
-                    {
-                        //qDebug() << dir;
-                        return NPreferences::NCore::CPreferences::instance()->isSkippedPath( false, dir );
-                    } );
-                fSRTFileCache[ dir.absolutePath() ] = srtFiles;
-            }
-            else
-                srtFiles = ( *ii ).second;
+            //qDebug().noquote().nospace() << "Finding SRT files for '" << getDispName( videoFile ) << "' in dir '" << getDispName( dir.absolutePath() ) << "'";
+            auto srtFiles = sidecarIndex()->findAllFiles( dir.absolutePath(), QStringList() << "*.srt", []( const QFileInfo &dirInfo ) { return NPreferences::NCore::CPreferences::instance()->isSkippedPath( false, dirInfo ); } );
 
             //qDebug().noquote().nospace() << "Found '" << srtFiles.count() << "' SRT Files";
 
-            if ( !srtFiles.has_value() )
-                return {};
-
-            if ( srtFiles.value().count() <= 1 )
+            if ( srtFiles.count() <= 1 )
             {
-                return srtFiles.value();
+                return srtFiles;
             }
 
             if ( countOnly )
-                return srtFiles.value();
+                return srtFiles;
 
             // could be 2_lang, 3_lang etc - return them all
             // or could be name.srt (common for TV shows)
@@ -945,7 +1125,7 @@ namespace NMediaManager
             QList< QFileInfo > unknownFiles;
 
             std::map< QString, QList< QFileInfo > > nameBasedMap;
-            for ( auto &&ii : srtFiles.value() )
+            for ( auto &&ii : srtFiles )
             {
                 if ( isNameBasedMatch( videoFile, ii ) )
                     nameBasedMap[ videoFile.completeBaseName() ].push_back( ii );
@@ -957,7 +1137,7 @@ namespace NMediaManager
             }
             else
             {
-                for ( auto &&ii : srtFiles.value() )
+                for ( auto &&ii : srtFiles )
                 {
                     //qDebug().noquote().nospace() << "Checking '" << getDispName( ii ) << "'";
                     //qDebug().noquote().nospace() << "Checking '" << fi.completeBaseName() << "' against '" << ii.completeBaseName() << "'";
@@ -1042,31 +1222,24 @@ namespace NMediaManager
             //qDebug() << dir.absolutePath();
             std::list< std::pair< QFileInfo, QFileInfo > > retVal;
 
-            auto subFiles = dir.entryInfoList( QStringList() << "*.sub" );
+            auto subFiles = sidecarIndex()->findAllFiles( dir.absolutePath(), QStringList() << "*.sub", {} );
             std::unordered_map< QString, QFileInfo > subMap;
             for ( auto &&ii : subFiles )
             {
-                auto baseName = ii.completeBaseName();
+                auto baseName = QDir( ii.absolutePath() ).absoluteFilePath( ii.completeBaseName() );
                 subMap[ baseName ] = ii;
             }
 
-            auto idxFiles = dir.entryInfoList( QStringList() << "*.idx" );
+            auto idxFiles = sidecarIndex()->findAllFiles( dir.absolutePath(), QStringList() << "*.idx", {} );
             for ( auto &&ii : idxFiles )
             {
-                auto baseName = ii.completeBaseName();
+                auto baseName = QDir( ii.absolutePath() ).absoluteFilePath( ii.completeBaseName() );
                 auto pos = subMap.find( baseName );
                 if ( pos == subMap.end() )
                     continue;
 
                 retVal.emplace_back( std::make_pair( ii, ( *pos ).second ) );
             }
-
-            auto subDirs = dir.entryInfoList( QDir::Filter::AllDirs | QDir::Filter::NoDotAndDotDot );
-            for ( auto &&ii : subDirs )
-            {
-                auto sub = getIDXSUBFilesInDir( QDir( ii.absoluteFilePath() ) );
-                retVal.insert( retVal.end(), sub.begin(), sub.end() );
-            }
             return retVal;
         }
 
@@ -35,7 +35,8 @@ namespace NMediaManager
     {
         namespace NCore
         {
-            struct STranscodeNeeded;
+            struct STranscodePlan;
+            enum class ETranscodeType;
         }
     }
 
@@ -62,16 +63,12 @@ namespace NMediaManager
             virtual void clear() override;
 
             virtual QStringList dirModelFilter() const override;
+            virtual QStringList sidecarFilter() const override;
 
             virtual std::pair< bool, std::list< QStandardItem * > > processItem( const QStandardItem *item, bool displayOnly ) override;
 
             // returns aOK, error item when aOK = false
-            enum ETranscodeType
-            {
-                eHighRes,
-                eHighBitrate,
-                eOther
-            };
+            using ETranscodeType = NPreferences::NCore::ETranscodeType;
             using TTranscodeProcessInfoMap = std::map< ETranscodeType, std::shared_ptr< SProcessInfo > >;
 
 
@@ -86,7 +83,12 @@ namespace NMediaManager
             [[nodiscard]] std::pair< bool, std::list< QStandardItem * > > processSRTSubTitle( TTranscodeProcessInfoMap &processInfos, const QStandardItem *mkvFileItem, const std::unordered_map< QString, std::vector< QStandardItem * > > &srtFiles ) const;
             [[nodiscard]] std::pair< bool, std::list< QStandardItem * > > processSUBIDXSubTitle( TTranscodeProcessInfoMap &processInfos, const QStandardItem *mkvFileItem, const std::list< std::pair< QStandardItem *, QStandardItem * > > &subIDXFiles ) const;
 
-            void getActions( NPreferences::NCore::STranscodeNeeded &transcodeNeeded, TTranscodeProcessInfoMap &processInfos, ETranscodeType type );
+            std::shared_ptr< const NPreferences::NCore::STranscodePlan > getTranscodePlan( const QFileInfo &fi, bool force = false ) const;   // cached per file until the preferences or the media info change, without force it can come from the media info cache and have no fMediaInfo
+            void getActions( const NPreferences::NCore::STranscodePlan &plan, TTranscodeProcessInfoMap &processInfos, ETranscodeType type );
+            std::shared_ptr< SProcessInfo > combineTranscodes( const std::list< std::shared_ptr< SProcessInfo > > &processInfos ) const;   // empty when the variants can not share one decode
+            static int outputArgsStart( const QStringList &args );   // the first arg after the last input
+            bool setupSegmentedEncoding( std::shared_ptr< SProcessInfo > processInfo, std::shared_ptr< const NPreferences::NCore::STranscodePlan > plan, ETranscodeType transcodeType, const std::list< NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NCore::SLanguageInfo, QString > > &subIDXFiles );   // false leaves processInfo as one run
+            virtual bool restoreProcess( std::shared_ptr< SProcessInfo > processInfo, const SJournalJob &job ) override;
             QString computeProgressLabel( const SProcessInfo &processInfo ) const;
 
             virtual bool showMediaItems() const override { return true; };
@@ -106,12 +108,7 @@ namespace NMediaManager
             virtual void attachTreeNodes( QStandardItem * /*nextParent*/, QStandardItem *& /*prevParent*/, const STreeNode & /*treeNode*/ ) override;
 
             virtual bool usesQueuedProcessing() const override { return true; }
-
-            virtual std::optional< std::pair< uint64_t, std::optional< uint64_t > > > getCurrentProgress( const QString &string ) override;
-
-            virtual std::optional< uint64_t > getNumSeconds( const QString &string ) const;
-
-            std::optional< std::chrono::milliseconds > getMSRemaining( const QString &string, const std::pair< uint64_t, std::optional< uint64_t > > &currProgress ) const override;
+            virtual int maxConcurrentProcesses() const override;
 
             virtual bool currentUnitsAreSeconds() const { return true; }
 
@@ -134,7 +131,7 @@ namespace NMediaManager
 
             QStandardItem *getLanguageItem( const QStandardItem *parent ) const;
 
-            mutable std::unordered_map< QString, std::optional< QList< QFileInfo > > > fSRTFileCache;
+            mutable std::unordered_map< QString, std::shared_ptr< const NPreferences::NCore::STranscodePlan > > fTranscodePlans;
             mutable std::map< QStandardItem *, std::pair< QStandardItem *, NCore::SLanguageInfo > > fAllLangInfos;
         };
     }
@@ -27,6 +27,7 @@
 
 #include <QDir>
 #include <QTimer>
+#include <QThread>
 
 namespace NMediaManager
 {
@@ -60,10 +61,10 @@ namespace NMediaManager
 
             bool aOK = true;
             QStandardItem *myItem = nullptr;
-            fFirstProcess = true;
             if ( !displayOnly )
             {
                 processInfo->fForceUnbuffered = true;
+                processInfo->fResourceClass = EProcessResourceClass::eDisk;
                 processInfo->fMaximum = 4;
 
                 processInfo->fCmd = NPreferences::NCore::CPreferences::instance()->getMKVValidatorEXE();
@@ -88,15 +89,17 @@ namespace NMediaManager
                                      //<< "--quiet"
                                      << processInfo->fOldName;
                 if ( aOK )
-                {
-                    fProcessQueue.push_back( processInfo );
-                    QTimer::singleShot( 0, this, &CDirModel::slotRunNextProcessInQueue );
-                }
+                    queueProcess( processInfo );
             }
             myItem = processInfo->fItem;
             return std::make_pair( aOK, std::list< QStandardItem * >( { myItem } ) );
         }
 
+        int CValidateMKVModel::maxConcurrentProcesses() const
+        {
+            return QThread::idealThreadCount();   // single threaded and disk bound, the per disk budget decides how many really run
+        }
+
         QString CValidateMKVModel::getProgressLabel( std::shared_ptr< SProcessInfo > processInfo ) const
         {
             auto retVal = QString( "Validating MKV<ul><li>%1</li></ul>" ).arg( getDispName( processInfo->fOldName ) );
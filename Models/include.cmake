@@ -27,10 +27,16 @@ set(FOLDER_NAME Libs)
 set(qtproject_SRCS
     DirModel.cpp
     DirNodeItem.cpp
+    DirScanIndex.cpp
+    DirScanner.cpp
+    SidecarIndex.cpp
+    FFmpegProgress.cpp
     GenerateBIFModel.cpp
     TranscodeModel.cpp
     TagsModel.cpp
     MediaNamingModel.cpp
+    ProcessJournal.cpp
+    ProcessLog.cpp
     ValidateMKVModel.cpp
 )
 
@@ -45,6 +51,12 @@ set(qtproject_H
 
 set(project_H
     DirNodeItem.h
+    DirScanIndex.h
+    DirScanner.h
+    SidecarIndex.h
+    FFmpegProgress.h
+    ProcessJournal.h
+    ProcessLog.h
 )
 
 set(qtproject_UIS
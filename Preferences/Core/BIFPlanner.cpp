@@ -0,0 +1,183 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BIFPlanner.h"
+#include "MKVProbe.h"
+#include "MediaProbePool.h"
+#include "Preferences.h"
+#include "SABUtils/MediaInfo.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+
+#include <list>
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            CBIFPlanner *CBIFPlanner::instance()
+            {
+                static CBIFPlanner retVal;
+                return &retVal;
+            }
+
+            CBIFPlanner::CBIFPlanner()
+            {
+            }
+
+            CBIFPlanner::~CBIFPlanner()
+            {
+                shutdown();
+            }
+
+            void CBIFPlanner::shutdown()
+            {
+                cancel();
+                fPool.waitForDone();
+            }
+
+            bool CBIFPlanner::findCurrent( const QFileInfo &fi, SBIFSource &source ) const
+            {
+                auto pos = fSources.find( fi.absoluteFilePath() );
+                if ( ( pos == fSources.end() ) || ( ( *pos ).second.fModified != fi.lastModified().toMSecsSinceEpoch() ) )
+                    return false;
+                source = ( *pos ).second;
+                return true;
+            }
+
+            SBIFSource CBIFPlanner::source( const QFileInfo &fi )
+            {
+                SBIFSource retVal;
+                if ( findCurrent( fi, retVal ) )
+                    return retVal;
+
+                auto modified = fi.lastModified().toMSecsSinceEpoch();
+                auto mediaInfo = CPreferences::instance()->getCachedMediaInfo( fi );
+                if ( mediaInfo || !CPreferences::instance()->isMediaFile( fi ) )
+                    retVal = fromMediaInfo( mediaInfo, modified );
+                else
+                    retVal = probe( fi.absoluteFilePath(), modified );
+                fSources[ fi.absoluteFilePath() ] = retVal;
+                return retVal;
+            }
+
+            bool CBIFPlanner::plan( const QStringList &paths )
+            {
+                cancel();
+
+                // everything that touches the preferences or the media info caches happens here, on the GUI thread
+                std::list< std::pair< QString, qint64 > > toProbe;
+                for ( auto &&ii : paths )
+                {
+                    QFileInfo fi( ii );
+                    SBIFSource source;
+                    if ( findCurrent( fi, source ) )
+                        continue;
+
+                    auto modified = fi.lastModified().toMSecsSinceEpoch();
+                    auto mediaInfo = CPreferences::instance()->getCachedMediaInfo( fi );
+                    if ( mediaInfo || !CPreferences::instance()->isMediaFile( fi ) )
+                        fSources[ fi.absoluteFilePath() ] = fromMediaInfo( mediaInfo, modified );
+                    else
+                        toProbe.emplace_back( fi.absoluteFilePath(), modified );
+                }
+                if ( toProbe.empty() )
+                    return false;
+
+                auto generation = fGeneration;
+                fPending = fTotal = static_cast< int >( toProbe.size() );
+                fPool.setMaxThreadCount( CMediaProbePool::computeNumThreads( QFileInfo( toProbe.front().first ).absolutePath() ) );
+                for ( auto &&ii : toProbe )
+                {
+                    auto path = ii.first;
+                    auto modified = ii.second;
+                    fPool.start(
+                        [ this, generation, path, modified ]()
+                        {
+                            auto source = probe( path, modified );
+                            QMetaObject::invokeMethod( this, [ this, generation, path, source ]() { planResolved( generation, path, source ); }, Qt::QueuedConnection );
+                        } );
+                }
+                return true;
+            }
+
+            void CBIFPlanner::planResolved( uint64_t generation, const QString &path, const SBIFSource &source )
+            {
+                fSources[ path ] = source;   // still valid, even from a canceled plan
+                if ( generation != fGeneration )
+                    return;
+
+                fPending--;
+                emit sigPlanProgress( fTotal - fPending, fTotal );
+                if ( fPending == 0 )
+                    emit sigPlanned();
+            }
+
+            void CBIFPlanner::cancel()
+            {
+                fGeneration++;
+                fPool.clear();
+                if ( fPending == 0 )
+                    return;
+
+                fPending = fTotal = 0;
+                emit sigPlanned();
+            }
+
+            SBIFSource CBIFPlanner::probe( const QString &path, qint64 modified )
+            {
+                QFileInfo fi( path );
+                if ( auto summary = CMKVProbe::probeVideo( fi ) )
+                {
+                    SBIFSource retVal;
+                    retVal.fModified = modified;
+                    retVal.fWidth = summary.value().fWidth;
+                    retVal.fHeight = summary.value().fHeight;
+                    retVal.fAspectRatio = summary.value().fAspectRatio;
+                    retVal.fSeconds = static_cast< uint64_t >( summary.value().fSeconds );
+                    return retVal;
+                }
+
+                // constructed directly, the media info manager and the preferences are not thread safe
+                return fromMediaInfo( std::make_shared< NSABUtils::CMediaInfo >( fi ), modified );
+            }
+
+            SBIFSource CBIFPlanner::fromMediaInfo( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, qint64 modified )
+            {
+                SBIFSource retVal;
+                retVal.fModified = modified;
+                if ( !mediaInfo || !mediaInfo->aOK() )
+                    return retVal;
+
+                auto tags = mediaInfo->getMediaTags( { NSABUtils::EMediaTags::eWidth, NSABUtils::EMediaTags::eHeight, NSABUtils::EMediaTags::eAspectRatio } );
+                retVal.fWidth = tags[ NSABUtils::EMediaTags::eWidth ].toInt();
+                retVal.fHeight = tags[ NSABUtils::EMediaTags::eHeight ].toInt();
+                retVal.fAspectRatio = tags[ NSABUtils::EMediaTags::eAspectRatio ].toDouble();
+                retVal.fSeconds = mediaInfo->getNumberOfSeconds();
+                return retVal;
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_BIFPLANNER_H
+#define _CORE_BIFPLANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <memory>
+#include <unordered_map>
+#include "SABUtils/QtHashUtils.h"
+
+class QFileInfo;
+namespace NSABUtils
+{
+    class CMediaInfo;
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            // what a BIF/GIF run needs to know about its source before the queue is built
+            struct SBIFSource
+            {
+                bool isValid() const { return ( fWidth > 0 ) && ( fHeight > 0 ); }
+
+                int fWidth{ 0 };
+                int fHeight{ 0 };
+                double fAspectRatio{ 0.0 };   // w/h, 0 when the container doesnt store one
+                uint64_t fSeconds{ 0 };
+                qint64 fModified{ 0 };
+            };
+
+            // resolves the sources for the selected files in one parallel batch
+            // the order is: already loaded media info, the in process matroska probe, then a single ffprobe
+            // the preferences and media info caches are only read on the GUI thread, the pool only sees paths
+            class CBIFPlanner : public QObject
+            {
+                Q_OBJECT;
+
+                CBIFPlanner();
+
+            public:
+                static CBIFPlanner *instance();
+                virtual ~CBIFPlanner() override;
+
+                SBIFSource source( const QFileInfo &fi );   // resolves inline when not planned
+                bool plan( const QStringList &paths );   // returns at once, false when nothing needs resolving, otherwise sigPlanned follows
+                void cancel();   // drops the queued paths, sigPlanned is emitted right away
+                void shutdown();   // waits for the running probes, call before the application goes away
+                bool isPlanning() const { return fPending > 0; }
+
+            Q_SIGNALS:
+                void sigPlanProgress( int resolved, int total );
+                void sigPlanned();
+
+            private:
+                bool findCurrent( const QFileInfo &fi, SBIFSource &source ) const;
+                void planResolved( uint64_t generation, const QString &path, const SBIFSource &source );
+                static SBIFSource fromMediaInfo( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, qint64 modified );
+                static SBIFSource probe( const QString &path, qint64 modified );   // runs in the pool
+
+                QThreadPool fPool;
+                uint64_t fGeneration{ 0 };
+                int fPending{ 0 };
+                int fTotal{ 0 };
+                std::unordered_map< QString, SBIFSource > fSources;   // GUI thread only
+            };
+        }
+    }
+}
+#endif
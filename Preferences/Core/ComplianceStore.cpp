@@ -0,0 +1,198 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ComplianceStore.h"
+#include "MediaInfoCache.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            const quint32 CComplianceStore::sMagic = 0x4d4d4353;   // MMCS
+            const quint32 CComplianceStore::sVersion = 1;
+
+            CComplianceStore *CComplianceStore::instance()
+            {
+                static CComplianceStore retVal;
+                return &retVal;
+            }
+
+            CComplianceStore::CComplianceStore()
+            {
+            }
+
+            QString CComplianceStore::storeFileName()
+            {
+                auto appDataDir = QDir( QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) );
+                if ( !appDataDir.exists() )
+                    appDataDir.mkpath( "." );
+                return appDataDir.absoluteFilePath( "ComplianceStore.dat" );
+            }
+
+            bool CComplianceStore::isCurrent( const SEntry &entry, const QFileInfo &fi )
+            {
+                auto stamp = CMediaInfoCache::fileStamp( fi );
+                return ( entry.fSize == std::get< 0 >( stamp ) ) && ( entry.fModified == std::get< 1 >( stamp ) ) && ( entry.fInode == std::get< 2 >( stamp ) );
+            }
+
+            bool CComplianceStore::isCompliant( const QFileInfo &fi, const QByteArray &rulesHash )
+            {
+                QMutexLocker locker( &fMutex );
+                loadIfNeeded();
+
+                auto pos = fEntries.find( fi.absoluteFilePath() );
+                if ( pos == fEntries.end() )
+                    return false;
+
+                if ( ( *pos ).second.fRulesHash != rulesHash )   // the rules changed, the file may no longer be compliant, but the next check will redecide it
+                    return false;
+
+                if ( !isCurrent( ( *pos ).second, fi ) )
+                {
+                    fEntries.erase( pos );
+                    fDirty = true;
+                    return false;
+                }
+                return true;
+            }
+
+            void CComplianceStore::setCompliant( const QFileInfo &fi, const QByteArray &rulesHash, bool compliant )
+            {
+                if ( !compliant )
+                {
+                    QMutexLocker locker( &fMutex );
+                    loadIfNeeded();
+                    if ( fEntries.erase( fi.absoluteFilePath() ) )
+                        fDirty = true;
+                    return;
+                }
+
+                SEntry entry;
+                std::tie( entry.fSize, entry.fModified, entry.fInode ) = CMediaInfoCache::fileStamp( fi );
+                entry.fRulesHash = rulesHash;
+
+                QMutexLocker locker( &fMutex );
+                loadIfNeeded();
+                auto pos = fEntries.find( fi.absoluteFilePath() );
+                if ( ( pos != fEntries.end() ) && ( ( *pos ).second.fRulesHash == rulesHash ) && ( ( *pos ).second.fSize == entry.fSize ) && ( ( *pos ).second.fModified == entry.fModified ) && ( ( *pos ).second.fInode == entry.fInode ) )
+                    return;
+                fEntries[ fi.absoluteFilePath() ] = std::move( entry );
+                fDirty = true;
+            }
+
+            int CComplianceStore::prune()
+            {
+                QMutexLocker locker( &fMutex );
+                loadIfNeeded();
+
+                int retVal = 0;
+                for ( auto ii = fEntries.begin(); ii != fEntries.end(); )
+                {
+                    QFileInfo fi( ( *ii ).first );
+                    if ( !fi.exists() || !isCurrent( ( *ii ).second, fi ) )
+                    {
+                        ii = fEntries.erase( ii );
+                        retVal++;
+                    }
+                    else
+                        ++ii;
+                }
+                if ( retVal )
+                    fDirty = true;
+                locker.unlock();
+
+                save();
+                return retVal;
+            }
+
+            void CComplianceStore::loadIfNeeded()
+            {
+                if ( fLoaded )
+                    return;
+                fLoaded = true;
+
+                QFile file( storeFileName() );
+                if ( !file.open( QFile::ReadOnly ) )
+                    return;
+
+                QDataStream ds( &file );
+                ds.setVersion( QDataStream::Qt_5_12 );
+
+                quint32 magic = 0;
+                quint32 version = 0;
+                ds >> magic >> version;
+                if ( ( magic != sMagic ) || ( version != sVersion ) )
+                    return;
+
+                quint32 numEntries = 0;
+                ds >> numEntries;
+                fEntries.reserve( numEntries );
+                for ( quint32 ii = 0; ( ii < numEntries ) && ( ds.status() == QDataStream::Ok ); ++ii )
+                {
+                    QString path;
+                    SEntry entry;
+                    ds >> path >> entry.fSize >> entry.fModified >> entry.fInode >> entry.fRulesHash;
+                    fEntries[ path ] = std::move( entry );
+                }
+
+                if ( ds.status() != QDataStream::Ok )
+                    fEntries.clear();
+            }
+
+            bool CComplianceStore::save()
+            {
+                QMutexLocker locker( &fMutex );
+                if ( !fDirty )
+                    return true;
+
+                QSaveFile file( storeFileName() );
+                if ( !file.open( QFile::WriteOnly ) )
+                    return false;
+
+                QDataStream ds( &file );
+                ds.setVersion( QDataStream::Qt_5_12 );
+
+                ds << sMagic << sVersion << static_cast< quint32 >( fEntries.size() );
+                for ( auto &&ii : fEntries )
+                    ds << ii.first << ii.second.fSize << ii.second.fModified << ii.second.fInode << ii.second.fRulesHash;
+                if ( ds.status() != QDataStream::Ok )
+                {
+                    file.cancelWriting();
+                    return false;
+                }
+                if ( !file.commit() )
+                    return false;
+                fDirty = false;
+                return true;
+            }
+        }
+    }
+}
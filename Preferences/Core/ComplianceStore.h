@@ -0,0 +1,81 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_COMPLIANCESTORE_H
+#define _CORE_COMPLIANCESTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+#include <unordered_map>
+#include "SABUtils/QtHashUtils.h"
+
+class QFileInfo;
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            // persistent record of the files that needed no transcoding, keyed by the absolute path
+            // an entry only counts while the file size, mtime and inode and the transcode rules hash still match
+            class CComplianceStore
+            {
+            public:
+                static CComplianceStore *instance();
+
+                bool isCompliant( const QFileInfo &fi, const QByteArray &rulesHash );
+                void setCompliant( const QFileInfo &fi, const QByteArray &rulesHash, bool compliant );
+
+                int prune();   // removes the entries for missing or changed files, returns the number removed
+                bool save();   // only writes when something changed
+
+                static QString storeFileName();
+
+            private:
+                CComplianceStore();
+                void loadIfNeeded();
+
+                struct SEntry
+                {
+                    qint64 fSize{ 0 };
+                    qint64 fModified{ 0 };   // msecs since epoch
+                    quint64 fInode{ 0 };
+                    QByteArray fRulesHash;
+                };
+
+                static bool isCurrent( const SEntry &entry, const QFileInfo &fi );
+
+                bool fLoaded{ false };
+                bool fDirty{ false };
+                std::unordered_map< QString, SEntry > fEntries;
+                QMutex fMutex;
+
+                static const quint32 sMagic;
+                static const quint32 sVersion;
+            };
+        }
+    }
+}
+#endif
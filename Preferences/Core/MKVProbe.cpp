@@ -0,0 +1,476 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MKVProbe.h"
+#include "SABUtils/MediaInfo.h"
+#include "SABUtils/utils.h"
+
+#include <QFileInfo>
+#include <list>
+#include <memory>
+#include <functional>
+#include <unordered_set>
+
+extern "C"
+{
+#include "matroska2/matroska.h"
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            namespace
+            {
+                struct STrack
+                {
+                    int64_t fType{ 0 };   // 1 video, 2 audio, 17 subtitle
+                    int64_t fUID{ 0 };
+                    bool fDefault{ true };
+                    QString fCodecID;
+                    QString fLanguage{ "eng" };
+                    int64_t fWidth{ 0 };
+                    int64_t fHeight{ 0 };
+                    int64_t fDisplayWidth{ 0 };
+                    int64_t fDisplayHeight{ 0 };
+                    int64_t fChannels{ 0 };
+                };
+
+                struct SResult
+                {
+                    QString fTitle;
+                    double fSeconds{ 0.0 };
+                    std::list< STrack > fTracks;
+                    std::unordered_map< QString, QString > fGlobalTags;   // upper case tag name
+                };
+
+                // owns the core-c context, the stream and every element read, in that order of construction
+                class CMatroskaFile
+                {
+                public:
+                    CMatroskaFile( const QString &path )
+                    {
+                        ParserContext_Init( &fParser, nullptr, nullptr, nullptr );
+                        MATROSKA_Init( &fParser );
+
+                        tchar_t tPath[ MAXPATHFULL ];
+                        Node_FromUTF8( &fParser, tPath, TSIZEOF( tPath ), path.toUtf8().constData() );
+                        fInput = StreamOpen( &fParser, tPath, SFLAG_RDONLY );
+                    }
+
+                    ~CMatroskaFile()
+                    {
+                        for ( auto &&ii : fElements )
+                            NodeDelete( (node *)ii );
+                        if ( fInput )
+                            StreamClose( fInput );
+                        MATROSKA_Done( &fParser );
+                        ParserContext_Done( &fParser );
+                    }
+
+                    std::optional< SResult > read();
+
+                private:
+                    ebml_element *own( ebml_element *element )
+                    {
+                        if ( element )
+                            fElements.push_back( element );
+                        return element;
+                    }
+
+                    ebml_element *readElement( const ebml_parser_context *context )
+                    {
+                        int upperElement = 0;
+                        return own( EBML_FindNextElement( fInput, context, &upperElement, 1 ) );
+                    }
+
+                    QString toString( ebml_element *element );
+                    static int64_t toInt( ebml_element *element, int64_t defaultValue ) { return element ? EBML_IntegerValue( (ebml_integer *)element ) : defaultValue; }
+
+                    void readInfo( ebml_master *info, SResult &result );
+                    void readTracks( ebml_master *tracks, SResult &result );
+                    void readTags( ebml_master *tags, SResult &result );
+
+                    parsercontext fParser;
+                    stream *fInput{ nullptr };
+                    std::list< ebml_element * > fElements;
+                };
+
+                QString CMatroskaFile::toString( ebml_element *element )
+                {
+                    if ( !element )
+                        return {};
+
+                    tchar_t value[ 4096 ];
+                    EBML_StringGet( (ebml_string *)element, value, TSIZEOF( value ) );
+                    char utf8[ 4 * 4096 ];
+                    Node_ToUTF8( &fParser, utf8, sizeof( utf8 ), value );
+                    return QString::fromUtf8( utf8 );
+                }
+
+                std::optional< SResult > CMatroskaFile::read()
+                {
+                    if ( !fInput )
+                        return {};
+
+                    ebml_parser_context streamContext;
+                    streamContext.Context = MATROSKA_getContextStream();
+                    streamContext.UpContext = nullptr;
+                    streamContext.EndPosition = INVALID_FILEPOS_T;
+                    streamContext.Profile = 0;
+
+                    auto head = readElement( &streamContext );
+                    if ( !head || !EBML_ElementIsType( head, EBML_getContextHead() ) )
+                        return {};
+                    if ( EBML_ElementReadData( head, fInput, &streamContext, 0, SCOPE_ALL_DATA, 1 ) != ERR_NONE )
+                        return {};
+
+                    auto docType = toString( EBML_MasterGetChild( (ebml_master *)head, EBML_getContextDocType() ) );
+                    if ( ( docType != "matroska" ) && ( docType != "webm" ) )
+                        return {};
+
+                    auto segment = readElement( &streamContext );
+                    if ( !segment || !EBML_ElementIsType( segment, MATROSKA_getContextSegment() ) )
+                        return {};
+
+                    ebml_parser_context segmentContext;
+                    segmentContext.Context = MATROSKA_getContextSegment();
+                    segmentContext.UpContext = &streamContext;
+                    segmentContext.EndPosition = EBML_ElementPositionEnd( segment );
+                    segmentContext.Profile = 0;
+                    streamContext.EndPosition = segmentContext.EndPosition;
+
+                    SResult retVal;
+                    bool infoFound = false;
+                    bool tracksFound = false;
+                    bool tagsFound = false;
+                    ebml_master *seekHead = nullptr;
+
+                    // everything of interest sits in front of the first cluster, except the tags which are often written at the end
+                    auto level1 = readElement( &segmentContext );
+                    while ( level1 && !EBML_ElementIsType( level1, MATROSKA_getContextCluster() ) )
+                    {
+                        ebml_element *next = nullptr;
+                        bool isInfo = EBML_ElementIsType( level1, MATROSKA_getContextInfo() );
+                        bool isTracks = EBML_ElementIsType( level1, MATROSKA_getContextTracks() );
+                        bool isTags = EBML_ElementIsType( level1, MATROSKA_getContextTags() );
+                        bool isSeekHead = !seekHead && EBML_ElementIsType( level1, MATROSKA_getContextSeekHead() );
+                        if ( isInfo || isTracks || isTags || isSeekHead )
+                        {
+                            if ( EBML_ElementReadData( level1, fInput, &segmentContext, 1, SCOPE_ALL_DATA, 4 ) != ERR_NONE )
+                                return {};
+                            NodeTree_SetParent( level1, segment, nullptr );   // the seek positions are relative to the segment, and the segment now owns it
+                            fElements.remove( level1 );
+
+                            if ( isInfo )
+                            {
+                                readInfo( (ebml_master *)level1, retVal );
+                                infoFound = true;
+                            }
+                            else if ( isTracks )
+                            {
+                                readTracks( (ebml_master *)level1, retVal );
+                                tracksFound = true;
+                            }
+                            else if ( isTags )
+                            {
+                                readTags( (ebml_master *)level1, retVal );
+                                tagsFound = true;
+                            }
+                            else
+                                seekHead = (ebml_master *)level1;
+                        }
+                        else
+                            next = own( EBML_ElementSkipData( level1, fInput, &segmentContext, nullptr, 1 ) );
+
+                        level1 = next ? next : readElement( &segmentContext );
+                    }
+
+                    if ( !infoFound || !tracksFound )
+                        return {};
+
+                    if ( !tagsFound && seekHead )
+                    {
+                        for ( auto seekPoint = EBML_MasterFindChild( seekHead, MATROSKA_getContextSeek() ); seekPoint; seekPoint = EBML_MasterNextChild( seekHead, seekPoint ) )
+                        {
+                            if ( !MATROSKA_MetaSeekIsClass( (matroska_seekpoint *)seekPoint, MATROSKA_getContextTags() ) )
+                                continue;
+
+                            auto pos = MATROSKA_MetaSeekAbsolutePos( (matroska_seekpoint *)seekPoint );
+                            if ( ( pos == INVALID_FILEPOS_T ) || ( Stream_Seek( fInput, pos, SEEK_SET ) != pos ) )
+                                break;
+
+                            auto tags = readElement( &segmentContext );
+                            if ( tags && EBML_ElementIsType( tags, MATROSKA_getContextTags() ) && ( EBML_ElementReadData( tags, fInput, &segmentContext, 1, SCOPE_ALL_DATA, 4 ) == ERR_NONE ) )
+                                readTags( (ebml_master *)tags, retVal );
+                            break;
+                        }
+                    }
+                    return retVal;
+                }
+
+                void CMatroskaFile::readInfo( ebml_master *info, SResult &result )
+                {
+                    auto timestampScale = toInt( EBML_MasterFindChild( info, MATROSKA_getContextTimestampScale() ), 1000000 );
+                    auto duration = EBML_MasterFindChild( info, MATROSKA_getContextDuration() );
+                    if ( duration )
+                        result.fSeconds = EBML_FloatValue( (ebml_float *)duration ) * timestampScale / 1000000000.0;
+                    result.fTitle = toString( EBML_MasterFindChild( info, MATROSKA_getContextTitle() ) );
+                }
+
+                void CMatroskaFile::readTracks( ebml_master *tracks, SResult &result )
+                {
+                    for ( auto entry = EBML_MasterFindChild( tracks, MATROSKA_getContextTrackEntry() ); entry; entry = EBML_MasterNextChild( tracks, entry ) )
+                    {
+                        STrack track;
+                        track.fType = toInt( EBML_MasterFindChild( entry, MATROSKA_getContextTrackType() ), 0 );
+                        track.fUID = toInt( EBML_MasterFindChild( entry, MATROSKA_getContextTrackUID() ), 0 );
+                        track.fDefault = toInt( EBML_MasterFindChild( entry, MATROSKA_getContextFlagDefault() ), 1 ) != 0;
+                        track.fCodecID = toString( EBML_MasterFindChild( entry, MATROSKA_getContextCodecID() ) );
+                        auto language = toString( EBML_MasterFindChild( entry, MATROSKA_getContextLanguage() ) );
+                        if ( !language.isEmpty() )
+                            track.fLanguage = language;
+
+                        if ( auto video = EBML_MasterFindChild( entry, MATROSKA_getContextVideo() ) )
+                        {
+                            track.fWidth = toInt( EBML_MasterFindChild( video, MATROSKA_getContextPixelWidth() ), 0 );
+                            track.fHeight = toInt( EBML_MasterFindChild( video, MATROSKA_getContextPixelHeight() ), 0 );
+                            track.fDisplayWidth = toInt( EBML_MasterFindChild( video, MATROSKA_getContextDisplayWidth() ), track.fWidth );
+                            track.fDisplayHeight = toInt( EBML_MasterFindChild( video, MATROSKA_getContextDisplayHeight() ), track.fHeight );
+                        }
+                        if ( auto audio = EBML_MasterFindChild( entry, MATROSKA_getContextAudio() ) )
+                            track.fChannels = toInt( EBML_MasterFindChild( audio, MATROSKA_getContextChannels() ), 1 );
+
+                        result.fTracks.push_back( track );
+                    }
+                }
+
+                void CMatroskaFile::readTags( ebml_master *tags, SResult &result )
+                {
+                    for ( auto tag = EBML_MasterFindChild( tags, MATROSKA_getContextTag() ); tag; tag = EBML_MasterNextChild( tags, tag ) )
+                    {
+                        // only the tags that apply to the whole file, the same ones ffprobe reports as format tags
+                        auto targets = EBML_MasterFindChild( tag, MATROSKA_getContextTargets() );
+                        if ( targets )
+                        {
+                            if ( EBML_MasterFindChild( targets, MATROSKA_getContextTagTrackUID() ) )
+                                continue;
+                            if ( toInt( EBML_MasterFindChild( targets, MATROSKA_getContextTargetTypeValue() ), 50 ) != 50 )
+                                continue;
+                        }
+
+                        for ( auto simpleTag = EBML_MasterFindChild( tag, MATROSKA_getContextSimpleTag() ); simpleTag; simpleTag = EBML_MasterNextChild( tag, simpleTag ) )
+                        {
+                            auto name = toString( EBML_MasterFindChild( simpleTag, MATROSKA_getContextTagName() ) ).toUpper();
+                            if ( !name.isEmpty() && ( result.fGlobalTags.find( name ) == result.fGlobalTags.end() ) )
+                                result.fGlobalTags[ name ] = toString( EBML_MasterFindChild( simpleTag, MATROSKA_getContextTagString() ) );
+                        }
+                    }
+                }
+
+                // matroska CodecIDs to the codec names ffprobe reports, prefix matches end with a '/'
+                QString codecName( const QString &codecID )
+                {
+                    static const std::list< std::pair< QString, QString > > sCodecs = {
+                        { "V_MPEGH/ISO/HEVC", "hevc" },
+                        { "V_MPEG4/ISO/AVC", "h264" },
+                        { "V_MPEG4/ISO/", "mpeg4" },
+                        { "V_AV1", "av1" },
+                        { "V_VP9", "vp9" },
+                        { "V_VP8", "vp8" },
+                        { "V_MPEG2", "mpeg2video" },
+                        { "V_MPEG1", "mpeg1video" },
+                        { "V_THEORA", "theora" },
+                        { "S_TEXT/UTF8", "subrip" },
+                        { "S_TEXT/ASS", "ass" },
+                        { "S_TEXT/SSA", "ass" },
+                        { "S_TEXT/WEBVTT", "webvtt" },
+                        { "S_HDMV/PGS", "hdmv_pgs_subtitle" },
+                        { "S_VOBSUB", "dvd_subtitle" },
+                    };
+                    for ( auto &&ii : sCodecs )
+                    {
+                        if ( ii.first.endsWith( '/' ) ? codecID.startsWith( ii.first ) : ( codecID == ii.first ) )
+                            return ii.second;
+                    }
+                    return {};
+                }
+
+                // every track of the type in file order, empty when one of them has an unknown value
+                std::optional< QStringList > allTracks( const SResult &result, int64_t type, const std::function< QString( const STrack &track ) > &func )
+                {
+                    QStringList retVal;
+                    for ( auto &&ii : result.fTracks )
+                    {
+                        if ( ii.fType != type )
+                            continue;
+                        auto value = func( ii );
+                        if ( value.isEmpty() )
+                            return {};
+                        retVal << value;
+                    }
+                    return retVal;
+                }
+
+                const STrack *defaultTrack( const SResult &result, int64_t type )
+                {
+                    const STrack *retVal = nullptr;
+                    for ( auto &&ii : result.fTracks )
+                    {
+                        if ( ( ii.fType == type ) && ( !retVal || ( ii.fDefault && !retVal->fDefault ) ) )
+                            retVal = &ii;
+                    }
+                    return retVal;
+                }
+
+                CMKVProbe::TMediaTags toMediaTags( const SResult &result )
+                {
+                    auto globalTag = [ &result ]( const QStringList &names )
+                    {
+                        for ( auto &&ii : names )
+                        {
+                            auto pos = result.fGlobalTags.find( ii );
+                            if ( pos != result.fGlobalTags.end() )
+                                return ( *pos ).second;
+                        }
+                        return QString();
+                    };
+
+                    CMKVProbe::TMediaTags retVal;
+                    retVal[ NSABUtils::EMediaTags::eTitle ] = result.fTitle.isEmpty() ? globalTag( { "TITLE" } ) : result.fTitle;
+                    retVal[ NSABUtils::EMediaTags::eDate ] = globalTag( { "DATE_RELEASED", "DATE", "DATE_RECORDED" } );
+                    retVal[ NSABUtils::EMediaTags::eComment ] = globalTag( { "COMMENT", "DESCRIPTION" } );
+                    retVal[ NSABUtils::EMediaTags::eArtist ] = globalTag( { "ARTIST", "LEAD_PERFORMER" } );
+                    retVal[ NSABUtils::EMediaTags::eAlbumArtist ] = globalTag( { "ALBUM_ARTIST" } );
+                    retVal[ NSABUtils::EMediaTags::eAlbum ] = globalTag( { "ALBUM" } );
+                    retVal[ NSABUtils::EMediaTags::eComposer ] = globalTag( { "COMPOSER" } );
+                    retVal[ NSABUtils::EMediaTags::eGenre ] = globalTag( { "GENRE" } );
+                    retVal[ NSABUtils::EMediaTags::eTrack ] = globalTag( { "PART_NUMBER", "TRACK" } );
+                    retVal[ NSABUtils::EMediaTags::eDiscnumber ] = globalTag( { "DISC", "DISCNUMBER" } );
+                    retVal[ NSABUtils::EMediaTags::eBPM ] = globalTag( { "BPM" } );
+
+                    if ( result.fSeconds > 0 )
+                        retVal[ NSABUtils::EMediaTags::eLength ] = NSABUtils::CTimeString( static_cast< uint64_t >( result.fSeconds * 1000 ) ).toString( "hh:mm:ss.zzz" );
+
+                    auto video = defaultTrack( result, 1 );
+                    auto audio = defaultTrack( result, 2 );
+
+                    if ( video && video->fWidth && video->fHeight )
+                    {
+                        retVal[ NSABUtils::EMediaTags::eWidth ] = QString::number( video->fWidth );
+                        retVal[ NSABUtils::EMediaTags::eHeight ] = QString::number( video->fHeight );
+                        retVal[ NSABUtils::EMediaTags::eResolution ] = QString( "%1x%2" ).arg( video->fWidth ).arg( video->fHeight );
+                        if ( video->fDisplayHeight )
+                            retVal[ NSABUtils::EMediaTags::eAspectRatio ] = QString::number( static_cast< double >( video->fDisplayWidth ) / video->fDisplayHeight );
+                    }
+                    if ( audio )
+                        retVal[ NSABUtils::EMediaTags::eAudioChannelCount ] = QString::number( audio->fChannels );
+
+                    auto byCodec = []( const STrack &track ) { return codecName( track.fCodecID ); };
+                    if ( auto videoCodecs = allTracks( result, 1, byCodec ) )
+                        retVal[ NSABUtils::EMediaTags::eAllVideoCodecs ] = videoCodecs.value().join( ", " );
+                    if ( auto subtitleCodecs = allTracks( result, 17, byCodec ) )
+                        retVal[ NSABUtils::EMediaTags::eAllSubtitleCodecs ] = subtitleCodecs.value().join( ", " );
+                    if ( auto subtitleLanguages = allTracks( result, 17, []( const STrack &track ) { return track.fLanguage; } ) )
+                        retVal[ NSABUtils::EMediaTags::eAllSubtitleLanguages ] = subtitleLanguages.value().join( ", " );
+
+                    return retVal;
+                }
+            }
+
+            bool CMKVProbe::canProbe( const QFileInfo &fi )
+            {
+                auto suffix = fi.suffix().toLower();
+                return ( suffix == "mkv" ) || ( suffix == "mka" ) || ( suffix == "webm" );
+            }
+
+            bool CMKVProbe::canSupply( const std::list< NSABUtils::EMediaTags > &tags )
+            {
+                static const std::unordered_set< NSABUtils::EMediaTags > sSupplied = {
+                    NSABUtils::EMediaTags::eTitle,
+                    NSABUtils::EMediaTags::eDate,
+                    NSABUtils::EMediaTags::eComment,
+                    NSABUtils::EMediaTags::eArtist,
+                    NSABUtils::EMediaTags::eAlbumArtist,
+                    NSABUtils::EMediaTags::eAlbum,
+                    NSABUtils::EMediaTags::eComposer,
+                    NSABUtils::EMediaTags::eGenre,
+                    NSABUtils::EMediaTags::eTrack,
+                    NSABUtils::EMediaTags::eDiscnumber,
+                    NSABUtils::EMediaTags::eBPM,
+                    NSABUtils::EMediaTags::eLength,
+                    NSABUtils::EMediaTags::eWidth,
+                    NSABUtils::EMediaTags::eHeight,
+                    NSABUtils::EMediaTags::eAspectRatio,
+                    NSABUtils::EMediaTags::eResolution,
+                    NSABUtils::EMediaTags::eAudioChannelCount,
+                    NSABUtils::EMediaTags::eAllVideoCodecs,
+                    NSABUtils::EMediaTags::eAllSubtitleCodecs,
+                    NSABUtils::EMediaTags::eAllSubtitleLanguages,
+                };
+                for ( auto &&ii : tags )
+                {
+                    if ( sSupplied.find( ii ) == sSupplied.end() )
+                        return false;
+                }
+                return !tags.empty();
+            }
+
+            std::optional< CMKVProbe::TMediaTags > CMKVProbe::probe( const QFileInfo &fi )
+            {
+                if ( !canProbe( fi ) )
+                    return {};
+
+                CMatroskaFile file( fi.absoluteFilePath() );
+                auto result = file.read();
+                if ( !result.has_value() )
+                    return {};
+                return toMediaTags( result.value() );
+            }
+
+            std::optional< CMKVProbe::SVideoSummary > CMKVProbe::probeVideo( const QFileInfo &fi )
+            {
+                if ( !canProbe( fi ) )
+                    return {};
+
+                CMatroskaFile file( fi.absoluteFilePath() );
+                auto result = file.read();
+                if ( !result.has_value() )
+                    return {};
+
+                auto video = defaultTrack( result.value(), 1 );
+                if ( !video || !video->fWidth || !video->fHeight || ( result.value().fSeconds <= 0 ) )
+                    return {};
+
+                SVideoSummary retVal;
+                retVal.fWidth = static_cast< int >( video->fWidth );
+                retVal.fHeight = static_cast< int >( video->fHeight );
+                if ( video->fDisplayHeight )
+                    retVal.fAspectRatio = static_cast< double >( video->fDisplayWidth ) / video->fDisplayHeight;
+                retVal.fSeconds = result.value().fSeconds;
+                return retVal;
+            }
+        }
+    }
+}
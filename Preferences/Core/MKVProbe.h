@@ -0,0 +1,73 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_MKVPROBE_H
+#define _CORE_MKVPROBE_H
+
+#include <QString>
+#include <unordered_map>
+#include <optional>
+#include <list>
+#include "SABUtils/QtHashUtils.h"
+
+class QFileInfo;
+namespace NSABUtils
+{
+    enum class EMediaTags;
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            // in process matroska/webm probe built on the bundled libmatroska2
+            // only the EBML head, SeekHead, Info, Tracks and Tags are read, the clusters are never touched
+            class CMKVProbe
+            {
+            public:
+                using TMediaTags = std::unordered_map< NSABUtils::EMediaTags, QString >;
+
+                struct SVideoSummary
+                {
+                    int fWidth{ 0 };
+                    int fHeight{ 0 };
+                    double fAspectRatio{ 0.0 };   // display w/h, 0 when not stored
+                    double fSeconds{ 0.0 };
+                };
+
+                static bool canProbe( const QFileInfo &fi );
+                static bool canSupply( const std::list< NSABUtils::EMediaTags > &tags );   // true when every tag is one the headers can give, ffprobe is only skipped then
+
+                // returns nothing when the file is not a readable matroska file
+                // the map only contains the tags that can be computed without ffprobe
+                // codecs are mapped from the CodecID to ffprobe's codec names, a tag is left out when a track's CodecID is not known
+                static std::optional< TMediaTags > probe( const QFileInfo &fi );
+
+                // the default video track's geometry and the duration, unformatted
+                static std::optional< SVideoSummary > probeVideo( const QFileInfo &fi );
+            };
+        }
+    }
+}
+#endif
@@ -0,0 +1,277 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MediaInfoCache.h"
+#include "SABUtils/MediaInfo.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+    #include <sys/stat.h>
+#endif
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            const quint32 CMediaInfoCache::sMagic = 0x4d4d4d43;   // MMMC
+            const quint32 CMediaInfoCache::sVersion = 2;
+
+            CMediaInfoCache *CMediaInfoCache::instance()
+            {
+                static CMediaInfoCache retVal;
+                return &retVal;
+            }
+
+            CMediaInfoCache::CMediaInfoCache()
+            {
+            }
+
+            QString CMediaInfoCache::cacheFileName()
+            {
+                auto appDataDir = QDir( QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) );
+                if ( !appDataDir.exists() )
+                    appDataDir.mkpath( "." );
+                return appDataDir.absoluteFilePath( "MediaInfoCache.dat" );
+            }
+
+            std::tuple< qint64, qint64, quint64 > CMediaInfoCache::fileStamp( const QFileInfo &fi )
+            {
+                quint64 inode = 0;
+#ifdef Q_OS_UNIX
+                struct stat statBuf;
+                if ( ::stat( QFile::encodeName( fi.absoluteFilePath() ).constData(), &statBuf ) == 0 )
+                    inode = static_cast< quint64 >( statBuf.st_ino );
+#endif
+                return { fi.size(), fi.lastModified().toMSecsSinceEpoch(), inode };
+            }
+
+            bool CMediaInfoCache::isCurrent( const SEntry &entry, const std::tuple< qint64, qint64, quint64 > &stamp )
+            {
+                return ( entry.fSize == std::get< 0 >( stamp ) ) && ( entry.fModified == std::get< 1 >( stamp ) ) && ( entry.fInode == std::get< 2 >( stamp ) );
+            }
+
+            CMediaInfoCache::SEntry *CMediaInfoCache::currentEntry( const QFileInfo &fi, bool create )
+            {
+                auto stamp = fileStamp( fi );
+                loadIfNeeded();
+
+                auto path = fi.absoluteFilePath();
+                auto pos = fEntries.find( path );
+                if ( ( pos != fEntries.end() ) && !isCurrent( ( *pos ).second, stamp ) )
+                {
+                    fEntries.erase( pos );
+                    fDirty = true;
+                    pos = fEntries.end();
+                }
+
+                if ( pos != fEntries.end() )
+                    return &( *pos ).second;
+                if ( !create )
+                    return nullptr;
+
+                auto &&entry = fEntries[ path ];
+                std::tie( entry.fSize, entry.fModified, entry.fInode ) = stamp;
+                return &entry;
+            }
+
+            std::optional< CMediaInfoCache::TMediaTags > CMediaInfoCache::find( const QFileInfo &fi, const std::list< NSABUtils::EMediaTags > &tags )
+            {
+                QMutexLocker locker( &fMutex );
+                auto entry = currentEntry( fi, false );
+                if ( !entry || entry->fTags.empty() )
+                    return {};
+
+                auto &&cachedTags = entry->fTags;
+                TMediaTags retVal;
+                if ( tags.empty() )
+                {
+                    for ( auto &&ii : cachedTags )
+                        retVal[ static_cast< NSABUtils::EMediaTags >( ii.first ) ] = ii.second;
+                    return retVal;
+                }
+
+                for ( auto &&ii : tags )
+                {
+                    auto tagPos = cachedTags.find( static_cast< int >( ii ) );
+                    if ( tagPos == cachedTags.end() )
+                        return {};
+                    retVal[ ii ] = ( *tagPos ).second;
+                }
+                return retVal;
+            }
+
+            void CMediaInfoCache::add( const QFileInfo &fi, const TMediaTags &tags )
+            {
+                if ( tags.empty() )
+                    return;
+
+                QMutexLocker locker( &fMutex );
+                auto entry = currentEntry( fi, true );
+                entry->fTags.clear();
+                for ( auto &&ii : tags )
+                    entry->fTags[ static_cast< int >( ii.first ) ] = ii.second;
+                fDirty = true;
+            }
+
+            std::optional< STranscodeSummary > CMediaInfoCache::findTranscodeSummary( const QFileInfo &fi, const QByteArray &rulesHash )
+            {
+                QMutexLocker locker( &fMutex );
+                auto entry = currentEntry( fi, false );
+                if ( !entry || !entry->fTranscode.has_value() || ( entry->fTranscode.value().fRulesHash != rulesHash ) )
+                    return {};
+                return entry->fTranscode;
+            }
+
+            void CMediaInfoCache::addTranscodeSummary( const QFileInfo &fi, const STranscodeSummary &summary )
+            {
+                QMutexLocker locker( &fMutex );
+                currentEntry( fi, true )->fTranscode = summary;
+                fDirty = true;
+            }
+
+            int CMediaInfoCache::prune()
+            {
+                QMutexLocker locker( &fMutex );
+                loadIfNeeded();
+
+                int retVal = 0;
+                for ( auto ii = fEntries.begin(); ii != fEntries.end(); )
+                {
+                    QFileInfo fi( ( *ii ).first );
+                    if ( !fi.exists() || !isCurrent( ( *ii ).second, fileStamp( fi ) ) )
+                    {
+                        ii = fEntries.erase( ii );
+                        retVal++;
+                    }
+                    else
+                        ++ii;
+                }
+                if ( retVal )
+                    fDirty = true;
+                locker.unlock();
+
+                save();
+                return retVal;
+            }
+
+            void CMediaInfoCache::loadIfNeeded()
+            {
+                if ( fLoaded )
+                    return;
+                fLoaded = true;
+
+                QFile file( cacheFileName() );
+                if ( !file.open( QFile::ReadOnly ) )
+                    return;
+
+                QDataStream ds( &file );
+                ds.setVersion( QDataStream::Qt_5_12 );
+
+                quint32 magic = 0;
+                quint32 version = 0;
+                ds >> magic >> version;
+                if ( ( magic != sMagic ) || ( version != sVersion ) )
+                    return;
+
+                quint32 numEntries = 0;
+                ds >> numEntries;
+                fEntries.reserve( numEntries );
+                for ( quint32 ii = 0; ( ii < numEntries ) && ( ds.status() == QDataStream::Ok ); ++ii )
+                {
+                    QString path;
+                    SEntry entry;
+                    quint32 numTags = 0;
+                    ds >> path >> entry.fSize >> entry.fModified >> entry.fInode >> numTags;
+                    for ( quint32 jj = 0; ( jj < numTags ) && ( ds.status() == QDataStream::Ok ); ++jj )
+                    {
+                        qint32 tag = 0;
+                        QString value;
+                        ds >> tag >> value;
+                        entry.fTags[ tag ] = value;
+                    }
+
+                    bool hasTranscode = false;
+                    ds >> hasTranscode;
+                    if ( hasTranscode )
+                    {
+                        STranscodeSummary summary;
+                        ds >> summary.fRulesHash >> summary.fWrongContainer >> summary.fWrongVideoCodec >> summary.fWrongAudioCodec >> summary.fDefaultAudioNotAAC >> summary.fBitrateTooHigh >> summary.fResolutionTooHigh;
+                        ds >> summary.fTargetBitrateKbps >> summary.fTargetBitrateDisplay >> summary.fSeconds >> summary.fNumAudioStreams >> summary.fNumSubtitleStreams;
+                        entry.fTranscode = summary;
+                    }
+                    fEntries[ path ] = std::move( entry );
+                }
+
+                if ( ds.status() != QDataStream::Ok )
+                    fEntries.clear();
+            }
+
+            bool CMediaInfoCache::save()
+            {
+                QMutexLocker locker( &fMutex );
+                if ( !fDirty )
+                    return true;
+
+                QSaveFile file( cacheFileName() );
+                if ( !file.open( QFile::WriteOnly ) )
+                    return false;
+
+                QDataStream ds( &file );
+                ds.setVersion( QDataStream::Qt_5_12 );
+
+                ds << sMagic << sVersion << static_cast< quint32 >( fEntries.size() );
+                for ( auto &&ii : fEntries )
+                {
+                    ds << ii.first << ii.second.fSize << ii.second.fModified << ii.second.fInode << static_cast< quint32 >( ii.second.fTags.size() );
+                    for ( auto &&jj : ii.second.fTags )
+                        ds << static_cast< qint32 >( jj.first ) << jj.second;
+
+                    ds << ii.second.fTranscode.has_value();
+                    if ( ii.second.fTranscode.has_value() )
+                    {
+                        auto &&summary = ii.second.fTranscode.value();
+                        ds << summary.fRulesHash << summary.fWrongContainer << summary.fWrongVideoCodec << summary.fWrongAudioCodec << summary.fDefaultAudioNotAAC << summary.fBitrateTooHigh << summary.fResolutionTooHigh;
+                        ds << summary.fTargetBitrateKbps << summary.fTargetBitrateDisplay << summary.fSeconds << summary.fNumAudioStreams << summary.fNumSubtitleStreams;
+                    }
+                }
+                if ( ds.status() != QDataStream::Ok )
+                {
+                    file.cancelWriting();
+                    return false;
+                }
+                if ( !file.commit() )
+                    return false;
+                fDirty = false;
+                return true;
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_MEDIAINFOCACHE_H
+#define _CORE_MEDIAINFOCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+#include <unordered_map>
+#include <optional>
+#include <list>
+#include <tuple>
+#include "SABUtils/QtHashUtils.h"
+
+class QFileInfo;
+namespace NSABUtils
+{
+    enum class EMediaTags;
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            // what the transcode page needs from a probe, so a file planned in an earlier session is only probed again when it is transcoded
+            // the decisions are CMediaInfo's codec and resolution checks against the transcode rules, they only hold for the rules hash they were made under
+            struct STranscodeSummary
+            {
+                QByteArray fRulesHash;
+                bool fWrongContainer{ false };
+                bool fWrongVideoCodec{ false };
+                bool fWrongAudioCodec{ false };
+                bool fDefaultAudioNotAAC{ false };
+                bool fBitrateTooHigh{ false };
+                bool fResolutionTooHigh{ false };
+                quint64 fTargetBitrateKbps{ 0 };
+                QString fTargetBitrateDisplay;
+
+                double fSeconds{ 0.0 };
+                qint32 fNumAudioStreams{ 0 };
+                qint32 fNumSubtitleStreams{ 0 };
+            };
+
+            // persistent cache of the media tags read by ffprobe and the transcode summary, keyed by the absolute path
+            // an entry is only used while the file size, mtime and inode still match
+            class CMediaInfoCache
+            {
+            public:
+                using TMediaTags = std::unordered_map< NSABUtils::EMediaTags, QString >;
+
+                static CMediaInfoCache *instance();
+
+                // returns nothing if the file is not cached, has changed or is missing one of the tags
+                // an empty tag list returns every cached tag
+                std::optional< TMediaTags > find( const QFileInfo &fi, const std::list< NSABUtils::EMediaTags > &tags );
+                void add( const QFileInfo &fi, const TMediaTags &tags );
+
+                // returns nothing if the file changed or was planned under other transcode rules
+                std::optional< STranscodeSummary > findTranscodeSummary( const QFileInfo &fi, const QByteArray &rulesHash );
+                void addTranscodeSummary( const QFileInfo &fi, const STranscodeSummary &summary );
+
+                int prune();   // removes the entries for missing or changed files, returns the number removed
+                bool save();   // only writes when something changed
+
+                static QString cacheFileName();
+                static std::tuple< qint64, qint64, quint64 > fileStamp( const QFileInfo &fi );   // size, msecs modified, inode
+
+            private:
+                CMediaInfoCache();
+                void loadIfNeeded();
+
+                struct SEntry
+                {
+                    qint64 fSize{ 0 };
+                    qint64 fModified{ 0 };   // msecs since epoch
+                    quint64 fInode{ 0 };
+                    std::unordered_map< int, QString > fTags;
+                    std::optional< STranscodeSummary > fTranscode;
+                };
+
+                static bool isCurrent( const SEntry &entry, const std::tuple< qint64, qint64, quint64 > &stamp );
+                SEntry *currentEntry( const QFileInfo &fi, bool create );   // fMutex must be held, drops the entry when the file changed
+
+                bool fLoaded{ false };
+                bool fDirty{ false };
+                std::unordered_map< QString, SEntry > fEntries;
+                QMutex fMutex;
+
+                static const quint32 sMagic;
+                static const quint32 sVersion;
+            };
+        }
+    }
+}
+#endif
@@ -0,0 +1,323 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MediaProbePool.h"
+#include "MediaInfoCache.h"
+#include "MKVProbe.h"
+#include "SABUtils/MediaInfo.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStorageInfo>
+#include <QThread>
+#include <QFile>
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            int CMediaProbePool::sMaxResults = 4096;
+
+            CMediaProbePool *CMediaProbePool::instance()
+            {
+                static CMediaProbePool retVal;
+                return &retVal;
+            }
+
+            CMediaProbePool::CMediaProbePool()
+            {
+                fPool.setMaxThreadCount( std::max( 1, QThread::idealThreadCount() ) );
+            }
+
+            CMediaProbePool::~CMediaProbePool()
+            {
+                shutdown();
+            }
+
+            void CMediaProbePool::cancelAll()
+            {
+                QMutexLocker locker( &fMutex );
+                fQueue.clear();
+                fQueued.clear();
+            }
+
+            void CMediaProbePool::shutdown()
+            {
+                {
+                    QMutexLocker locker( &fMutex );
+                    fShutdown = true;
+                    fQueue.clear();
+                    fQueued.clear();
+                }
+                fPool.waitForDone();
+            }
+
+            int CMediaProbePool::computeNumThreads( const QString &rootPath )
+            {
+                auto numCores = std::max( 1, QThread::idealThreadCount() );
+
+                QStorageInfo storage( rootPath );
+                if ( !storage.isValid() )
+                    return numCores;
+
+                // ffprobe on a network share is dominated by latency, keep more requests in flight
+                static const QStringList sNetworkFileSystems = { "nfs", "nfs4", "cifs", "smbfs", "smb2", "fuse.sshfs", "9p", "afpfs" };
+                if ( sNetworkFileSystems.contains( QString::fromLatin1( storage.fileSystemType() ).toLower() ) )
+                    return std::min( numCores * 2, 32 );
+
+#ifdef Q_OS_LINUX
+                // a spinning disk seeks itself to death with more than a couple of readers
+                auto deviceName = QFileInfo( QString::fromLatin1( storage.device() ) ).fileName();
+                for ( auto &&ii : { QString( "/sys/class/block/%1/queue/rotational" ), QString( "/sys/class/block/%1/../queue/rotational" ) } )
+                {
+                    QFile file( ii.arg( deviceName ) );
+                    if ( !file.open( QFile::ReadOnly ) )
+                        continue;
+                    if ( file.readAll().trimmed() == "1" )
+                        return std::min( numCores, 2 );
+                    break;
+                }
+#endif
+                return numCores;
+            }
+
+            void CMediaProbePool::setStorageHint( const QString &rootPath )
+            {
+                auto numThreads = computeNumThreads( rootPath );
+
+                QMutexLocker locker( &fMutex );
+                if ( numThreads == fPool.maxThreadCount() )
+                    return;
+                fPool.setMaxThreadCount( numThreads );
+                startRunners();
+            }
+
+            std::shared_ptr< NSABUtils::CMediaInfo > CMediaProbePool::find( const QFileInfo &fi ) const
+            {
+                QMutexLocker locker( &fMutex );
+                auto pos = fResults.find( fi.absoluteFilePath() );
+                if ( ( pos == fResults.end() ) || ( ( *pos ).second.fModified != fi.lastModified().toMSecsSinceEpoch() ) )
+                {
+                    fMisses++;
+                    return {};
+                }
+                fHits++;
+                fLRU.splice( fLRU.begin(), fLRU, ( *pos ).second.fLRUPos );
+                return ( *pos ).second.fMediaInfo;
+            }
+
+            void CMediaProbePool::addResult( const QString &path, qint64 modified, std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo )
+            {
+                auto pos = fResults.find( path );
+                if ( pos != fResults.end() )
+                    fLRU.erase( ( *pos ).second.fLRUPos );
+
+                fLRU.push_front( path );
+                auto &&result = fResults[ path ];
+                result.fModified = modified;
+                result.fMediaInfo = mediaInfo;
+                result.fLRUPos = fLRU.begin();
+
+                while ( static_cast< int >( fResults.size() ) > sMaxResults )
+                {
+                    fResults.erase( fLRU.back() );
+                    fLRU.pop_back();
+                }
+            }
+
+            void CMediaProbePool::request( const QFileInfo &fi, EPriority priority )
+            {
+                enqueue( fi, priority, false );
+            }
+
+            void CMediaProbePool::requestContainerTags( const QFileInfo &fi, EPriority priority )
+            {
+                enqueue( fi, priority, true );
+            }
+
+            void CMediaProbePool::enqueue( const QFileInfo &fi, EPriority priority, bool containerOnly )
+            {
+                auto path = fi.absoluteFilePath();
+
+                QMutexLocker locker( &fMutex );
+                if ( fShutdown || ( fRunning.find( path ) != fRunning.end() ) )
+                    return;
+
+                if ( ( priority == EPriority::eBackground ) && ( fVisible.find( path ) != fVisible.end() ) )
+                    priority = EPriority::eVisible;
+
+                if ( fQueued.find( path ) != fQueued.end() )
+                {
+                    if ( !containerOnly )
+                        fQueued[ path ].fContainerOnly = false;   // a full probe covers the container tags too
+                    if ( fQueued[ path ].fPriority < priority )
+                        reprioritize( path, priority );
+                    return;
+                }
+
+                SRequest request;
+                request.fPriority = priority;
+                request.fSequence = fNextSequence++;   // discovery order within a priority
+                request.fContainerOnly = containerOnly;
+                fQueued[ path ] = request;
+                fQueue.insert( { -static_cast< int >( priority ), request.fSequence, path } );
+                startRunners();
+            }
+
+            void CMediaProbePool::prioritize( const QString &path, EPriority priority )
+            {
+                QMutexLocker locker( &fMutex );
+                auto pos = fQueued.find( path );
+                if ( ( pos != fQueued.end() ) && ( ( *pos ).second.fPriority < priority ) )
+                    reprioritize( path, priority );
+            }
+
+            void CMediaProbePool::setVisible( const QStringList &paths )
+            {
+                std::unordered_set< QString > visible( paths.begin(), paths.end() );
+
+                QMutexLocker locker( &fMutex );
+                for ( auto &&ii : fVisible )
+                {
+                    if ( visible.find( ii ) != visible.end() )
+                        continue;
+                    auto pos = fQueued.find( ii );
+                    if ( ( pos != fQueued.end() ) && ( ( *pos ).second.fPriority == EPriority::eVisible ) )
+                        reprioritize( ii, EPriority::eBackground );
+                }
+                for ( auto &&ii : visible )
+                {
+                    auto pos = fQueued.find( ii );
+                    if ( ( pos != fQueued.end() ) && ( ( *pos ).second.fPriority < EPriority::eVisible ) )
+                        reprioritize( ii, EPriority::eVisible );
+                }
+                fVisible = std::move( visible );
+            }
+
+            void CMediaProbePool::reprioritize( const QString &path, EPriority priority )
+            {
+                auto &&request = fQueued[ path ];
+                if ( request.fPriority == priority )
+                    return;
+                fQueue.erase( { -static_cast< int >( request.fPriority ), request.fSequence, path } );
+                request.fPriority = priority;
+                fQueue.insert( { -static_cast< int >( request.fPriority ), request.fSequence, path } );
+            }
+
+            void CMediaProbePool::startRunners()
+            {
+                while ( ( fNumRunners < fPool.maxThreadCount() ) && ( static_cast< size_t >( fNumRunners ) < fQueue.size() ) )
+                {
+                    fNumRunners++;
+                    fPool.start( [ this ]() { runProbes(); } );
+                }
+            }
+
+            void CMediaProbePool::runProbes()
+            {
+                while ( true )
+                {
+                    QString path;
+                    bool containerOnly = false;
+                    {
+                        QMutexLocker locker( &fMutex );
+                        if ( fQueue.empty() || ( fNumRunners > fPool.maxThreadCount() ) )
+                        {
+                            fNumRunners--;
+                            if ( fQueue.empty() && ( fNumRunners == 0 ) && !fShutdown )
+                                QMetaObject::invokeMethod( this, [ this ]() { emit sigQueueDrained(); }, Qt::QueuedConnection );
+                            return;
+                        }
+
+                        path = std::get< 2 >( *fQueue.begin() );
+                        fQueue.erase( fQueue.begin() );
+                        containerOnly = fQueued[ path ].fContainerOnly;
+                        fQueued.erase( path );
+                        fRunning.insert( path );
+                    }
+
+                    QFileInfo fi( path );
+                    auto modified = fi.lastModified().toMSecsSinceEpoch();
+
+                    QElapsedTimer timer;
+                    timer.start();
+                    std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo;
+                    auto containerTags = containerOnly ? CMKVProbe::probe( fi ) : std::optional< CMKVProbe::TMediaTags >();
+                    if ( containerTags.has_value() )
+                        CMediaInfoCache::instance()->add( fi, containerTags.value() );
+                    else
+                        mediaInfo = std::make_shared< NSABUtils::CMediaInfo >( fi );
+                    auto latency = timer.elapsed();
+
+                    bool shutdown = false;
+                    {
+                        QMutexLocker locker( &fMutex );
+                        fRunning.erase( path );
+                        if ( mediaInfo )
+                            addResult( path, modified, mediaInfo );
+                        fCompleted++;
+                        fTotalLatencyMS += latency;
+                        fMaxLatencyMS = std::max( fMaxLatencyMS, latency );
+                        shutdown = fShutdown;
+                    }
+
+                    if ( !shutdown )
+                        QMetaObject::invokeMethod( this, [ this, path ]() { emit sigMediaProbed( path ); }, Qt::QueuedConnection );
+                }
+            }
+
+            CMediaProbePool::SStats CMediaProbePool::stats() const
+            {
+                QMutexLocker locker( &fMutex );
+                SStats retVal;
+                retVal.fNumThreads = fPool.maxThreadCount();
+                retVal.fQueueDepth = static_cast< int >( fQueue.size() );
+                retVal.fRunning = static_cast< int >( fRunning.size() );
+                retVal.fCompleted = fCompleted;
+                retVal.fAverageLatencyMS = fCompleted ? ( static_cast< double >( fTotalLatencyMS ) / fCompleted ) : 0.0;
+                retVal.fMaxLatencyMS = fMaxLatencyMS;
+                retVal.fHits = fHits;
+                retVal.fMisses = fMisses;
+                retVal.fNumResults = static_cast< int >( fResults.size() );
+                return retVal;
+            }
+
+            QString CMediaProbePool::statsString() const
+            {
+                auto stats = this->stats();
+                return QString( "threads=%1 queued=%2 running=%3 completed=%4 avgLatency=%5ms maxLatency=%6ms hits=%7 misses=%8 results=%9" )
+                    .arg( stats.fNumThreads )
+                    .arg( stats.fQueueDepth )
+                    .arg( stats.fRunning )
+                    .arg( stats.fCompleted )
+                    .arg( stats.fAverageLatencyMS, 0, 'f', 1 )
+                    .arg( stats.fMaxLatencyMS )
+                    .arg( stats.fHits )
+                    .arg( stats.fMisses )
+                    .arg( stats.fNumResults );
+            }
+        }
+    }
+}
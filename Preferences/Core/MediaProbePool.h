@@ -0,0 +1,151 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_MEDIAPROBEPOOL_H
+#define _CORE_MEDIAPROBEPOOL_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QThreadPool>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <list>
+#include <tuple>
+#include <memory>
+#include "SABUtils/QtHashUtils.h"
+
+class QFileInfo;
+namespace NSABUtils
+{
+    class CMediaInfo;
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            // bounded pool of background ffprobe runs
+            // the highest priority request runs first, visible rows ahead of the rest of the directory
+            // container tag requests read the matroska headers instead, and only fall back to ffprobe when that fails
+            class CMediaProbePool : public QObject
+            {
+                Q_OBJECT;
+
+                CMediaProbePool();
+
+            public:
+                enum class EPriority
+                {
+                    eBackground,
+                    eVisible,
+                    eExplicit
+                };
+
+                struct SStats
+                {
+                    int fNumThreads{ 0 };
+                    int fQueueDepth{ 0 };
+                    int fRunning{ 0 };
+                    quint64 fCompleted{ 0 };
+                    double fAverageLatencyMS{ 0.0 };
+                    qint64 fMaxLatencyMS{ 0 };
+                    quint64 fHits{ 0 };
+                    quint64 fMisses{ 0 };
+                    int fNumResults{ 0 };
+                };
+
+                static CMediaProbePool *instance();
+                virtual ~CMediaProbePool() override;
+
+                std::shared_ptr< NSABUtils::CMediaInfo > find( const QFileInfo &fi ) const;   // nullptr when not probed or the file changed since
+                void request( const QFileInfo &fi, EPriority priority );
+                void requestContainerTags( const QFileInfo &fi, EPriority priority );   // the tags land in the media info cache, not in find()
+                void cancelAll();   // drops every queued request, the probes already running still deliver
+                void shutdown();   // cancels and waits for the running probes, call before the application goes away
+                void prioritize( const QString &path, EPriority priority );   // only affects requests still in the queue
+
+                // the rows currently on screen; queued rows that scrolled away drop back to background
+                void setVisible( const QStringList &paths );
+
+                // sizes the pool for the storage the root path lives on
+                void setStorageHint( const QString &rootPath );
+                static int computeNumThreads( const QString &rootPath );
+
+                SStats stats() const;
+                QString statsString() const;
+
+                static int sMaxResults;   // least recently used results past this are dropped, the media info cache still has them
+
+            Q_SIGNALS:
+                void sigMediaProbed( const QString &path );
+                void sigQueueDrained();
+
+            private:
+                struct SRequest
+                {
+                    EPriority fPriority{ EPriority::eBackground };
+                    quint64 fSequence{ 0 };
+                    bool fContainerOnly{ false };
+                };
+                using TQueueKey = std::tuple< int, quint64, QString >;   // negated priority, sequence, path
+
+                void enqueue( const QFileInfo &fi, EPriority priority, bool containerOnly );
+                void reprioritize( const QString &path, EPriority priority );   // fMutex must be held
+                void startRunners();   // fMutex must be held
+                void runProbes();
+                void addResult( const QString &path, qint64 modified, std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo );   // fMutex must be held
+
+                mutable QMutex fMutex;
+                QThreadPool fPool;
+                int fNumRunners{ 0 };
+                quint64 fNextSequence{ 0 };
+
+                std::unordered_map< QString, SRequest > fQueued;
+                std::set< TQueueKey > fQueue;
+                std::unordered_set< QString > fRunning;
+                std::unordered_set< QString > fVisible;
+                struct SResult
+                {
+                    qint64 fModified{ 0 };   // mtime when probed
+                    std::shared_ptr< NSABUtils::CMediaInfo > fMediaInfo;
+                    std::list< QString >::iterator fLRUPos;
+                };
+                std::unordered_map< QString, SResult > fResults;
+                mutable std::list< QString > fLRU;   // most recently used first
+
+                bool fShutdown{ false };
+                quint64 fCompleted{ 0 };
+                mutable quint64 fHits{ 0 };
+                mutable quint64 fMisses{ 0 };
+                qint64 fTotalLatencyMS{ 0 };
+                qint64 fMaxLatencyMS{ 0 };
+            };
+        }
+    }
+}
+#endif
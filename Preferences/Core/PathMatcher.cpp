@@ -0,0 +1,112 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "PathMatcher.h"
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            static const QString sRegExChars = R"(\^$.|?*+()[]{})";
+            static const QString sWildcardChars = R"(*?[])";
+
+            static QString normalize( const QString &value )
+            {
+#ifdef Q_OS_WINDOWS
+                return value.toLower();
+#else
+                return value;
+#endif
+            }
+
+            CPathMatcher::CPathMatcher( const QStringList &patterns, bool areWildcards )
+            {
+                QStringList regExs;
+                for ( auto &&ii : patterns )
+                {
+                    if ( ii.isEmpty() )
+                        continue;
+
+                    if ( isPlainName( ii, areWildcards ? sWildcardChars : sRegExChars ) )
+                        fExact.insert( normalize( ii ) );
+                    else if ( areWildcards && plainExtension( ii ).has_value() )
+                        fExtensions.insert( normalize( plainExtension( ii ).value() ) );
+                    else
+                    {
+                        auto regEx = areWildcards ? QRegularExpression::wildcardToRegularExpression( ii ) : ii;
+                        if ( !QRegularExpression( regEx ).isValid() )
+                            continue;   // a bad pattern never matched on its own, it must not invalidate the alternation of the others
+                        regExs << "(?:" + regEx + ")";
+                    }
+                }
+
+                if ( regExs.isEmpty() )
+                    return;
+
+                QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+#ifdef Q_OS_WINDOWS
+                options |= QRegularExpression::CaseInsensitiveOption;
+#endif
+                fRegEx = QRegularExpression( "^(?:" + regExs.join( "|" ) + ")$", options );
+                fRegEx.value().optimize();
+            }
+
+            bool CPathMatcher::isPlainName( const QString &pattern, const QString &specialChars )
+            {
+                for ( auto &&ii : pattern )
+                {
+                    if ( specialChars.contains( ii ) )
+                        return false;
+                }
+                return true;
+            }
+
+            // "*.ext" with nothing else special, returns "ext"
+            std::optional< QString > CPathMatcher::plainExtension( const QString &wildcard )
+            {
+                if ( !wildcard.startsWith( "*." ) )
+                    return {};
+                auto ext = wildcard.mid( 2 );
+                if ( ext.isEmpty() || ext.contains( '.' ) || !isPlainName( ext, sWildcardChars ) )
+                    return {};
+                return ext;
+            }
+
+            bool CPathMatcher::matches( QString value ) const
+            {
+                value = normalize( value );
+                if ( fExact.find( value ) != fExact.end() )
+                    return true;
+
+                if ( !fExtensions.empty() )
+                {
+                    auto pos = value.lastIndexOf( '.' );
+                    if ( ( pos != -1 ) && ( fExtensions.find( value.mid( pos + 1 ) ) != fExtensions.end() ) )
+                        return true;
+                }
+                return fRegEx.has_value() && fRegEx.value().match( value ).hasMatch();
+            }
+        }
+    }
+}
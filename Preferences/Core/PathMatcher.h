@@ -0,0 +1,61 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_PATHMATCHER_H
+#define _CORE_PATHMATCHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QRegularExpression>
+#include <unordered_set>
+#include <optional>
+#include "SABUtils/QtHashUtils.h"
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            // the skipped/ignored path lists compiled once
+            // plain names go into a hash, everything else into a single anchored alternation
+            // when built from wildcards, "*.ext" patterns go into an extension hash
+            class CPathMatcher
+            {
+            public:
+                CPathMatcher( const QStringList &patterns, bool areWildcards = false );
+
+                bool matches( QString value ) const;
+                bool isEmpty() const { return fExact.empty() && fExtensions.empty() && !fRegEx.has_value(); }
+
+            private:
+                static bool isPlainName( const QString &pattern, const QString &specialChars );
+                static std::optional< QString > plainExtension( const QString &wildcard );
+
+                std::unordered_set< QString > fExact;
+                std::unordered_set< QString > fExtensions;
+                std::optional< QRegularExpression > fRegEx;
+            };
+        }
+    }
+}
+#endif
@@ -22,6 +22,10 @@
 
 #include "Preferences.h"
 #include "TranscodeNeeded.h"
+#include "PathMatcher.h"
+#include "PreferencesSnapshot.h"
+#include "MediaProbePool.h"
+#include "BIFPlanner.h"
 
 #include "Core/LanguageInfo.h"
 #include "SABUtils/QtUtils.h"
@@ -49,6 +53,9 @@
 #include <QImageReader>
 #include <QProcess>
 #include <QStandardPaths>
+#include <QThread>
+#include <QDataStream>
+#include <QCryptographicHash>
 
 #include <optional>
 #include <unordered_set>
@@ -199,6 +206,7 @@ namespace NMediaManager
             {
                 fMediaFormats = std::make_unique< NSABUtils::CFFMpegFormats >( getFFMpegEXE() );
                 connect( NSABUtils::CMediaInfoMgr::instance(), &NSABUtils::CMediaInfoMgr::sigMediaLoaded, this, &CPreferences::sigMediaInfoLoaded );
+                connect( CMediaProbePool::instance(), &CMediaProbePool::sigMediaProbed, this, &CPreferences::sigMediaInfoLoaded );
             }
 
             CPreferences::~CPreferences()
@@ -272,13 +280,13 @@ namespace NMediaManager
 
             QSize CPreferences::getThumbnailSize( const QFileInfo &fi ) const
             {
-                auto mediaInfo = NSABUtils::CMediaInfo( fi.absoluteFilePath() );
-                auto tags = mediaInfo.getMediaTags( { NSABUtils::EMediaTags::eWidth, NSABUtils::EMediaTags::eHeight, NSABUtils::EMediaTags::eAspectRatio } );
-
-                auto width = tags[ NSABUtils::EMediaTags::eWidth ].toInt();
-                auto height = tags[ NSABUtils::EMediaTags::eHeight ].toInt();
+                auto source = CBIFPlanner::instance()->source( fi );
+                return getThumbnailSize( source.fWidth, source.fHeight, source.fAspectRatio );
+            }
 
-                auto aspectRatio = tags[ NSABUtils::EMediaTags::eAspectRatio ].toDouble();   // w/h
+            QSize CPreferences::getThumbnailSize( int width, int height, double aspectRatio ) const
+            {
+                // aspectRatio is w/h
                 if ( aspectRatio == 0.0 )
                     aspectRatio = ( 1.0 * width ) / ( 1.0 * height );
 
@@ -463,6 +471,21 @@ namespace NMediaManager
                 return retVal;
             }
 
+            void CPreferences::setJobLogRetentionDays( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "JobLogRetentionDays", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            int CPreferences::getJobLogRetentionDays() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return settings.value( "JobLogRetentionDays", 30 ).toInt();
+            }
+
             void CPreferences::setLoadMediaInfo( bool value )
             {
                 QSettings settings;
@@ -493,6 +516,111 @@ namespace NMediaManager
                 return settings.value( "BackgroundLoadMediaInfo", true ).toBool();
             }
 
+            void CPreferences::setNumDirScanThreads( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "NumDirScanThreads", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            int CPreferences::getNumDirScanThreads() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return settings.value( "NumDirScanThreads", 8 ).toInt();
+            }
+
+            void CPreferences::setProcessThreadBudget( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "ProcessThreadBudget", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            int CPreferences::getProcessThreadBudget() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return std::max( 1, settings.value( "ProcessThreadBudget", QThread::idealThreadCount() ).toInt() );
+            }
+
+            void CPreferences::setProcessesPerDisk( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "ProcessesPerDisk", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            int CPreferences::getProcessesPerDisk() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return std::max( 1, settings.value( "ProcessesPerDisk", 4 ).toInt() );
+            }
+
+            void CPreferences::setUseScratchDir( bool value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "UseScratchDir", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            bool CPreferences::getUseScratchDir() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return settings.value( "UseScratchDir", false ).toBool();
+            }
+
+            void CPreferences::setScratchDir( const QString &value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "ScratchDir", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            QString CPreferences::getScratchDir() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return settings.value( "ScratchDir", QStandardPaths::writableLocation( QStandardPaths::TempLocation ) ).toString();
+            }
+
+            void CPreferences::setScratchDirMinFreeGB( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                settings.setValue( "ScratchDirMinFreeGB", value );
+                emitSigPreferencesChanged( EPreferenceType::eSystemPrefs );
+            }
+
+            int CPreferences::getScratchDirMinFreeGB() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eSystemPrefs ) );
+                return std::max( 0, settings.value( "ScratchDirMinFreeGB", 5 ).toInt() );
+            }
+
+            void CPreferences::setLoadDirectoriesOnDemand( bool value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eLoadPrefs ) );
+                settings.setValue( "LoadDirectoriesOnDemand", value );
+                emitSigPreferencesChanged( EPreferenceType::eLoadPrefs );
+            }
+
+            bool CPreferences::getLoadDirectoriesOnDemand() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eLoadPrefs ) );
+                return settings.value( "LoadDirectoriesOnDemand", false ).toBool();
+            }
+
             /// ////////////////////////////////////////////////////////
             /// transform Options
             /// ////////////////////////////////////////////////////////
@@ -820,21 +948,7 @@ namespace NMediaManager
 
             bool CPreferences::isPathToDelete( const QString &path ) const
             {
-                auto fn = QFileInfo( path ).fileName();
-                auto toDelete = getExtensionsToDelete();
-                for ( auto &&ii : toDelete )
-                {
-                    auto regExStr = QRegularExpression::wildcardToRegularExpression( ii );
-                    QRegularExpression::PatternOptions options = QRegularExpression::PatternOption::NoPatternOption;
-#ifdef Q_OS_WINDOWS
-                    options |= QRegularExpression::PatternOption::CaseInsensitiveOption;
-#endif;
-                    auto regExp = QRegularExpression( regExStr, options );
-
-                    if ( regExp.match( fn ).hasMatch() )
-                        return true;
-                }
-                return false;
+                return snapshot()->fPathToDeleteMatcher->matches( QFileInfo( path ).fileName() );
             }
 
             static QStringList sKnownStrings;
@@ -988,47 +1102,24 @@ namespace NMediaManager
             /// ////////////////////////////////////////////////////////
             /// Load Options
             /// ////////////////////////////////////////////////////////
-            bool CPreferences::containsValue( const QString &value, const QStringList &values ) const
+            std::shared_ptr< const CPathMatcher > CPreferences::getSkippedPathMatcher( bool forMediaNaming ) const
             {
-                for ( auto &&ii : values )
-                {
-                    QRegularExpression::PatternOption option = QRegularExpression::NoPatternOption;
-#ifdef Q_OS_WINDOWS
-                    option = QRegularExpression::CaseInsensitiveOption;
-#endif
-                    auto regExp = QRegularExpression( "^" + ii + "$", option );
-                    if ( regExp.match( value ).hasMatch() )
-                        return true;
-                }
-                return false;
+                return snapshot()->skippedPathMatcher( forMediaNaming );
             }
 
-            bool CPreferences::pathMatches( QString pathName, const QStringList &values ) const
+            std::shared_ptr< const CPathMatcher > CPreferences::getIgnoredPathMatcher() const
             {
-#ifdef Q_OS_WINDOWS
-                pathName = pathName.toLower();
-#endif
-                return containsValue( pathName, values );
-            }
-
-            bool CPreferences::pathMatches( const QFileInfo &fileInfo, const QStringList &values ) const
-            {
-                return pathMatches( fileInfo.fileName(), values );
-            }
-
-            bool CPreferences::pathMatches( const QDir &dir, const QStringList &values ) const
-            {
-                return pathMatches( dir.absolutePath(), values );
+                return snapshot()->fIgnoredPathMatcher;
             }
 
             bool CPreferences::isSkippedPath( bool forMediaNaming, const QFileInfo &fileInfo ) const
             {
-                return pathMatches( fileInfo, getSkippedPaths( forMediaNaming ) );
+                return getSkippedPathMatcher( forMediaNaming )->matches( fileInfo.fileName() );
             }
 
             bool CPreferences::isSkippedPath( bool forMediaNaming, const QDir &dir ) const
             {
-                return pathMatches( dir, getSkippedPaths( forMediaNaming ) );
+                return getSkippedPathMatcher( forMediaNaming )->matches( dir.absolutePath() );
             }
 
             void CPreferences::setSkippedPaths( bool forMediaNaming, const QStringList &values )
@@ -1068,12 +1159,12 @@ namespace NMediaManager
 
             bool CPreferences::isIgnoredPath( const QFileInfo &fileInfo ) const
             {
-                return pathMatches( fileInfo, getIgnoredPaths() );
+                return getIgnoredPathMatcher()->matches( fileInfo.fileName() );
             }
 
             bool CPreferences::isIgnoredPath( const QDir &dir ) const
             {
-                return pathMatches( dir, getIgnoredPaths() );
+                return getIgnoredPathMatcher()->matches( dir.absolutePath() );
             }
 
             void CPreferences::setIgnoredPaths( const QStringList &values )
@@ -1250,7 +1341,7 @@ namespace NMediaManager
 
             QRegularExpression CPreferences::getVerifyMediaTitleExpr( const QFileInfo &fi, const QDate &date ) const
             {
-                auto regExStr = replaceFileInfo( fi, date, getVerifyMediaTitleExpr() );
+                auto regExStr = replaceFileInfo( fi, date, snapshot()->fVerifyMediaTitleExpr );
                 return QRegularExpression( regExStr );
             }
 
@@ -1266,6 +1357,7 @@ namespace NMediaManager
                 QSettings settings;
                 settings.beginGroup( toString( EPreferenceType::eTagPrefs ) );
                 settings.setValue( "VerifyMediaTitleExpr", value );
+                emitSigPreferencesChanged( EPreferenceType::eTagPrefs );
             }
 
             bool CPreferences::getVerifyMediaDate() const
@@ -1300,7 +1392,7 @@ namespace NMediaManager
 
             QRegularExpression CPreferences::getVerifyMediaDateExpr( const QFileInfo &fi, const QDate &date ) const
             {
-                auto regExStr = replaceFileInfo( fi, date, getVerifyMediaDateExpr() );
+                auto regExStr = replaceFileInfo( fi, date, snapshot()->fVerifyMediaDateExpr );
                 return QRegularExpression( regExStr );
             }
 
@@ -1336,7 +1428,7 @@ namespace NMediaManager
 
             QRegularExpression CPreferences::getVerifyMediaCommentExpr( const QFileInfo &fi, const QDate &date ) const
             {
-                auto regExStr = replaceFileInfo( fi, date, getVerifyMediaCommentExpr() );
+                auto regExStr = replaceFileInfo( fi, date, snapshot()->fVerifyMediaCommentExpr );
                 return QRegularExpression( regExStr );
             }
 
@@ -1746,8 +1838,8 @@ namespace NMediaManager
                 if ( !isMediaFile( fi ) )
                     return {};
 
-                if ( NSABUtils::CMediaInfoMgr::instance()->isMediaCached( fi ) )
-                    return NSABUtils::CMediaInfoMgr::instance()->getMediaInfo( fi );
+                if ( auto retVal = getCachedMediaInfo( fi ) )
+                    return retVal;
 
                 if ( !force && !getLoadMediaInfo() )
                     return {};
@@ -1755,12 +1847,22 @@ namespace NMediaManager
                 bool delayLoad = !force && getBackgroundLoadMediaInfo();
                 if ( delayLoad )
                 {
-                    return NSABUtils::CMediaInfoMgr::instance()->getMediaInfo( fi );
+                    // sigMediaInfoLoaded fires when the probe finishes
+                    CMediaProbePool::instance()->request( fi, CMediaProbePool::EPriority::eBackground );
+                    return {};
                 }
                 else
                     return std::make_shared< NSABUtils::CMediaInfo >( fi );
             }
 
+            std::shared_ptr< NSABUtils::CMediaInfo > CPreferences::getCachedMediaInfo( const QFileInfo &fi ) const
+            {
+                if ( NSABUtils::CMediaInfoMgr::instance()->isMediaCached( fi ) )
+                    return NSABUtils::CMediaInfoMgr::instance()->getMediaInfo( fi );
+
+                return CMediaProbePool::instance()->find( fi );
+            }
+
             QStringList CPreferences::availableEncoderMediaFormats( bool verbose ) const
             {
                 return getMediaFormats()->encoderFormats( verbose );
@@ -1859,6 +1961,7 @@ namespace NMediaManager
             void CPreferences::recomputeSupportedFormats( QProgressDialog *dlg )
             {
                 loadMediaFormats( true, dlg );
+                emitSigPreferencesChanged( EPreferenceType::eTranscodePrefs );   // the cached transcode plans were decided with the old formats
             }
 
             void CPreferences::loadMediaFormats( bool forceFromFFMpeg, QProgressDialog *dlg ) const
@@ -2207,6 +2310,85 @@ namespace NMediaManager
                 return settings.value( "UseTargetBitrate", getUseTargetBitrateDefault() ).toBool();
             }
 
+            void CPreferences::setUseSegmentedEncoding( bool value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                settings.setValue( "UseSegmentedEncoding", value );
+                emitSigPreferencesChanged( EPreferenceType::eTranscodePrefs );
+            }
+
+            bool CPreferences::getUseSegmentedEncoding() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                return settings.value( "UseSegmentedEncoding", false ).toBool();
+            }
+
+            void CPreferences::setNumEncodeSegments( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                settings.setValue( "NumEncodeSegments", value );
+                emitSigPreferencesChanged( EPreferenceType::eTranscodePrefs );
+            }
+
+            int CPreferences::getNumEncodeSegments() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                return std::max( 2, settings.value( "NumEncodeSegments", 4 ).toInt() );
+            }
+
+            void CPreferences::setSegmentedEncodingMinMinutes( int value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                settings.setValue( "SegmentedEncodingMinMinutes", value );
+                emitSigPreferencesChanged( EPreferenceType::eTranscodePrefs );
+            }
+
+            int CPreferences::getSegmentedEncodingMinMinutes() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                return std::max( 1, settings.value( "SegmentedEncodingMinMinutes", 30 ).toInt() );
+            }
+
+            void CPreferences::setShowCompliantFiles( bool value )
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                settings.setValue( "ShowCompliantFiles", value );
+                emitSigPreferencesChanged( EPreferenceType::eTranscodePrefs );
+            }
+
+            bool CPreferences::getShowCompliantFiles() const
+            {
+                QSettings settings;
+                settings.beginGroup( toString( EPreferenceType::eTranscodePrefs ) );
+                return settings.value( "ShowCompliantFiles", false ).toBool();
+            }
+
+            QByteArray CPreferences::getTranscodeRulesHash() const
+            {
+                // every setting STranscodeNeeded reads, anything else (encoder options, segmenting) does not change compliance
+                // the media formats and their aliases come from the ffmpeg binary, so a different or upgraded ffmpeg/ffprobe invalidates it too
+                QByteArray data;
+                QDataStream ds( &data, QIODevice::WriteOnly );
+                for ( auto &&exe : { getFFProbeEXE(), getFFMpegEXE() } )
+                {
+                    QFileInfo fi( exe );
+                    ds << exe << fi.size() << fi.lastModified();
+                }
+                ds << getConvertMediaContainer() << getConvertMediaToContainer();
+                ds << getTranscodeVideo() << getTranscodeToVideoCodec() << getOnlyTranscodeVideoOnFormatChange();
+                ds << getTranscodeAudio() << getTranscodeToAudioCodec() << getOnlyTranscodeAudioOnFormatChange() << getAddAACAudioCodec();
+                ds << getGenerateNon4kVideo() << getGenerateLowBitrateVideo();
+                ds << getGreaterThan4kDivisor() << getResolutionThresholdPercentage() << getTarget4kBitrate() << getTargetHDBitrate() << getTargetSubHDBitrate() << getBitrateThresholdPercentage();
+                return QCryptographicHash::hash( data, QCryptographicHash::Sha1 );
+            }
+
             uint64_t CPreferences::getTargetBitrate( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, bool useKBS, bool addThreshold ) const
             {
                 if ( !mediaInfo )
@@ -2535,8 +2717,65 @@ namespace NMediaManager
                     fi, [ this ]() { return getMediaFormats()->getSubtitleExtensions(); }, fSubtitleExtensionsHash, fIsSubtitleExtension );
             }
 
+            std::shared_ptr< const SPreferencesSnapshot > CPreferences::snapshot() const
+            {
+                auto retVal = std::atomic_load( &fSnapshot );
+                if ( retVal )
+                    return retVal;
+
+                QMutexLocker locker( &fSnapshotMutex );   // building fills the non thread safe caches
+                retVal = std::atomic_load( &fSnapshot );
+                if ( retVal )
+                    return retVal;
+
+                // setters bump the revision under the same lock, so nothing can change between building and storing
+                auto newSnapshot = buildSnapshot( fRevision.load() );
+                std::atomic_store( &fSnapshot, newSnapshot );
+                return newSnapshot;
+            }
+
+            std::shared_ptr< const SPreferencesSnapshot > CPreferences::buildSnapshot( uint64_t revision ) const
+            {
+                auto retVal = std::make_shared< SPreferencesSnapshot >();
+                retVal->fRevision = revision;
+
+                retVal->fLoadMediaInfo = getLoadMediaInfo();
+                retVal->fIgnorePathNamesToSkipForMediaNaming = getIgnorePathNamesToSkip( true );
+                retVal->fIgnorePathNamesToSkipForTagging = getIgnorePathNamesToSkip( false );
+                retVal->fIgnorePathNamesToIgnore = getIgnorePathNamesToIgnore();
+                retVal->fSkippedPathMatcherForMediaNaming = std::make_shared< CPathMatcher >( getSkippedPaths( true ) );
+                retVal->fSkippedPathMatcherForTagging = std::make_shared< CPathMatcher >( getSkippedPaths( false ) );
+                retVal->fIgnoredPathMatcher = std::make_shared< CPathMatcher >( getIgnoredPaths() );
+
+                retVal->fOnlyTransformDirectories = getOnlyTransformDirectories();
+                retVal->fPathToDeleteMatcher = std::make_shared< CPathMatcher >( getExtensionsToDelete(), true );
+                retVal->fKnownAbbreviations = getKnownAbbreviations();
+                retVal->fKnownExtendedStrings = getKnownExtendedStrings();
+                retVal->fKnownStringRegExs = getKnownStringRegExs();
+                retVal->fKnownHyphenatedData = getKnownHyphenatedData();
+
+                retVal->fEnabledTags = getEnabledTags();
+                retVal->fVerifyMediaTags = getVerifyMediaTags();
+                retVal->fVerifyMediaTitle = getVerifyMediaTitle();
+                retVal->fVerifyMediaTitleExpr = getVerifyMediaTitleExpr();
+                retVal->fVerifyMediaDate = getVerifyMediaDate();
+                retVal->fVerifyMediaDateExpr = getVerifyMediaDateExpr();
+                retVal->fVerifyMediaComment = getVerifyMediaComment();
+                retVal->fVerifyMediaCommentExpr = getVerifyMediaCommentExpr();
+
+                retVal->fTranscodeRulesHash = getTranscodeRulesHash();
+                retVal->fShowCompliantFiles = getShowCompliantFiles();
+                return retVal;
+            }
+
             void CPreferences::emitSigPreferencesChanged( EPreferenceTypes preferenceTypes )
             {
+                {
+                    QMutexLocker locker( &fSnapshotMutex );   // waits out any snapshot being built from the old values
+                    fRevision++;
+                    std::atomic_store( &fSnapshot, std::shared_ptr< const SPreferencesSnapshot >() );
+                }
+
                 fPending |= preferenceTypes;
                 if ( !fPrefChangeTimer )
                 {
@@ -2556,8 +2795,11 @@ namespace NMediaManager
                             }
                             if ( ( fPending & eMediaRenamerPrefs ) != 0 )
                             {
+                                QMutexLocker locker( &fSnapshotMutex );
                                 fKnownStringRegExsCache.clear();
+                                std::atomic_store( &fSnapshot, std::shared_ptr< const SPreferencesSnapshot >() );   // may have been built from the old cache
                             }
+                            snapshot();   // rebuild before anyone reacts to the change
                             emit sigPreferencesChanged( fPending );
                             fPending = EPreferenceTypes();
                         } );
@@ -33,6 +33,7 @@
 #include <unordered_set>
 #include <optional>
 #include <memory>
+#include <atomic>
 
 class QFileInfo;
 class QWidget;
@@ -136,6 +137,11 @@ namespace NMediaManager
             };
             QString toString( ETranscodeProfile profile, bool forEnum = false );
 
+            class CPathMatcher;
+            struct SPreferencesSnapshot;
+            struct STranscodeNeeded;
+            struct STranscodePlan;
+            enum class ETranscodeType;
             class CPreferences : public QObject
             {
                 Q_OBJECT;
@@ -169,8 +175,18 @@ namespace NMediaManager
                 QStringList getHighBitrateTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const;
                 QStringList getHighResolutionTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const;
 
+                std::shared_ptr< const STranscodePlan > getTranscodePlan( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo ) const;   // reads the transcode preferences once, callers cache it per file
+                QStringList getTranscodeArgs( const STranscodePlan &plan, ETranscodeType type, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const;
+
+                // segmented encoding
+                bool useSegmentedEncoding( const STranscodeNeeded &transcodeNeeded, double seconds, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate ) const;
+                QStringList getSegmentSplitArgs( const QString &srcName, const QString &segmentPattern, int segmentSeconds ) const;
+                QStringList getSegmentEncodeArgs( const STranscodePlan &plan, ETranscodeType type, const QString &segmentName, const QString &destName ) const;
+                QStringList getSegmentedTranscodeArgs( const STranscodePlan &plan, ETranscodeType type, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles, const QString &encodedVideoList ) const;   // muxes the encoded segments with the original streams
+
                 std::shared_ptr< NSABUtils::CMediaInfo > getMediaInfo( const QFileInfo &fi, bool force = false );
                 std::shared_ptr< NSABUtils::CMediaInfo > getMediaInfo( const QString &fileName, bool force = false );
+                std::shared_ptr< NSABUtils::CMediaInfo > getCachedMediaInfo( const QFileInfo &fi ) const;   // never runs ffprobe
 
                 // ffmpeg results
                 QStringList availableEncoderMediaFormats( bool verbose ) const;   // if true returns name - desc, otherwise name only
@@ -315,6 +331,22 @@ namespace NMediaManager
                 bool getUseTargetBitrateDefault() const;
                 bool getUseTargetBitrate() const;
 
+                // long software encodes are split at keyframes, the segments encode side by side and are concat muxed
+                void setUseSegmentedEncoding( bool value );
+                bool getUseSegmentedEncoding() const;
+
+                void setNumEncodeSegments( int value );
+                int getNumEncodeSegments() const;
+
+                void setSegmentedEncodingMinMinutes( int value );
+                int getSegmentedEncodingMinMinutes() const;   // shorter sources are encoded in one run
+
+                // files that already meet the transcode rules are remembered, and hidden unless asked for
+                void setShowCompliantFiles( bool value );
+                bool getShowCompliantFiles() const;
+
+                QByteArray getTranscodeRulesHash() const;   // changes whenever a setting that decides if a file needs transcoding changes
+
                 // since it can return raw gb/s over 4, use 64 bit int
                 uint64_t getTargetBitrate( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, bool useKBS, bool addThreshold ) const;   // returns it in bits/second + threshold
                 uint64_t getTargetBitrate( const NSABUtils::SResolutionInfo &resInfo, bool useKBS, bool addThreshold ) const;   // returns it in bits/second + threshold
@@ -373,12 +405,37 @@ namespace NMediaManager
                 void setLogDir( const QString &value );
                 QString getLogDir() const;
 
+                void setJobLogRetentionDays( int value );
+                int getJobLogRetentionDays() const;
+
                 void setLoadMediaInfo( bool value );
                 bool getLoadMediaInfo() const;
 
                 void setBackgroundLoadMediaInfo( bool value );
                 bool getBackgroundLoadMediaInfo() const;
 
+                void setNumDirScanThreads( int value );
+                int getNumDirScanThreads() const;
+
+                void setProcessThreadBudget( int value );
+                int getProcessThreadBudget() const;   // cpu threads shared by all running external processes
+
+                void setProcessesPerDisk( int value );
+                int getProcessesPerDisk() const;
+
+                // intermediate and output files are written to a local scratch disk, then moved next to the source in one copy
+                void setUseScratchDir( bool value );
+                bool getUseScratchDir() const;
+
+                void setScratchDir( const QString &value );
+                QString getScratchDir() const;
+
+                void setScratchDirMinFreeGB( int value );
+                int getScratchDirMinFreeGB() const;   // left free on the scratch disk after a job's estimated output
+
+                void setLoadDirectoriesOnDemand( bool value );
+                bool getLoadDirectoriesOnDemand() const;
+
                 void setOnlyTransformDirectories( bool value );
                 bool getOnlyTransformDirectories() const;
 
@@ -399,6 +456,7 @@ namespace NMediaManager
 
                 bool isSkippedPath( bool forMediaNaming, const QDir &dir ) const;
                 bool isSkippedPath( bool forMediaNaming, const QFileInfo &fileInfo ) const;
+                std::shared_ptr< const CPathMatcher > getSkippedPathMatcher( bool forMediaNaming ) const;
                 QStringList getDefaultSkippedPaths( bool forMediaNaming ) const;
                 QStringList getSkippedPaths( bool forMediaNaming ) const;
                 void setSkippedPaths( bool forMediaNaming, const QStringList &value );
@@ -408,6 +466,7 @@ namespace NMediaManager
 
                 bool isIgnoredPath( const QDir &dir ) const;
                 bool isIgnoredPath( const QFileInfo &fileInfo ) const;
+                std::shared_ptr< const CPathMatcher > getIgnoredPathMatcher() const;
                 QStringList getDefaultIgnoredPaths() const;
                 QStringList getIgnoredPaths() const;
                 void setIgnoredPaths( const QStringList &value );
@@ -578,6 +637,7 @@ namespace NMediaManager
                 void setNumSearchPages( int numpages );
 
                 QSize getThumbnailSize( const QFileInfo &fi ) const;
+                QSize getThumbnailSize( int width, int height, double aspectRatio ) const;
                 QString getImageFileName( const QFileInfo &fi, const QString &ext ) const;
                 QString getImageFileName( const QFileInfo &fi, const QSize &sz, const QString &ext ) const;
 
@@ -608,22 +668,23 @@ namespace NMediaManager
                 bool keepTempDir() const;
                 void setKeepTempDir( bool value );
 
+                // lock free, safe to call from any thread; the returned snapshot never changes
+                std::shared_ptr< const SPreferencesSnapshot > snapshot() const;
+
             Q_SIGNALS:
                 void sigPreferencesChanged( EPreferenceTypes prefType );
                 void sigMediaInfoLoaded( const QString &fileName ) const;
 
             private:
-                QStringList getTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate ) const;
+                QStringList getTranscodeArgs( const STranscodeNeeded &transcodeNeeded, std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate, const std::optional< QString > &encodedVideoList ) const;
+                void addVideoEncodeArgs( QStringList &args, std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &videoCodec, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate ) const;
 
                 QStringList getDefaultFile() const;
                 bool isFileWithExtension( const QFileInfo &fi, std::function< QStringList() > getExtensions, std::unordered_set< QString > &hash, std::unordered_map< QString, bool > &cache ) const;
 
                 QStringList cleanUpPaths( const QStringList &paths, bool areDirs ) const;
                 void emitSigPreferencesChanged( EPreferenceTypes prefType );
-                bool pathMatches( const QFileInfo &fileInfo, const QStringList &values ) const;
-                bool pathMatches( const QDir &dir, const QStringList &values ) const;
-                bool pathMatches( QString pathName, const QStringList &values ) const;
-                bool containsValue( const QString &value, const QStringList &values ) const;
+                std::shared_ptr< const SPreferencesSnapshot > buildSnapshot( uint64_t revision ) const;
                 //QString getDefaultInPattern( bool forTV ) const;
                 QString getDefaultSeasonDirPattern() const;
                 QString getDefaultOutDirPattern( bool forTV ) const;
@@ -647,6 +708,10 @@ namespace NMediaManager
                 mutable std::unordered_map< QString, bool > fIsSubtitleExtension;
                 mutable QStringList fKnownStringRegExsCache;
 
+                mutable QMutex fSnapshotMutex;
+                mutable std::shared_ptr< const SPreferencesSnapshot > fSnapshot;   // only accessed through std::atomic_load/store
+                std::atomic< uint64_t > fRevision{ 1 };
+
                 std::unique_ptr< QTextStream > fLogFileTS;
                 std::unique_ptr< QFile > fLogFile;
             };
@@ -0,0 +1,90 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_PREFERENCESSNAPSHOT_H
+#define _CORE_PREFERENCESSNAPSHOT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <list>
+#include <memory>
+#include <cstdint>
+
+namespace NSABUtils
+{
+    enum class EMediaTags;
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            class CPathMatcher;
+
+            // an immutable copy of the preferences read on the hot paths
+            // built once per change and shared between the GUI and the worker threads without locking
+            struct SPreferencesSnapshot
+            {
+                bool ignorePathNamesToSkip( bool forMediaNaming ) const { return forMediaNaming ? fIgnorePathNamesToSkipForMediaNaming : fIgnorePathNamesToSkipForTagging; }
+                const std::shared_ptr< const CPathMatcher > &skippedPathMatcher( bool forMediaNaming ) const { return forMediaNaming ? fSkippedPathMatcherForMediaNaming : fSkippedPathMatcherForTagging; }
+
+                uint64_t fRevision{ 0 };   // bumped on every preference change
+
+                // load
+                bool fLoadMediaInfo{ true };
+                bool fIgnorePathNamesToSkipForMediaNaming{ false };
+                bool fIgnorePathNamesToSkipForTagging{ false };
+                bool fIgnorePathNamesToIgnore{ false };
+                std::shared_ptr< const CPathMatcher > fSkippedPathMatcherForMediaNaming;
+                std::shared_ptr< const CPathMatcher > fSkippedPathMatcherForTagging;
+                std::shared_ptr< const CPathMatcher > fIgnoredPathMatcher;
+
+                // media naming
+                bool fOnlyTransformDirectories{ false };
+                std::shared_ptr< const CPathMatcher > fPathToDeleteMatcher;
+                QVariantMap fKnownAbbreviations;
+                QStringList fKnownExtendedStrings;
+                QStringList fKnownStringRegExs;
+                std::list< std::pair< QString, int > > fKnownHyphenatedData;
+
+                // tags
+                std::list< NSABUtils::EMediaTags > fEnabledTags;
+                bool fVerifyMediaTags{ true };
+                bool fVerifyMediaTitle{ true };
+                QString fVerifyMediaTitleExpr;
+                bool fVerifyMediaDate{ true };
+                QString fVerifyMediaDateExpr;
+                bool fVerifyMediaComment{ true };
+                QString fVerifyMediaCommentExpr;
+
+                // transcode
+                QByteArray fTranscodeRulesHash;
+                bool fShowCompliantFiles{ false };
+            };
+        }
+    }
+}
+#endif
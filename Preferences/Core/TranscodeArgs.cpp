@@ -22,6 +22,7 @@
 
 #include "Preferences.h"
 #include "TranscodeNeeded.h"
+#include "TranscodePlan.h"
 #include "Core/LanguageInfo.h"
 #include "SABUtils/MediaInfo.h"
 
@@ -37,23 +38,144 @@ namespace NMediaManager
         {
             QStringList CPreferences::getTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const
             {
-                return getTranscodeArgs( mediaInfo, srcName, destName, srtFiles, subIdxFiles, {}, {} );
+                return getTranscodeArgs( *getTranscodePlan( mediaInfo ), ETranscodeType::eOther, srcName, destName, srtFiles, subIdxFiles );
             }
 
             QStringList CPreferences::getHighBitrateTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const
             {
-                auto kbps = getTargetBitrate( mediaInfo, true, false );
-                return getTranscodeArgs( mediaInfo, srcName, destName, srtFiles, subIdxFiles, {}, kbps );
+                return getTranscodeArgs( *getTranscodePlan( mediaInfo ), ETranscodeType::eHighBitrate, srcName, destName, srtFiles, subIdxFiles );
             }
 
             QStringList CPreferences::getHighResolutionTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const
             {
-                return getTranscodeArgs( mediaInfo, srcName, destName, srtFiles, subIdxFiles, NSABUtils::CMediaInfo::k1080pResolution.fResolution, {} );
+                return getTranscodeArgs( *getTranscodePlan( mediaInfo ), ETranscodeType::eHighRes, srcName, destName, srtFiles, subIdxFiles );
             }
 
-            QStringList CPreferences::getTranscodeArgs( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate ) const
+            QStringList CPreferences::getTranscodeArgs( const STranscodePlan &plan, ETranscodeType type, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles ) const
             {
-                auto transcodeNeeded = STranscodeNeeded( mediaInfo, this );
+                return getTranscodeArgs( plan.fTranscodeNeeded, plan.fMediaInfo, srcName, destName, srtFiles, subIdxFiles, plan.resolution( type ), plan.bitrate( type ), {} );
+            }
+
+            bool CPreferences::useSegmentedEncoding( const STranscodeNeeded &transcodeNeeded, double seconds, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate ) const
+            {
+                if ( !transcodeNeeded.isLoaded() || !getUseSegmentedEncoding() )
+                    return false;
+
+                // only worth it when the video is re-encoded by a software encoder, hw encoders are already saturated by one run
+                if ( !transcodeNeeded.wrongVideoCodec() && !resolution.has_value() && !bitrate.has_value() )
+                    return false;
+                if ( !getTranscodeToVideoCodec().startsWith( "lib" ) || !getTranscodeHWAccel().isEmpty() )
+                    return false;
+
+                return seconds >= ( getSegmentedEncodingMinMinutes() * 60 );
+            }
+
+            QStringList CPreferences::getSegmentSplitArgs( const QString &srcName, const QString &segmentPattern, int segmentSeconds ) const
+            {
+                // stream copy, so the segment muxer can only cut on the first keyframe at or after each split point
+                auto retVal = QStringList()   //
+                              << "-hide_banner"
+                              << "-y"   //
+                              << "-i" << srcName   //
+                              << "-map"
+                              << "0:v:0"   //
+                              << "-c"
+                              << "copy"   //
+                              << "-f"
+                              << "segment"   //
+                              << "-segment_time" << QString::number( segmentSeconds )   //
+                              << "-reset_timestamps"
+                              << "1"   //
+                              << "-segment_format"
+                              << "matroska"   //
+                              << segmentPattern;
+                return retVal;
+            }
+
+            QStringList CPreferences::getSegmentEncodeArgs( const STranscodePlan &plan, ETranscodeType type, const QString &segmentName, const QString &destName ) const
+            {
+                auto retVal = QStringList()   //
+                              << "-hide_banner"
+                              << "-y"   //
+                    ;
+                auto hwAccel = getTranscodeHWAccel();
+                if ( !hwAccel.isEmpty() )
+                {
+                    retVal << "-hwaccel" << hwAccel;
+                    retVal << "-hwaccel_output_format" << hwAccel   //
+                        ;
+                }
+
+                auto videoCodec = getTranscodeToVideoCodec();
+                retVal << "-i" << segmentName   //
+                       << "-map"
+                       << "0:v:0"   //
+                       << "-c:v" << videoCodec   //
+                    ;
+                addVideoEncodeArgs( retVal, plan.fMediaInfo, videoCodec, plan.resolution( type ), plan.bitrate( type ) );
+                retVal << "-an"
+                       << "-sn"   //
+                       << "-threads"
+                       << "0"   // auto, the process scheduler replaces it with the threads it grants
+                       << "-f"
+                       << "matroska"   //
+                       << destName;
+                return retVal;
+            }
+
+            QStringList CPreferences::getSegmentedTranscodeArgs( const STranscodePlan &plan, ETranscodeType type, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles, const QString &encodedVideoList ) const
+            {
+                return getTranscodeArgs( plan.fTranscodeNeeded, plan.fMediaInfo, srcName, destName, srtFiles, subIdxFiles, plan.resolution( type ), plan.bitrate( type ), encodedVideoList );
+            }
+
+            void CPreferences::addVideoEncodeArgs( QStringList &retVal, std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &videoCodec, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate ) const
+            {
+                if ( resolution.has_value() )
+                {
+                    auto hwAccel = getTranscodeHWAccel();
+                    auto currRes = mediaInfo->getResolution();
+                    auto widthDiff = 1.0 * std::abs( currRes.first - resolution.value().first ) / ( 1.0 * resolution.value().first );
+                    auto heightDiff = 1.0 * std::abs( currRes.second - resolution.value().second ) / ( 1.0 * resolution.value().second );
+
+                    auto scale = QString( "scale%1=%2:%3" ).arg( hwAccel.isEmpty() ? "" : ( "_" + hwAccel ) );
+                    if ( widthDiff > heightDiff )
+                        scale = scale.arg( resolution.value().first ).arg( -1 );
+                    else
+                        scale = scale.arg( -1 ).arg( resolution.value().second );
+                    retVal << "-vf" << scale;
+                }
+
+                bool isHEVC = mediaInfo->isHEVCCodec( videoCodec, getMediaFormats() );
+                if ( bitrate.has_value() || getUseTargetBitrate() )
+                {
+                    uint64_t lclBitrate = getTargetBitrate( mediaInfo, true, false );
+                    if ( bitrate.has_value() )
+                        lclBitrate = bitrate.value() - ( mediaInfo->getDefaultAudioBitRate() / 1000 );
+                    retVal << "-b:v" << QString( "%1k" ).arg( lclBitrate ) << "-maxrate" << QString( "%1k" ).arg( static_cast< uint64_t >( lclBitrate * 1.1 ) ) << "-bufsize" << QString( "%1k" ).arg( lclBitrate / 2 );
+                }
+                else if ( isHEVC )
+                {
+                    if ( getLosslessEncoding() )
+                    {
+                        retVal << "-x265-params"
+                               << "lossless=1";
+                    }
+                    else if ( getUseCRF() )
+                        retVal << "-crf" << QString::number( getCRF() );
+
+                    if ( getUsePreset() )
+                        retVal << "-preset" << toString( getPreset() );
+                    if ( getUseTune() )
+                        retVal << "-tune" << toString( getTune() );
+                    if ( getUseProfile() )
+                        retVal << "-profile:v" << toString( getProfile() );
+                }
+            }
+
+            QStringList CPreferences::getTranscodeArgs( const STranscodeNeeded &transcodeNeeded, std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const QString &srcName, const QString &destName, const std::list< NMediaManager::NCore::SLanguageInfo > &srtFiles, const std::list< std::pair< NMediaManager::NCore::SLanguageInfo, QString > > &subIdxFiles, const std::optional< std::pair< int, int > > &resolution, const std::optional< uint64_t > &bitrate, const std::optional< QString > &encodedVideoList ) const
+            {
+                if ( !mediaInfo )   // a plan restored from the media info cache has no stream layout, the file is probed before it runs
+                    return {};
 
                 if ( !transcodeNeeded.transcodeNeeded() && srtFiles.empty() && subIdxFiles.empty() && !resolution.has_value() && !bitrate.has_value() )
                     return {};
@@ -103,6 +225,15 @@ namespace NMediaManager
                         ;
                 }
 
+                if ( encodedVideoList.has_value() )
+                {
+                    retVal << "-f"
+                           << "concat"   //
+                           << "-safe"
+                           << "0"   //
+                           << "-i" << encodedVideoList.value();
+                }
+
                 retVal << "-map_metadata"
                        << "0"   //
                        << "-map_chapters"
@@ -133,10 +264,21 @@ namespace NMediaManager
                         videoCodec = getTranscodeToVideoCodec();
                     }
 
-                    retVal << "-map"
-                           << "0:v?"   //
-                           << "-c:v" << videoCodec   //
-                        ;
+                    if ( encodedVideoList.has_value() )
+                    {
+                        // the video was already encoded segment by segment, the concat list input follows the subtitle inputs
+                        retVal << "-map" << QString( "%1:v:0" ).arg( static_cast< int >( 1 + srtFiles.size() + subIdxFiles.size() ) )   //
+                               << "-c:v"
+                               << "copy"   //
+                            ;
+                    }
+                    else
+                    {
+                        retVal << "-map"
+                               << "0:v?"   //
+                               << "-c:v" << videoCodec   //
+                            ;
+                    }
 
                     uint64_t defaultAudioStreamBitrate = mediaInfo->getDefaultAudioBitRate();
                     if ( mediaInfo->numAudioStreams() )
@@ -193,44 +335,8 @@ namespace NMediaManager
 
                     if ( transcodeNeeded.wrongVideoCodec() || bitrate.has_value() || resolution.has_value() )
                     {
-                        if ( resolution.has_value() )
-                        {
-                            auto currRes = mediaInfo->getResolution();
-                            auto widthDiff = 1.0 * std::abs( currRes.first - resolution.value().first ) / ( 1.0 * resolution.value().first );
-                            auto heightDiff = 1.0 * std::abs( currRes.second - resolution.value().second ) / ( 1.0 * resolution.value().second );
-
-                            auto scale = QString( "scale%1=%2:%3" ).arg( hwAccel.isEmpty() ? "" : ( "_" + hwAccel ) );
-                            if ( widthDiff > heightDiff )
-                                scale = scale.arg( resolution.value().first ).arg( -1 );
-                            else
-                                scale = scale.arg( -1 ).arg( resolution.value().second );
-                            retVal << "-vf" << scale;
-                        }
-
-                        if ( bitrate.has_value() || getUseTargetBitrate() )
-                        {
-                            uint64_t lclBitrate = getTargetBitrate( mediaInfo, true, false );
-                            if ( bitrate.has_value() )
-                                lclBitrate = bitrate.value() - ( defaultAudioStreamBitrate / 1000 );
-                            retVal << "-b:v" << QString( "%1k" ).arg( lclBitrate ) << "-maxrate" << QString( "%1k" ).arg( static_cast< uint64_t >( lclBitrate * 1.1 ) ) << "-bufsize" << QString( "%1k" ).arg( lclBitrate / 2 );
-                        }
-                        else if ( isHEVC )
-                        {
-                            if ( getLosslessEncoding() )
-                            {
-                                retVal << "-x265-params"
-                                       << "lossless=1";
-                            }
-                            else if ( getUseCRF() )
-                                retVal << "-crf" << QString::number( getCRF() );
-
-                            if ( getUsePreset() )
-                                retVal << "-preset" << toString( getPreset() );
-                            if ( getUseTune() )
-                                retVal << "-tune" << toString( getTune() );
-                            if ( getUseProfile() )
-                                retVal << "-profile:v" << toString( getProfile() );
-                        }
+                        if ( !encodedVideoList.has_value() )
+                            addVideoEncodeArgs( retVal, mediaInfo, videoCodec, resolution, bitrate );
                         if ( isHEVC )
                             retVal << "-tag:v"
                                    << "hvc1";
@@ -302,7 +408,8 @@ namespace NMediaManager
                         }
                     }
                 }
-                retVal << "-f" << getConvertMediaToContainer()   //
+                retVal << "-threads" << "0"   // auto, the process scheduler replaces it with the threads it grants
+                       << "-f" << getConvertMediaToContainer()   //
                        << destName;
 
                 return retVal;
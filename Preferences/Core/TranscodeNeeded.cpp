@@ -22,6 +22,7 @@
 
 #include "TranscodeNeeded.h"
 #include "Preferences.h"
+#include "MediaInfoCache.h"
 #include "SABUtils/MediaInfo.h"
 
 #include <QFileInfo>
@@ -54,19 +55,22 @@ namespace NMediaManager
 
             */
 
-            STranscodeNeeded::STranscodeNeeded( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const CPreferences *prefs ) :
-                fMediaInfo( mediaInfo )
+            STranscodeNeeded::STranscodeNeeded( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const CPreferences *prefs )
             {
                 fWrongContainer = fWrongVideoCodec = fBitrateTooHigh = fWrongAudioCodec = fDefaultAudioNotAAC = false;
                 if ( !mediaInfo || !mediaInfo->aOK() || mediaInfo->isQueued() )
                     return;
 
+                fLoaded = true;
+                fFileName = mediaInfo->fileName();
+                fTargetBitrateDisplay = prefs->getTargetBitrateDisplayString( mediaInfo );
+
                 fWrongContainer = prefs->getConvertMediaContainer() && !prefs->isEncoderFormat( mediaInfo, prefs->getConvertMediaToContainer() );
                 fWrongVideoCodec = !mediaInfo->hasVideoCodec( prefs->getTranscodeToVideoCodec(), prefs->getMediaFormats() ) && ( fWrongContainer || !prefs->getOnlyTranscodeVideoOnFormatChange() );
 
                 if ( prefs->getGenerateLowBitrateVideo() )
                 {
-                    auto averageBitrateTarget = prefs->getTargetBitrate( fMediaInfo, false, true );
+                    auto averageBitrateTarget = prefs->getTargetBitrate( mediaInfo, false, true );
                     fBitrateTooHigh = mediaInfo->getOverallBitRate() > averageBitrateTarget;
                 }
 
@@ -87,16 +91,29 @@ namespace NMediaManager
             {
             }
 
+            STranscodeNeeded::STranscodeNeeded( const QString &fileName, const STranscodeSummary &summary ) :
+                fWrongVideoCodec( summary.fWrongVideoCodec ),
+                fBitrateTooHigh( summary.fBitrateTooHigh ),
+                fVideoResolutionTooHigh( summary.fResolutionTooHigh ),
+                fWrongAudioCodec( summary.fWrongAudioCodec ),
+                fDefaultAudioNotAAC( summary.fDefaultAudioNotAAC ),
+                fWrongContainer( summary.fWrongContainer ),
+                fLoaded( true ),
+                fFileName( fileName ),
+                fTargetBitrateDisplay( summary.fTargetBitrateDisplay )
+            {
+            }
+
             bool STranscodeNeeded::isLoaded() const
             {
-                return fMediaInfo && fMediaInfo->aOK() && !fMediaInfo->isQueued();
+                return fLoaded;
             }
 
             std::optional< QString > STranscodeNeeded::getFormatMessage() const
             {
                 if ( wrongContainer() )
                 {
-                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> is not using a %2 container</p>" ).arg( QFileInfo( fMediaInfo->fileName() ).fileName() ).arg( NPreferences::NCore::CPreferences::instance()->getConvertMediaToContainer() );
+                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> is not using a %2 container</p>" ).arg( QFileInfo( fFileName ).fileName() ).arg( NPreferences::NCore::CPreferences::instance()->getConvertMediaToContainer() );
                     return msg;
                 }
                 return {};
@@ -106,7 +123,7 @@ namespace NMediaManager
             {
                 if ( wrongVideoCodec() )
                 {
-                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> is not using the '%2' video codec</p>" ).arg( QFileInfo( fMediaInfo->fileName() ).fileName() ).arg( NPreferences::NCore::CPreferences::instance()->getTranscodeToVideoCodec() );
+                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> is not using the '%2' video codec</p>" ).arg( QFileInfo( fFileName ).fileName() ).arg( NPreferences::NCore::CPreferences::instance()->getTranscodeToVideoCodec() );
                     return msg;
                 }
                 return {};
@@ -116,7 +133,7 @@ namespace NMediaManager
             {
                 if ( bitrateTooHigh() )
                 {
-                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> overall bit rate is higher than '%2'</p>" ).arg( QFileInfo( fMediaInfo->fileName() ).fileName() ).arg( NPreferences::NCore::CPreferences::instance()->getTargetBitrateDisplayString( fMediaInfo ) );
+                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> overall bit rate is higher than '%2'</p>" ).arg( QFileInfo( fFileName ).fileName() ).arg( fTargetBitrateDisplay );
                     return msg;
                 }
                 return {};
@@ -126,8 +143,7 @@ namespace NMediaManager
             {
                 if ( resolutionTooHigh() )
                 {
-                    auto resolution = fMediaInfo->getResolution();
-                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> resolution higher than HD resolution (1920x1080)</p>" ).arg( QFileInfo( fMediaInfo->fileName() ).fileName() );
+                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b> resolution higher than HD resolution (1920x1080)</p>" ).arg( QFileInfo( fFileName ).fileName() );
                     return msg;
                 }
                 return {};
@@ -138,14 +154,14 @@ namespace NMediaManager
                 if ( bitrateTooHigh() )
                 {
                     auto targetAudioCodec = defaultAudioNotAAC51() ? "AAC 5.1" : ( NPreferences::NCore::CPreferences::instance()->getTranscodeToAudioCodec() );
-                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b>'s overall bitrate is too high, removing all audio streams except the default an transcoding the audio track to the '%2' audio codec</p>" ).arg( QFileInfo( fMediaInfo->fileName() ).fileName() ).arg( targetAudioCodec );
+                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b>'s overall bitrate is too high, removing all audio streams except the default an transcoding the audio track to the '%2' audio codec</p>" ).arg( QFileInfo( fFileName ).fileName() ).arg( targetAudioCodec );
                     return msg;
                 }
 
                 if ( defaultAudioNotAAC51() || wrongAudioCodec() )
                 {
                     auto targetAudioCodec = defaultAudioNotAAC51() ? "AAC 5.1" : ( NPreferences::NCore::CPreferences::instance()->getTranscodeToAudioCodec() );
-                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b>'s default audio track is not the '%2' audio codec</p>" ).arg( QFileInfo( fMediaInfo->fileName() ).fileName() ).arg( targetAudioCodec );
+                    auto msg = QObject::tr( "<p style='white-space:pre'>File <b>'%1'</b>'s default audio track is not the '%2' audio codec</p>" ).arg( QFileInfo( fFileName ).fileName() ).arg( targetAudioCodec );
                     return msg;
                 }
 
@@ -172,7 +188,7 @@ namespace NMediaManager
 
                 if ( bitrateTooHigh() )
                 {
-                    actions << QObject::tr( "Transcode to an average overall bitrate of %1, removing all audio except default stream" ).arg( NPreferences::NCore::CPreferences::instance()->getTargetBitrateDisplayString( fMediaInfo ) );
+                    actions << QObject::tr( "Transcode to an average overall bitrate of %1, removing all audio except default stream" ).arg( fTargetBitrateDisplay );
                     actions << getActions();
                 }
 
@@ -39,10 +39,12 @@ namespace NMediaManager
         namespace NCore
         {
             class CPreferences;
+            struct STranscodeSummary;
             struct STranscodeNeeded
             {
                 STranscodeNeeded( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const CPreferences *prefs );
                 STranscodeNeeded( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo );
+                STranscodeNeeded( const QString &fileName, const STranscodeSummary &summary );   // the decisions from an earlier probe
 
                 bool isLoaded() const;
                 std::optional< QString > getFormatMessage() const;
@@ -58,6 +60,7 @@ namespace NMediaManager
                 QString getProgressLabelHeader( const QString &from, const QStringList & otherFiles, const QString &to ) const;
                 QString getHighResolutionProgressLabelHeader( const QString &from, const QStringList &otherFiles, const QString &to ) const;
                 QString getHighBitrateProgressLabelHeader( const QString &from, const QStringList &otherFiles, const QString &to ) const;
+                QString getProgressLabelHeader( const QString &from, const QStringList &mergedFiles, const QString &to, const QStringList &actions ) const;
 
                 bool transcodeNeeded() const { return fWrongVideoCodec || fWrongAudioCodec || fDefaultAudioNotAAC || fWrongContainer; }
 
@@ -72,15 +75,15 @@ namespace NMediaManager
                 bool wrongVideoCodec() const { return fWrongVideoCodec; }  // when true, the video codec needs to be transcoded
 
             private:
-                QString getProgressLabelHeader( const QString &from, const QStringList &mergedFiles, const QString &to, const QStringList &actions ) const;
-                
                 bool fWrongVideoCodec{ false };
                 bool fBitrateTooHigh{ false };
                 bool fVideoResolutionTooHigh{ false };
                 bool fWrongAudioCodec{ false };
                 bool fDefaultAudioNotAAC{ false };
                 bool fWrongContainer{ false };
-                std::shared_ptr< NSABUtils::CMediaInfo > fMediaInfo;
+                bool fLoaded{ false };
+                QString fFileName;
+                QString fTargetBitrateDisplay;
             };
         }
     }
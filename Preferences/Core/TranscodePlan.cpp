@@ -0,0 +1,146 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TranscodePlan.h"
+#include "Preferences.h"
+#include "PreferencesSnapshot.h"
+#include "MediaInfoCache.h"
+#include "SABUtils/MediaInfo.h"
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            STranscodePlan::STranscodePlan( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const CPreferences *prefs, uint64_t revision ) :
+                fRevision( revision ),
+                fMediaInfo( mediaInfo ),
+                fTranscodeNeeded( mediaInfo, prefs )
+            {
+                fHDResolution = NSABUtils::CMediaInfo::k1080pResolution.fResolution;
+                if ( !isLoaded() )
+                    return;
+
+                fTargetBitrateKbps = prefs->getTargetBitrate( mediaInfo, true, false );
+                fTargetBitrateDisplay = prefs->getTargetBitrateDisplayString( mediaInfo );
+                fSeconds = mediaInfo->getNumberOfSeconds();
+                fNumAudioStreams = static_cast< int >( mediaInfo->numAudioStreams() );
+                fNumSubtitleStreams = static_cast< int >( mediaInfo->numSubtitleStreams() );
+                setup( prefs );
+            }
+
+            STranscodePlan::STranscodePlan( const QString &fileName, const STranscodeSummary &summary, const CPreferences *prefs, uint64_t revision ) :
+                fRevision( revision ),
+                fTranscodeNeeded( fileName, summary )
+            {
+                fHDResolution = NSABUtils::CMediaInfo::k1080pResolution.fResolution;
+                fTargetBitrateKbps = summary.fTargetBitrateKbps;
+                fTargetBitrateDisplay = summary.fTargetBitrateDisplay;
+                fSeconds = summary.fSeconds;
+                fNumAudioStreams = summary.fNumAudioStreams;
+                fNumSubtitleStreams = summary.fNumSubtitleStreams;
+                setup( prefs );
+            }
+
+            void STranscodePlan::setup( const CPreferences *prefs )
+            {
+                fActions[ ETranscodeType::eOther ] = fTranscodeNeeded.getActions();
+                fActions[ ETranscodeType::eHighBitrate ] = fTranscodeNeeded.getHighBitrateAction();
+                fActions[ ETranscodeType::eHighRes ] = fTranscodeNeeded.getHighResolutionAction();
+                for ( auto &&ii : fActions )
+                {
+                    ii.second.removeAll( QString() );
+                    fSegmented[ ii.first ] = prefs->useSegmentedEncoding( fTranscodeNeeded, fSeconds, resolution( ii.first ), bitrate( ii.first ) );
+                }
+
+                fFormatMessage = fTranscodeNeeded.getFormatMessage();
+                fVideoCodecMessage = fTranscodeNeeded.getVideoCodecMessage();
+                fBitrateMessage = fTranscodeNeeded.getBitrateMessage();
+                fVideoResolutionMessage = fTranscodeNeeded.getVideoResolutionMessage();
+                fAudioCodecMessage = fTranscodeNeeded.getAudioCodecMessage();
+            }
+
+            STranscodeSummary STranscodePlan::summary( const QByteArray &rulesHash ) const
+            {
+                STranscodeSummary retVal;
+                retVal.fRulesHash = rulesHash;
+                retVal.fWrongContainer = fTranscodeNeeded.wrongContainer();
+                retVal.fWrongVideoCodec = fTranscodeNeeded.wrongVideoCodec();
+                retVal.fWrongAudioCodec = fTranscodeNeeded.wrongAudioCodec();
+                retVal.fDefaultAudioNotAAC = fTranscodeNeeded.defaultAudioNotAAC51();
+                retVal.fBitrateTooHigh = fTranscodeNeeded.bitrateTooHigh();
+                retVal.fResolutionTooHigh = fTranscodeNeeded.resolutionTooHigh();
+                retVal.fTargetBitrateKbps = fTargetBitrateKbps;
+                retVal.fTargetBitrateDisplay = fTargetBitrateDisplay;
+                retVal.fSeconds = fSeconds;
+                retVal.fNumAudioStreams = fNumAudioStreams;
+                retVal.fNumSubtitleStreams = fNumSubtitleStreams;
+                return retVal;
+            }
+
+            bool STranscodePlan::isCurrent( const std::shared_ptr< NSABUtils::CMediaInfo > &mediaInfo, uint64_t revision ) const
+            {
+                return ( fRevision == revision ) && ( fMediaInfo == mediaInfo ) && isLoaded();
+            }
+
+            const QStringList &STranscodePlan::actions( ETranscodeType type ) const
+            {
+                static const QStringList kEmpty;
+                auto pos = fActions.find( type );
+                if ( pos == fActions.end() )
+                    return kEmpty;
+                return ( *pos ).second;
+            }
+
+            std::optional< std::pair< int, int > > STranscodePlan::resolution( ETranscodeType type ) const
+            {
+                if ( type == ETranscodeType::eHighRes )
+                    return fHDResolution;
+                return {};
+            }
+
+            std::optional< uint64_t > STranscodePlan::bitrate( ETranscodeType type ) const
+            {
+                if ( type == ETranscodeType::eHighBitrate )
+                    return fTargetBitrateKbps;
+                return {};
+            }
+
+            bool STranscodePlan::useSegmentedEncoding( ETranscodeType type ) const
+            {
+                auto pos = fSegmented.find( type );
+                return ( pos != fSegmented.end() ) && ( *pos ).second;
+            }
+
+            QString STranscodePlan::progressLabel( ETranscodeType type, const QString &from, const QStringList &otherFiles, const QString &to ) const
+            {
+                return fTranscodeNeeded.getProgressLabelHeader( from, otherFiles, to, actions( type ) );
+            }
+
+            std::shared_ptr< const STranscodePlan > CPreferences::getTranscodePlan( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo ) const
+            {
+                return std::make_shared< STranscodePlan >( mediaInfo, this, snapshot()->fRevision );
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _CORE_TRANSCODEPLAN_H
+#define _CORE_TRANSCODEPLAN_H
+
+#include "TranscodeNeeded.h"
+
+#include <QStringList>
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace NSABUtils
+{
+    class CMediaInfo;
+}
+
+namespace NMediaManager
+{
+    namespace NPreferences
+    {
+        namespace NCore
+        {
+            class CPreferences;
+            struct STranscodeSummary;
+
+            enum class ETranscodeType
+            {
+                eHighRes,
+                eHighBitrate,
+                eOther
+            };
+
+            // what the transcode page decided for one file under one preferences revision
+            // built once by CPreferences::getTranscodePlan and never changed, so the item status, the display only pass and the run share it
+            struct STranscodePlan
+            {
+                STranscodePlan( std::shared_ptr< NSABUtils::CMediaInfo > mediaInfo, const CPreferences *prefs, uint64_t revision );
+                STranscodePlan( const QString &fileName, const STranscodeSummary &summary, const CPreferences *prefs, uint64_t revision );   // from the media info cache, fMediaInfo stays empty until the file is probed to run
+
+                STranscodeSummary summary( const QByteArray &rulesHash ) const;
+
+                bool isCurrent( const std::shared_ptr< NSABUtils::CMediaInfo > &mediaInfo, uint64_t revision ) const;   // false once the prefs change or the media info is reloaded
+                bool isLoaded() const { return fTranscodeNeeded.isLoaded(); }
+                bool workNeeded() const { return fTranscodeNeeded.transcodeNeeded() || fTranscodeNeeded.bitrateTooHigh() || fTranscodeNeeded.resolutionTooHigh(); }
+
+                const QStringList &actions( ETranscodeType type ) const;
+                std::optional< std::pair< int, int > > resolution( ETranscodeType type ) const;
+                std::optional< uint64_t > bitrate( ETranscodeType type ) const;   // kbps
+                bool useSegmentedEncoding( ETranscodeType type ) const;
+                QString progressLabel( ETranscodeType type, const QString &from, const QStringList &otherFiles, const QString &to ) const;
+
+                uint64_t fRevision{ 0 };
+                std::shared_ptr< NSABUtils::CMediaInfo > fMediaInfo;
+                STranscodeNeeded fTranscodeNeeded;
+
+                uint64_t fTargetBitrateKbps{ 0 };
+                QString fTargetBitrateDisplay;
+                std::pair< int, int > fHDResolution{ 0, 0 };
+
+                double fSeconds{ 0.0 };
+                int fNumAudioStreams{ 0 };
+                int fNumSubtitleStreams{ 0 };
+
+                std::map< ETranscodeType, QStringList > fActions;
+                std::map< ETranscodeType, bool > fSegmented;
+
+                // item status
+                std::optional< QString > fFormatMessage;
+                std::optional< QString > fVideoCodecMessage;
+                std::optional< QString > fBitrateMessage;
+                std::optional< QString > fVideoResolutionMessage;
+                std::optional< QString > fAudioCodecMessage;
+
+            private:
+                void setup( const CPreferences *prefs );   // the actions and messages, from fTranscodeNeeded
+            };
+        }
+    }
+}
+#endif
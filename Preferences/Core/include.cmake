@@ -30,14 +30,29 @@ set(qtproject_SRCS
     DefaultPreferences.cpp
     TranscodeNeeded.cpp
     TranscodeArgs.cpp
+    TranscodePlan.cpp
+    PathMatcher.cpp
+    MediaInfoCache.cpp
+    ComplianceStore.cpp
+    MediaProbePool.cpp
+    MKVProbe.cpp
+    BIFPlanner.cpp
 )
 
 set(qtproject_H
     Preferences.h
+    MediaProbePool.h
+    BIFPlanner.h
 )
 
 set(project_H
     TranscodeNeeded.h
+    TranscodePlan.h
+    PathMatcher.h
+    PreferencesSnapshot.h
+    MediaInfoCache.h
+    ComplianceStore.h
+    MKVProbe.h
 )
 
 set(qtproject_UIS
@@ -49,3 +64,9 @@ set(qtproject_QRC
 
 file(GLOB qtproject_QRC_SOURCES "resources/*")
 
+set( project_pri_DEPS
+        matroska2
+        ebml2
+        corec
+)
+
@@ -48,32 +48,33 @@ namespace NMediaManager
                 fImpl( new Ui::CGeneralSettings )
             {
                 fImpl->setupUi( this );
-                connect(
-                    fImpl->logDirBtn, &QToolButton::clicked,
-                    [ this ]()
-                    {
-                        auto dir = QFileDialog::getExistingDirectory( this, tr( "Select Directory" ), fImpl->logDir->text() );
-                        if ( dir.isEmpty() )
-                            return;
+                connect( fImpl->logDirBtn, &QToolButton::clicked, [ this ]() { selectDir( fImpl->logDir ); } );
+                connect( fImpl->scratchDirBtn, &QToolButton::clicked, [ this ]() { selectDir( fImpl->scratchDir ); } );
+            }
+
+            void CGeneralSettings::selectDir( QLineEdit *dirEdit )
+            {
+                auto dir = QFileDialog::getExistingDirectory( this, tr( "Select Directory" ), dirEdit->text() );
+                if ( dir.isEmpty() )
+                    return;
 
 #ifdef Q_OS_WINDOWS
-                        extern Q_CORE_EXPORT int qt_ntfs_permission_lookup;
-                        NSABUtils::CRevertValue revertValue( qt_ntfs_permission_lookup );
-                        qt_ntfs_permission_lookup++;
+                extern Q_CORE_EXPORT int qt_ntfs_permission_lookup;
+                NSABUtils::CRevertValue revertValue( qt_ntfs_permission_lookup );
+                qt_ntfs_permission_lookup++;
 #endif
 
-                        if ( !QFileInfo( dir ).isWritable() )
-                        {
-                            QMessageBox::critical( this, tr( "Invalid Directory" ), tr( "Directory '%1' is not writable" ).arg( dir ) );
-                            return;
-                        }
-                        if ( !QFileInfo( dir ).isExecutable() )
-                        {
-                            QMessageBox::critical( this, tr( "Invalid Directory" ), tr( "Directory '%1' does not have the proper permissions" ).arg( dir ) );
-                            return;
-                        }
-                        fImpl->logDir->setText( dir );
-                    } );
+                if ( !QFileInfo( dir ).isWritable() )
+                {
+                    QMessageBox::critical( this, tr( "Invalid Directory" ), tr( "Directory '%1' is not writable" ).arg( dir ) );
+                    return;
+                }
+                if ( !QFileInfo( dir ).isExecutable() )
+                {
+                    QMessageBox::critical( this, tr( "Invalid Directory" ), tr( "Directory '%1' does not have the proper permissions" ).arg( dir ) );
+                    return;
+                }
+                dirEdit->setText( dir );
             }
 
             CGeneralSettings::~CGeneralSettings()
@@ -84,16 +85,32 @@ namespace NMediaManager
             {
                 fImpl->loadMediaInfo->setChecked( NPreferences::NCore::CPreferences::instance()->getLoadMediaInfo() );
                 fImpl->backgroundLoadMediaInfo->setChecked( NPreferences::NCore::CPreferences::instance()->getBackgroundLoadMediaInfo() );
+                fImpl->numDirScanThreads->setValue( NPreferences::NCore::CPreferences::instance()->getNumDirScanThreads() );
+                fImpl->processThreadBudget->setValue( NPreferences::NCore::CPreferences::instance()->getProcessThreadBudget() );
+                fImpl->processesPerDisk->setValue( NPreferences::NCore::CPreferences::instance()->getProcessesPerDisk() );
+                fImpl->useScratchDir->setChecked( NPreferences::NCore::CPreferences::instance()->getUseScratchDir() );
+                fImpl->scratchDir->setText( NPreferences::NCore::CPreferences::instance()->getScratchDir() );
+                fImpl->scratchDirMinFreeGB->setValue( NPreferences::NCore::CPreferences::instance()->getScratchDirMinFreeGB() );
+                fImpl->loadDirectoriesOnDemand->setChecked( NPreferences::NCore::CPreferences::instance()->getLoadDirectoriesOnDemand() );
                 fImpl->enableLogging->setChecked( NPreferences::NCore::CPreferences::instance()->getLoggingEnabled() );
                 fImpl->logDir->setText( NPreferences::NCore::CPreferences::instance()->getLogDir() );
+                fImpl->jobLogRetentionDays->setValue( NPreferences::NCore::CPreferences::instance()->getJobLogRetentionDays() );
             }
 
             void CGeneralSettings::save()
             {
                 NPreferences::NCore::CPreferences::instance()->setLoadMediaInfo( fImpl->loadMediaInfo->isChecked() );
                 NPreferences::NCore::CPreferences::instance()->setBackgroundLoadMediaInfo( fImpl->backgroundLoadMediaInfo->isChecked() );
+                NPreferences::NCore::CPreferences::instance()->setNumDirScanThreads( fImpl->numDirScanThreads->value() );
+                NPreferences::NCore::CPreferences::instance()->setProcessThreadBudget( fImpl->processThreadBudget->value() );
+                NPreferences::NCore::CPreferences::instance()->setProcessesPerDisk( fImpl->processesPerDisk->value() );
+                NPreferences::NCore::CPreferences::instance()->setUseScratchDir( fImpl->useScratchDir->isChecked() );
+                NPreferences::NCore::CPreferences::instance()->setScratchDir( fImpl->scratchDir->text() );
+                NPreferences::NCore::CPreferences::instance()->setScratchDirMinFreeGB( fImpl->scratchDirMinFreeGB->value() );
+                NPreferences::NCore::CPreferences::instance()->setLoadDirectoriesOnDemand( fImpl->loadDirectoriesOnDemand->isChecked() );
                 NPreferences::NCore::CPreferences::instance()->setLoggingEnabled( fImpl->enableLogging->isChecked() );
                 NPreferences::NCore::CPreferences::instance()->setLogDir( fImpl->logDir->text() );
+                NPreferences::NCore::CPreferences::instance()->setJobLogRetentionDays( fImpl->jobLogRetentionDays->value() );
             }
         }
     }
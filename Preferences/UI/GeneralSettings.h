@@ -25,6 +25,8 @@
 
 #include "BasePrefPage.h"
 
+class QLineEdit;
+
 namespace NMediaManager
 {
     namespace NPreferences
@@ -48,6 +50,8 @@ namespace NMediaManager
             public Q_SLOTS:
 
             private:
+                void selectDir( QLineEdit *dirEdit );
+
                 std::unique_ptr< Ui::CGeneralSettings > fImpl;
             };
         }
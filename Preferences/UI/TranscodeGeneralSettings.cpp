@@ -60,6 +60,12 @@ namespace NMediaManager
 
                 fImpl->generateLowBitrateVideo->setChecked( NPreferences::NCore::CPreferences::instance()->getGenerateLowBitrateVideo() );
                 fImpl->bitrateThreshold->setValue( NPreferences::NCore::CPreferences::instance()->getBitrateThresholdPercentage() );
+
+                fImpl->useSegmentedEncoding->setChecked( NPreferences::NCore::CPreferences::instance()->getUseSegmentedEncoding() );
+                fImpl->numEncodeSegments->setValue( NPreferences::NCore::CPreferences::instance()->getNumEncodeSegments() );
+                fImpl->segmentedEncodingMinMinutes->setValue( NPreferences::NCore::CPreferences::instance()->getSegmentedEncodingMinMinutes() );
+
+                fImpl->showCompliantFiles->setChecked( NPreferences::NCore::CPreferences::instance()->getShowCompliantFiles() );
             }
 
             void CTranscodeGeneralSettings::save()
@@ -69,6 +75,12 @@ namespace NMediaManager
 
                 NPreferences::NCore::CPreferences::instance()->setGenerateLowBitrateVideo( fImpl->generateLowBitrateVideo->isChecked() );
                 NPreferences::NCore::CPreferences::instance()->setBitrateThresholdPercentage( fImpl->bitrateThreshold->value() );
+
+                NPreferences::NCore::CPreferences::instance()->setUseSegmentedEncoding( fImpl->useSegmentedEncoding->isChecked() );
+                NPreferences::NCore::CPreferences::instance()->setNumEncodeSegments( fImpl->numEncodeSegments->value() );
+                NPreferences::NCore::CPreferences::instance()->setSegmentedEncodingMinMinutes( fImpl->segmentedEncodingMinMinutes->value() );
+
+                NPreferences::NCore::CPreferences::instance()->setShowCompliantFiles( fImpl->showCompliantFiles->isChecked() );
             }
        }
     }
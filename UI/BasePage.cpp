@@ -25,6 +25,8 @@
 
 #include "Preferences/Core/Preferences.h"
 #include "Models/DirModel.h"
+#include "Models/ProcessJournal.h"
+#include "Models/ProcessLog.h"
 #include "SABUtils/DoubleProgressDlg.h"
 #include "SABUtils/SetMKVTags.h"
 #include "SABUtils/QtUtils.h"
@@ -32,6 +34,7 @@
 
 #include <QSettings>
 #include <QMenu>
+#include <QTextBlock>
 #include <QTimer>
 #include <QDesktopServices>
 #include <QSortFilterProxyModel>
@@ -69,13 +72,14 @@ namespace NMediaManager
                 {
                     auto menu = fImpl->log->createStandardContextMenu();
                     menu->addSeparator();
+                    menu->addAction( tr( "Open Job Logs Folder..." ), []() { QDesktopServices::openUrl( QUrl::fromLocalFile( NModels::CProcessLogBuffer::jobLogDir() ) ); } );
                     auto action = menu->addAction( tr( "Clear All" ) );
                     connect(
                         action, &QAction::triggered,
                         [ this ]()
                         {
                             fImpl->log->clear();
-                            ;
+                            fProcessBlocks = 0;
                         } );
                     menu->exec( mouseEvent->globalPos() );
                     delete menu;
@@ -195,14 +199,7 @@ namespace NMediaManager
                     fModel->clearMessages();
             }
 
-            if ( !fModel )
-            {
-                fModel.reset( createDirModel() );
-                connect( fModel.get(), &NModels::CDirModel::sigDirLoadFinished, this, &CBasePage::slotLoadFinished );
-                connect( fModel.get(), &NModels::CDirModel::sigProcessingStarted, this, &CBasePage::slotProcessingStarted );
-                connect( fModel.get(), &NModels::CDirModel::sigProcessesFinished, this, &CBasePage::slotProcessesFinished );
-                connect( fModel.get(), &NModels::CDirModel::sigDialogClosed, this, &CBasePage::sigDialogClosed );
-            }
+            ensureModel();
             appendSeparatorToLog();
             appendToLog( tr( "Loading Directory: '%1'" ).arg( fDirName ), true );
             appendSeparatorToLog();
@@ -215,6 +212,36 @@ namespace NMediaManager
             emit sigLoading();
         }
 
+        void CBasePage::ensureModel()
+        {
+            if ( fModel )
+                return;
+
+            fModel.reset( createDirModel() );
+            connect( fModel.get(), &NModels::CDirModel::sigDirLoadFinished, this, &CBasePage::slotLoadFinished );
+            connect( fModel.get(), &NModels::CDirModel::sigProcessingStarted, this, &CBasePage::slotProcessingStarted );
+            connect( fModel.get(), &NModels::CDirModel::sigProcessesFinished, this, &CBasePage::slotProcessesFinished );
+            connect( fModel.get(), &NModels::CDirModel::sigDialogClosed, this, &CBasePage::sigDialogClosed );
+        }
+
+        void CBasePage::resumeJobs( const std::list< NModels::SJournalJob > &jobs )
+        {
+            if ( !fImpl || jobs.empty() )
+                return;
+
+            ensureModel();
+            if ( fDirName.isEmpty() )
+                fDirName = QFileInfo( jobs.front().fOldName ).absolutePath();   // what is reloaded once the jobs finish
+
+            appendSeparatorToLog();
+            appendToLog( tr( "Resuming %1 unfinished jobs from the last session" ).arg( jobs.size() ), true );
+            appendSeparatorToLog();
+
+            setupProgressDlg( actionTitleName(), actionCancelName(), static_cast< int >( jobs.size() ) );
+            slotProcessingStarted();
+            fModel->resumeProcesses( jobs );
+        }
+
         void CBasePage::setupModel()
         {
             fModel->setRootPath( fDirName );
@@ -253,7 +280,7 @@ namespace NMediaManager
             {
                 fModel->showProcessResults( actionErrorName(), tr( "Issues:" ), QMessageBox::Critical, QDialogButtonBox::Ok, this );
             }
-            if ( !canceled && reloadModel )
+            if ( !canceled && reloadModel && fModel->reloadNeededAfterProcessing() )   // otherwise the model updates the changed directories itself
                 load( true );
             stayAwake( false );
         }
@@ -393,17 +420,87 @@ namespace NMediaManager
 
         void CBasePage::appendToLog( const QString &msg, std::pair< QString, bool > &previousText, bool /*stdOut*/, bool fromProcess )
         {
-            showResults();
-
             QString realMessage = msg;
             if ( !fromProcess && !realMessage.endsWith( "\n" ) )
                 realMessage += "\n";
 
-            auto prevText = previousText;
-            NSABUtils::appendToLog( fImpl->log, realMessage, previousText, NPreferences::NCore::CPreferences::instance()->getLogStream() );
+            writeToLog( realMessage, previousText, fromProcess );
             fModel->processLog( realMessage, fProgressDlg );
         }
 
+        void CBasePage::appendProcessOutput( const QString &msg, std::pair< QString, bool > &previousText )
+        {
+            writeToLog( msg, previousText, true );
+        }
+
+        namespace
+        {
+            const int kProcessBlock = 1;   // QTextBlock::userState of the lines a process wrote
+        }
+
+        void CBasePage::writeToLog( const QString &msg, std::pair< QString, bool > &previousText, bool fromProcess )
+        {
+            showResults();
+
+            auto doc = fImpl->log->document();
+            auto first = doc->lastBlock();   // the output may continue a partial line or fill the empty trailing block
+            if ( ( first.userState() != kProcessBlock ) && !first.text().isEmpty() )
+                first = first.next();
+            auto firstNum = first.isValid() ? first.blockNumber() : doc->blockCount();
+
+            NSABUtils::appendToLog( fImpl->log, msg, previousText, NPreferences::NCore::CPreferences::instance()->getLogStream() );
+
+            if ( !fromProcess )
+                return;
+
+            for ( auto block = doc->findBlockByNumber( firstNum ); block.isValid(); block = block.next() )
+            {
+                if ( block.userState() == kProcessBlock )
+                    continue;
+                if ( ( block == doc->lastBlock() ) && block.text().isEmpty() )
+                    break;   // the empty block after the final line break belongs to whatever is written next
+                block.setUserState( kProcessBlock );
+                fProcessBlocks++;
+            }
+            if ( fProcessBlocks > kMaxProcessBlocks )
+                trimProcessOutput();
+        }
+
+        void CBasePage::trimProcessOutput()
+        {
+            // trimmed to 90% so a busy job does not pay for a document edit on every flush
+            auto toRemove = fProcessBlocks - ( kMaxProcessBlocks * 9 ) / 10;
+            auto doc = fImpl->log->document();
+            auto lastBlock = doc->lastBlock();
+
+            QTextCursor cursor( doc );
+            cursor.beginEditBlock();
+            auto block = doc->begin();
+            while ( ( toRemove > 0 ) && block.isValid() && ( block != lastBlock ) )
+            {
+                if ( block.userState() != kProcessBlock )
+                {
+                    block = block.next();
+                    continue;
+                }
+
+                // a run of process lines is removed in one go, with the line break that ends each of them
+                auto start = block.position();
+                while ( ( toRemove > 0 ) && block.isValid() && ( block != lastBlock ) && ( block.userState() == kProcessBlock ) )
+                {
+                    toRemove--;
+                    fProcessBlocks--;
+                    block = block.next();
+                }
+                auto end = block.position();
+                cursor.setPosition( start );
+                cursor.setPosition( end, QTextCursor::KeepAnchor );
+                cursor.removeSelectedText();
+                block = doc->findBlock( start );
+            }
+            cursor.endEditBlock();
+        }
+
         void CBasePage::editMediaInfo( const QModelIndex &idx )
         {
             auto fn = fModel->fileInfo( idx ).absoluteFilePath();
@@ -24,6 +24,7 @@
 #define _BASEPAGE_H
 
 #include <QWidget>
+#include <list>
 class QVBoxLayout;
 class QAbstractItemModel;
 #include "Preferences/Core/Preferences.h"
@@ -42,6 +43,7 @@ namespace NMediaManager
     namespace NModels
     {
         class CDirModel;
+        struct SJournalJob;
     }
 }
 
@@ -64,6 +66,7 @@ namespace NMediaManager
             virtual void load( bool postRun );
 
             void clearDirModel();
+            void resumeJobs( const std::list< NModels::SJournalJob > &jobs );   // reruns jobs the process journal recorded as unfinished
 
             virtual void run( const QModelIndex &idx );
             virtual bool canRun() const;
@@ -73,6 +76,7 @@ namespace NMediaManager
             virtual void appendSeparatorToLog();
             virtual void appendToLog( const QString &msg, bool stdOut ) final;
             virtual void appendToLog( const QString &msg, std::pair< QString, bool > &previousText, bool stdOut, bool fromProcess );
+            void appendProcessOutput( const QString &msg, std::pair< QString, bool > &previousText );   // log widget and session log only, no progress parsing
 
             virtual bool extendContextMenu( QMenu *menu, const QModelIndex &idx );
 
@@ -92,6 +96,7 @@ namespace NMediaManager
             void editMediaInfo( const QModelIndex &idx );
 
             QVBoxLayout *mainLayout() const;
+            virtual QString getPageName() const final { return fPageName; }
         public Q_SLOTS:
             void slotLoadFinished( bool canceled );
             void slotProcessingStarted();
@@ -112,7 +117,6 @@ namespace NMediaManager
             virtual QMenu *menuForIndex( const QModelIndex &idx ) final;
             virtual void openLocation( const QModelIndex &idx ) final;
 
-            virtual QString getPageName() const final { return fPageName; }
             virtual NModels::CDirModel *createDirModel() = 0;
             virtual QAbstractItemModel *getDirModel() const;
             virtual bool useSecondaryProgressBar() const { return false; }
@@ -127,6 +131,7 @@ namespace NMediaManager
             virtual void postNonQueuedRun( bool finalStep, bool canceled );
             virtual void postLoadFinished( bool /*canceled*/ );
             virtual void setupModel();
+            void ensureModel();
 
             void setupProgressDlg( const QString &title, const QString &cancelButtonText, int max, int eventsPerPath = 1 );
             void clearProgressDlg( bool canceled );
@@ -136,11 +141,17 @@ namespace NMediaManager
 
             void stayAwake( bool enable );
 
+            void writeToLog( const QString &msg, std::pair< QString, bool > &previousText, bool fromProcess );
+            void trimProcessOutput();   // drops the oldest process blocks once over kMaxProcessBlocks, the app's own messages are kept
+
             QString fPageName;
             QString fDirName;
 
             bool fIsActive{ false };
 
+            static const int kMaxProcessBlocks{ 10000 };   // the full process output is in the per job logs
+            int fProcessBlocks{ 0 };   // blocks in the log widget tagged as process output
+
             NSABUtils::CDoubleProgressDlg *fProgressDlg{ nullptr };
             std::unique_ptr< NModels::CDirModel > fModel;
             std::unique_ptr< Ui::CBasePage > fImpl;
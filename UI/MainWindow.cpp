@@ -32,7 +32,12 @@
 
 #include "Preferences/UI/Preferences.h"
 #include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/MediaInfoCache.h"
+#include "Preferences/Core/ComplianceStore.h"
+#include "Preferences/Core/BIFPlanner.h"
+#include "Preferences/Core/MediaProbePool.h"
 #include "Models/DirModel.h"
+#include "Models/ProcessJournal.h"
 #include "Core/SearchTMDBInfo.h"
 #include "Core/SearchTMDB.h"
 #include "SABUtils/FileUtils.h"
@@ -58,10 +63,13 @@
 #include <QTimer>
 #include <QPixmap>
 #include <QLabel>
+#include <QStatusBar>
 #include <QSpinBox>
 #include <QThreadPool>
 #include <QAbstractNativeEventFilter>
 
+#include <map>
+
 #ifdef Q_OS_WINDOWS
     #include <qt_windows.h>
     #include <windowsx.h>
@@ -175,12 +183,14 @@ namespace NMediaManager
             connect( fImpl->actionRun, &QAction::triggered, this, &CMainWindow::slotRun );
 
             connect( fImpl->actionPreferences, &QAction::triggered, this, &CMainWindow::slotPreferences );
+            connect( fImpl->actionPruneMediaInfoCache, &QAction::triggered, this, &CMainWindow::slotPruneMediaInfoCache );
 
             connect( fImpl->tabWidget, &QTabWidget::currentChanged, this, &CMainWindow::slotWindowChanged );
 
             loadSettings();
 
             connect( NPreferences::NCore::CPreferences::instance(), &NPreferences::NCore::CPreferences::sigPreferencesChanged, this, &CMainWindow::slotPreferencesChanged );
+            connect( NPreferences::NCore::CMediaProbePool::instance(), &NPreferences::NCore::CMediaProbePool::sigQueueDrained, this, &CMainWindow::slotMediaProbesFinished );
 
             new NSABUtils::CSelectFileUrl( this );
 
@@ -189,11 +199,17 @@ namespace NMediaManager
             QTimer::singleShot( 0, this, &CMainWindow::slotDirectoryChangedImmediate );
             QTimer::singleShot( 0, this, &CMainWindow::slotWindowChanged );
             QTimer::singleShot( 0, this, &CMainWindow::slotValidateDefaults );
+            QTimer::singleShot( 0, this, &CMainWindow::slotResumeJournal );
         }
 
         CMainWindow::~CMainWindow()
         {
             saveSettings();
+            NPreferences::NCore::CMediaInfoCache::instance()->save();
+            NPreferences::NCore::CComplianceStore::instance()->save();
+            // the statics would otherwise wait on ffprobe after the application is gone
+            NPreferences::NCore::CBIFPlanner::instance()->shutdown();
+            NPreferences::NCore::CMediaProbePool::instance()->shutdown();
             if ( fStayAwake )
                 delete fStayAwake;
         }
@@ -248,6 +264,43 @@ namespace NMediaManager
 #endif
         }
 
+        void CMainWindow::slotResumeJournal()
+        {
+            // only the instance that owns the journal can be sure no other instance is staging on the scratch disk
+            if ( NModels::CProcessJournal::instance()->isOwner() )
+                NModels::CDirModel::removeOrphanedStagingDirs();
+
+            auto jobs = NModels::CProcessJournal::instance()->unfinishedFromLastSession();
+            if ( jobs.empty() )
+                return;
+
+            auto answer = QMessageBox::question( this, tr( "Unfinished Jobs" ), tr( "%1 jobs did not finish when MediaManager last exited.<br>Any partial output will be removed, completed output is kept.<br><br>Would you like to resume them?" ).arg( jobs.size() ), QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes );
+            if ( answer != QMessageBox::Yes )
+            {
+                NModels::CProcessJournal::instance()->discard( jobs );
+                return;
+            }
+
+            std::map< QString, std::list< NModels::SJournalJob > > jobsByPage;
+            for ( auto &&ii : jobs )
+            {
+                NModels::CProcessJournal::instance()->cleanupPartialOutputs( ii );
+                jobsByPage[ ii.fPageName ].push_back( ii );
+            }
+
+            for ( auto &&ii : jobsByPage )
+            {
+                auto pos = std::find_if( fUIComponentMap.begin(), fUIComponentMap.end(), [ &ii ]( const std::shared_ptr< STabDef > &tabDef ) { return tabDef->fPage->getPageName() == ii.first; } );
+                if ( pos == fUIComponentMap.end() )
+                {
+                    NModels::CProcessJournal::instance()->discard( ii.second );
+                    continue;
+                }
+                fImpl->tabWidget->setCurrentIndex( fImpl->tabWidget->indexOf( ( *pos )->fTab ) );
+                ( *pos )->fPage->resumeJobs( ii.second );
+            }
+        }
+
         void CMainWindow::slotPreferencesChanged( NPreferences::EPreferenceTypes prefType )
         {
             if ( ( prefType & NPreferences::EPreferenceType::eSystemPrefs ) != 0 )
@@ -436,6 +489,22 @@ namespace NMediaManager
             }
         }
 
+        void CMainWindow::slotPruneMediaInfoCache()
+        {
+            int numRemoved = 0;
+            {
+                NSABUtils::CAutoWaitCursor awc;
+                numRemoved = NPreferences::NCore::CMediaInfoCache::instance()->prune();
+                NPreferences::NCore::CComplianceStore::instance()->prune();
+            }
+            QMessageBox::information( this, tr( "Media Info Cache" ), tr( "Removed %1 stale entries from the media info cache." ).arg( numRemoved ) );
+        }
+
+        void CMainWindow::slotMediaProbesFinished()
+        {
+            statusBar()->showMessage( tr( "Media information loaded: %1" ).arg( NPreferences::NCore::CMediaProbePool::instance()->statsString() ), 30000 );
+        }
+
         void CMainWindow::clearDirModel()
         {
             auto basePage = getCurrentBasePage();
@@ -86,6 +86,8 @@ namespace NMediaManager
             virtual void slotLoad();
             virtual void slotRun();
             virtual void slotPreferences();
+            void slotPruneMediaInfoCache();
+            void slotMediaProbesFinished();
 
             void slotQueuedPrefChange();
 
@@ -94,6 +96,7 @@ namespace NMediaManager
             virtual void slotLoadFinished( bool canceled );
             virtual void slotFileCheckFinished( bool aOK, const QString &msg );
             virtual void slotValidateDefaults();
+            void slotResumeJournal();
             virtual void slotPreferencesChanged( NPreferences::EPreferenceTypes prefType );
 
         Q_SIGNALS:
@@ -116,6 +116,7 @@ namespace NMediaManager
             }
 
             Q_ASSERT( filesView()->model() == model() );
+            model()->fetchAll();
             fSearchTMDB->resetResults();
 
             auto count = NSABUtils::itemCount( model(), true );
@@ -0,0 +1,240 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+#include "Models/DirScanner.h"
+
+#include <QFile>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#ifdef Q_OS_WINDOWS
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        int maxBenchmarkRows()
+        {
+            bool aOK = false;
+            auto retVal = qEnvironmentVariableIntValue( "MEDIAMANAGER_BENCHMARK_MAX_ROWS", &aOK );
+            return aOK ? retVal : 10000;
+        }
+
+        const std::vector< int > &benchmarkRowCounts()
+        {
+            static const std::vector< int > sRowCounts = { 10000, 100000, 1000000 };
+            return sRowCounts;
+        }
+
+        qint64 residentBytes()
+        {
+#if defined( Q_OS_WINDOWS )
+            PROCESS_MEMORY_COUNTERS counters;
+            if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+                return static_cast< qint64 >( counters.WorkingSetSize );
+#elif defined( Q_OS_LINUX )
+            QFile file( "/proc/self/statm" );
+            if ( file.open( QFile::ReadOnly ) )
+            {
+                auto fields = QString::fromLatin1( file.readAll() ).split( ' ', Qt::SkipEmptyParts );
+                if ( fields.size() > 1 )
+                    return fields[ 1 ].toLongLong() * sysconf( _SC_PAGESIZE );
+            }
+#endif
+            return 0;
+        }
+
+        qint64 elapsedMS( const std::function< void() > &func )
+        {
+            QElapsedTimer timer;
+            timer.start();
+            func();
+            return timer.elapsed();
+        }
+
+        bool dropFileSystemCaches()
+        {
+#ifdef Q_OS_LINUX
+            ::sync();
+            QFile file( "/proc/sys/vm/drop_caches" );
+            if ( !file.open( QFile::WriteOnly ) )
+                return false;
+            return file.write( "3\n" ) == 2;
+#else
+            return false;
+#endif
+        }
+
+        void CRowCountBenchmark::SetUp()
+        {
+            if ( numRows() > maxBenchmarkRows() )
+                GTEST_SKIP() << "set MEDIAMANAGER_BENCHMARK_MAX_ROWS to at least " << numRows() << " to run";
+        }
+
+        void report( const QString &benchmark, int numRows, const QString &variant, qint64 msecs, qint64 bytes )
+        {
+            auto msg = QString( "%1 rows=%2 %3: %4ms" ).arg( benchmark ).arg( numRows ).arg( variant ).arg( msecs );
+            if ( bytes >= 0 )
+                msg += QString( " %1 bytes/row" ).arg( numRows ? ( bytes / numRows ) : 0 );
+            std::cout << qPrintable( msg ) << std::endl;
+
+            auto key = QString( "%1_%2" ).arg( variant ).arg( numRows );
+            ::testing::Test::RecordProperty( qPrintable( key + "_ms" ), static_cast< int >( msecs ) );
+            if ( bytes >= 0 )
+                ::testing::Test::RecordProperty( qPrintable( key + "_bytes" ), static_cast< int >( std::min< qint64 >( bytes, std::numeric_limits< int >::max() ) ) );
+        }
+
+        CSyntheticTree::CSyntheticTree( int numFiles ) :
+            fDir( std::make_unique< QTemporaryDir >() ),
+            fNumFiles( numFiles )
+        {
+            if ( !fDir->isValid() )
+                return;
+
+            static const int kTitlesPerGroup = 100;
+            QDir root( fDir->path() );
+            auto numTitles = ( numFiles + 1 ) / 2;
+            for ( int ii = 0; ii < numTitles; ++ii )
+            {
+                auto group = QString( "Group %1" ).arg( ii / kTitlesPerGroup, 5, 10, QChar( '0' ) );
+                auto title = QString( "Title %1 (2000)" ).arg( ii, 7, 10, QChar( '0' ) );
+                auto dirPath = QString( "%1/%2" ).arg( group ).arg( title );
+                if ( !root.mkpath( dirPath ) )
+                    return;
+
+                QDir dir( root.absoluteFilePath( dirPath ) );
+                for ( auto &&ext : { ".mkv", ".en.srt", ".nfo" } )
+                {
+                    QFile file( dir.absoluteFilePath( title + ext ) );
+                    if ( !file.open( QFile::WriteOnly ) )
+                        return;
+                }
+            }
+            fValid = true;
+        }
+
+        bool CSyntheticTree::isValid() const
+        {
+            return fValid;
+        }
+
+        QString CSyntheticTree::rootPath() const
+        {
+            return fDir->path();
+        }
+
+        QStringList CSyntheticTree::nameFilters()
+        {
+            return { "*.mkv", "*.srt" };
+        }
+
+        SScanResult scanTree( const QString &rootPath, const QStringList &nameFilters, int numThreads )
+        {
+            SScanResult retVal;
+            auto batchReady = [ &retVal ]( std::shared_ptr< NModels::TDirScanBatch > batch, int filesFound, bool /*finished*/ )
+            {
+                for ( auto &&ii : *batch )
+                {
+                    if ( ii.fType == NModels::SDirScanEntry::EType::eDirEnd )
+                        continue;
+                    auto path = ii.fFileInfo.absoluteFilePath();
+                    if ( ii.fType == NModels::SDirScanEntry::EType::eDirStart )
+                        path += "/";
+                    retVal.fEntries.push_back( path );
+                }
+                retVal.fFilesFound = filesFound;
+            };
+
+            NModels::CDirScanner scanner( QFileInfo( rootPath ), nameFilters, {}, batchReady, numThreads, {}, {} );
+            scanner.start();
+            scanner.wait();
+            return retVal;
+        }
+
+        QString findTool( const QString &name )
+        {
+            auto retVal = qEnvironmentVariable( qPrintable( "MEDIAMANAGER_" + name.toUpper() ) );
+            if ( retVal.isEmpty() )
+                retVal = QStandardPaths::findExecutable( name );
+            return QFileInfo( retVal ).isExecutable() ? retVal : QString();
+        }
+
+        bool createSampleMKV( const QString &fileName, int seconds, QString *errorMsg )
+        {
+            auto ffmpeg = findTool( "ffmpeg" );
+            if ( ffmpeg.isEmpty() )
+            {
+                if ( errorMsg )
+                    *errorMsg = "ffmpeg not found";
+                return false;
+            }
+
+            auto srtName = fileName + ".en.srt";
+            {
+                QFile srt( srtName );
+                if ( !srt.open( QFile::WriteOnly | QFile::Truncate ) )
+                {
+                    if ( errorMsg )
+                        *errorMsg = QString( "Could not write '%1'" ).arg( srtName );
+                    return false;
+                }
+                QTextStream ts( &srt );
+                ts << "1\n00:00:00,500 --> 00:00:01,500\nSample subtitle\n";
+            }
+
+            // only encoders built into every ffmpeg, so the sample does not depend on the build's external libraries
+            auto args = QStringList()                                                                                       //
+                        << "-hide_banner" << "-y"                                                                           //
+                        << "-f" << "lavfi" << "-i" << QString( "testsrc=size=640x360:rate=24:duration=%1" ).arg( seconds )   //
+                        << "-f" << "lavfi" << "-i" << QString( "sine=frequency=440:sample_rate=48000:duration=%1" ).arg( seconds )   //
+                        << "-i" << srtName                                                                                  //
+                        << "-map" << "0:v" << "-map" << "1:a" << "-map" << "2:s"                                            //
+                        << "-c:v" << "mpeg4" << "-q:v" << "5"                                                               //
+                        << "-c:a" << "aac" << "-ac" << "2"                                                                  //
+                        << "-c:s" << "srt" << "-metadata:s:s:0" << "language=eng"                                           //
+                        << "-metadata" << "title=Sample Title"                                                              //
+                        << fileName;
+
+            QProcess process;
+            process.start( ffmpeg, args );
+            auto aOK = process.waitForFinished( -1 ) && ( process.exitStatus() == QProcess::NormalExit ) && ( process.exitCode() == 0 );
+            QFile::remove( srtName );
+            if ( !aOK && errorMsg )
+                *errorMsg = QString::fromLocal8Bit( process.readAllStandardError() );
+            return aOK && QFileInfo( fileName ).isFile();
+        }
+    }
+}
@@ -0,0 +1,95 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef _UNITTESTS_BENCHMARKUTILS_H
+#define _UNITTESTS_BENCHMARKUTILS_H
+
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        // the benchmarks are instantiated at 10k, 100k and 1M rows, the larger ones are opt in
+        int maxBenchmarkRows();   // MEDIAMANAGER_BENCHMARK_MAX_ROWS, 10000 when not set
+        const std::vector< int > &benchmarkRowCounts();
+
+        qint64 residentBytes();   // 0 where the platform does not report it
+        qint64 elapsedMS( const std::function< void() > &func );
+        void report( const QString &benchmark, int numRows, const QString &variant, qint64 msecs, qint64 bytes = -1 );
+
+        // drops the kernel's page, dentry and inode caches so the next walk reads the storage, needs root on linux
+        // returns false when they could not be dropped, the numbers are then warm cache numbers
+        bool dropFileSystemCaches();
+
+        // the fixture every row count benchmark derives from, the counts above maxBenchmarkRows() are skipped in SetUp
+        class CRowCountBenchmark : public ::testing::TestWithParam< int >
+        {
+        protected:
+            void SetUp() override;
+            int numRows() const { return GetParam(); }
+        };
+
+        // a media library laid out like the ones the pages load
+        // one directory per title, each with a video, a subtitle and a metadata file, grouped 100 titles to a parent directory
+        // numFiles counts the files the name filters keep, two per title
+        class CSyntheticTree
+        {
+        public:
+            CSyntheticTree( int numFiles );
+
+            bool isValid() const;
+            QString rootPath() const;
+            int numFiles() const { return fNumFiles; }
+
+            static QStringList nameFilters();   // the videos and subtitles, the metadata files are filtered out
+
+        private:
+            std::unique_ptr< QTemporaryDir > fDir;
+            int fNumFiles{ 0 };
+            bool fValid{ false };
+        };
+
+        struct SScanResult
+        {
+            std::vector< QString > fEntries;   // every delivered entry in order, directories marked with a trailing '/'
+            int fFilesFound{ 0 };
+        };
+        SScanResult scanTree( const QString &rootPath, const QStringList &nameFilters, int numThreads );   // through CDirScanner, as the models load
+
+        // the media tests need the external tools, MEDIAMANAGER_FFMPEG/MEDIAMANAGER_FFPROBE or the PATH, empty when not found
+        QString findTool( const QString &name );
+        // a short matroska file with an mpeg4 video, a stereo aac audio and an english subrip subtitle track
+        bool createSampleMKV( const QString &fileName, int seconds, QString *errorMsg = nullptr );
+    }
+}
+
+#define INSTANTIATE_ROW_COUNT_BENCHMARK( fixture ) INSTANTIATE_TEST_SUITE_P( Rows, fixture, ::testing::ValuesIn( NMediaManager::NUnitTests::benchmarkRowCounts() ) )
+#endif
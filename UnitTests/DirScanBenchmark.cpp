@@ -0,0 +1,202 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+
+#include <QDir>
+#include <QDirIterator>
+
+#include <gtest/gtest.h>
+
+#include <functional>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            // the load as it was before the single pass scan
+            // CDirModel::iterateEveryFile with the functions of computeNumberOfFiles and then of loadFileInfo, kept line for line
+            // the model and progress dialog work, the same for both loads, is left out, the file system work each row did in STreeNode is kept
+            class CLegacyLoad
+            {
+            public:
+                CLegacyLoad( const QStringList &nameFilters ) :
+                    fNameFilters( nameFilters )
+                {
+                }
+
+                int load( const QFileInfo &rootInfo )
+                {
+                    computeNumberOfFiles( rootInfo );
+                    return loadFileInfo( rootInfo );
+                }
+
+                int numDirs() const { return fNumDirs; }
+                int numFilesCounted() const { return fNumFilesCounted; }
+
+            private:
+                struct SIterateInfo
+                {
+                    std::function< bool( const QFileInfo &dirInfo ) > fPreDirFunction;
+                    std::function< void( const QFileInfo &dirInfo, bool aOK ) > fPostDirFunction;
+                    std::function< bool( const QFileInfo &fileInfo ) > fPreFileFunction;
+                    std::function< void( const QFileInfo &fileInfo, bool aOK ) > fPostFileFunction;
+                };
+
+                std::unique_ptr< QDirIterator > getDirIteratorForPath( const QFileInfo &fileInfo ) const
+                {
+                    auto filter = fNameFilters;
+                    auto tmp = filter;
+                    tmp.sort();
+                    return std::make_unique< QDirIterator >( fileInfo.absoluteFilePath(), filter, QDir::AllDirs | QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable );
+                }
+
+                void iterateEveryFile( const QFileInfo &fileInfo, const SIterateInfo &iterInfo, bool countOnly ) const
+                {
+                    if ( fileInfo.isDir() )
+                    {
+                        bool iteraterDir = true;
+                        if ( iterInfo.fPreDirFunction )
+                            iteraterDir = iterInfo.fPreDirFunction( fileInfo );
+
+                        if ( iteraterDir )
+                        {
+                            auto ii = getDirIteratorForPath( fileInfo );
+                            while ( ii->hasNext() )
+                            {
+                                ii->next();
+                                auto fi = ii->fileInfo();
+                                iterateEveryFile( fi, iterInfo, countOnly );
+                            }
+                        }
+
+                        if ( iterInfo.fPostDirFunction )
+                            iterInfo.fPostDirFunction( fileInfo, true );
+                    }
+                    else if ( fileInfo.isFile() )
+                    {
+                        bool aOK = true;
+                        if ( iterInfo.fPreFileFunction )
+                            aOK = iterInfo.fPreFileFunction( fileInfo );
+                        if ( iterInfo.fPostFileFunction )
+                            iterInfo.fPostFileFunction( fileInfo, aOK );
+                    }
+                }
+
+                void computeNumberOfFiles( const QFileInfo &fileInfo )
+                {
+                    SIterateInfo info;
+                    info.fPreDirFunction = [ this ]( const QFileInfo &dirInfo )
+                    {
+                        fNumDirs++;
+
+                        // the progress maximum grew by every child directory, read with a second iterator
+                        auto iter = QDirIterator(
+                            dirInfo.absoluteFilePath(),
+                            QStringList() << "*"
+                                          << "*.*",
+                            QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Readable );
+                        while ( iter.hasNext() )
+                        {
+                            fPrimaryMax++;
+                            iter.next();
+                        }
+                        return true;
+                    };
+                    info.fPreFileFunction = [ this ]( const QFileInfo & /*fileInfo*/ )
+                    {
+                        fNumFilesCounted++;
+                        return false;
+                    };
+                    iterateEveryFile( fileInfo, info, true );
+                }
+
+                int loadFileInfo( const QFileInfo &fileInfo )
+                {
+                    int numLoaded = 0;
+                    auto treeNode = [ this ]( const QFileInfo &fileInfo )
+                    {
+                        // what STreeNode read from the file system for every row
+                        fRowData += fileInfo.isFile();
+                        fRowData += fileInfo.canonicalFilePath().length();
+                        fRowData += fileInfo.isDir();
+                        fRowData += fileInfo.isFile() ? fileInfo.size() : 0;
+                        fRowData += fileInfo.lastModified().toMSecsSinceEpoch();
+                    };
+
+                    SIterateInfo info;
+                    info.fPreDirFunction = [ treeNode ]( const QFileInfo &dirInfo )
+                    {
+                        treeNode( dirInfo );
+                        return true;
+                    };
+                    info.fPreFileFunction = [ treeNode, &numLoaded ]( const QFileInfo &fileInfo )
+                    {
+                        treeNode( fileInfo );
+                        numLoaded++;
+                        return true;
+                    };
+                    iterateEveryFile( fileInfo, info, false );
+                    return numLoaded;
+                }
+
+                QStringList fNameFilters;
+                int fNumDirs{ 0 };
+                int fNumFilesCounted{ 0 };
+                int fPrimaryMax{ 0 };
+                qint64 fRowData{ 0 };
+            };
+        }
+
+        class CDirScanBenchmark : public CRowCountBenchmark
+        {
+        };
+
+        TEST_P( CDirScanBenchmark, SinglePassVsTwoPass )
+        {
+            CSyntheticTree tree( numRows() );
+            ASSERT_TRUE( tree.isValid() );
+
+            // the model scans with the thread count from the preferences, one thread keeps the comparison to the walk itself
+            CLegacyLoad legacy( CSyntheticTree::nameFilters() );
+            int legacyFiles = 0;
+            auto legacyCold = dropFileSystemCaches();
+            auto legacyMS = elapsedMS( [ & ]() { legacyFiles = legacy.load( QFileInfo( tree.rootPath() ) ); } );
+
+            SScanResult singlePass;
+            auto singlePassCold = dropFileSystemCaches();
+            auto singlePassMS = elapsedMS( [ & ]() { singlePass = scanTree( tree.rootPath(), CSyntheticTree::nameFilters(), 1 ); } );
+
+            report( "DirScan", numRows(), legacyCold ? "TwoPassCold" : "TwoPassWarm", legacyMS );
+            report( "DirScan", numRows(), singlePassCold ? "SinglePassCold" : "SinglePassWarm", singlePassMS );
+
+            EXPECT_EQ( legacyFiles, numRows() );
+            EXPECT_EQ( legacy.numFilesCounted(), legacyFiles );
+            EXPECT_EQ( singlePass.fFilesFound, legacyFiles );
+            EXPECT_EQ( static_cast< int >( singlePass.fEntries.size() ), legacyFiles + legacy.numDirs() );
+        }
+
+        INSTANTIATE_ROW_COUNT_BENCHMARK( CDirScanBenchmark );
+    }
+}
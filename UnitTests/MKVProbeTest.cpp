@@ -0,0 +1,165 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+#include "Preferences/Core/MKVProbe.h"
+#include "SABUtils/MediaInfo.h"
+
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTime>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            using NPreferences::NCore::CMKVProbe;
+
+            // the headers must give the value ffprobe does, numbers are compared as numbers and the length to the nearest 100ms
+            void compareTags( const QString &fileName, const CMKVProbe::TMediaTags &headerTags, const std::unordered_map< NSABUtils::EMediaTags, QString > &ffprobeTags )
+            {
+                for ( auto &&ii : headerTags )
+                {
+                    auto pos = ffprobeTags.find( ii.first );
+                    auto ffprobeValue = ( pos == ffprobeTags.end() ) ? QString() : ( *pos ).second;
+                    auto tagName = QString::number( static_cast< int >( ii.first ) );
+
+                    switch ( ii.first )
+                    {
+                        case NSABUtils::EMediaTags::eLength:
+                            {
+                                auto headerMS = QTime::fromString( ii.second, "hh:mm:ss.zzz" ).msecsSinceStartOfDay();
+                                auto ffprobeMS = QTime::fromString( ffprobeValue, "hh:mm:ss.zzz" ).msecsSinceStartOfDay();
+                                EXPECT_LE( std::abs( headerMS - ffprobeMS ), 100 ) << qPrintable( fileName ) << " length " << qPrintable( ii.second ) << " vs " << qPrintable( ffprobeValue );
+                            }
+                            break;
+                        case NSABUtils::EMediaTags::eAspectRatio:
+                            EXPECT_NEAR( ii.second.toDouble(), ffprobeValue.toDouble(), 0.01 ) << qPrintable( fileName ) << " aspect ratio";
+                            break;
+                        case NSABUtils::EMediaTags::eWidth:
+                        case NSABUtils::EMediaTags::eHeight:
+                        case NSABUtils::EMediaTags::eAudioChannelCount:
+                            EXPECT_EQ( ii.second.toInt(), ffprobeValue.toInt() ) << qPrintable( fileName ) << " tag " << qPrintable( tagName );
+                            break;
+                        default:
+                            EXPECT_EQ( ii.second, ffprobeValue ) << qPrintable( fileName ) << " tag " << qPrintable( tagName );
+                            break;
+                    }
+                }
+            }
+
+            // every tag the headers can give, as the columns would request them
+            std::list< NSABUtils::EMediaTags > suppliedTags( const CMKVProbe::TMediaTags &headerTags )
+            {
+                std::list< NSABUtils::EMediaTags > retVal;
+                for ( auto &&ii : headerTags )
+                    retVal.push_back( ii.first );
+                return retVal;
+            }
+
+            void compareFile( const QFileInfo &fi, qint64 &headerMS, qint64 &ffprobeMS )
+            {
+                QElapsedTimer timer;
+                timer.start();
+                auto headerTags = CMKVProbe::probe( fi );
+                headerMS += timer.elapsed();
+                ASSERT_TRUE( headerTags.has_value() ) << qPrintable( fi.absoluteFilePath() );
+
+                auto tags = suppliedTags( headerTags.value() );
+                EXPECT_TRUE( CMKVProbe::canSupply( tags ) );
+
+                timer.restart();
+                NSABUtils::CMediaInfo mediaInfo( fi );
+                auto ffprobeTags = mediaInfo.getMediaTags( tags );
+                ffprobeMS += timer.elapsed();
+                ASSERT_TRUE( mediaInfo.aOK() ) << qPrintable( fi.absoluteFilePath() );
+
+                compareTags( fi.absoluteFilePath(), headerTags.value(), ffprobeTags );
+            }
+        }
+
+        class CMKVProbeTest : public ::testing::Test
+        {
+        protected:
+            void SetUp() override
+            {
+                auto ffprobe = findTool( "ffprobe" );
+                if ( ffprobe.isEmpty() )
+                    GTEST_SKIP() << "ffprobe not found, set MEDIAMANAGER_FFPROBE or add it to the PATH";
+                NSABUtils::CMediaInfo::setFFProbeEXE( ffprobe );
+            }
+        };
+
+        TEST_F( CMKVProbeTest, SampleMatchesFFProbe )
+        {
+            QTemporaryDir dir;
+            ASSERT_TRUE( dir.isValid() );
+            auto fileName = dir.filePath( "Sample (2000).mkv" );
+            QString errorMsg;
+            if ( !createSampleMKV( fileName, 5, &errorMsg ) )
+                GTEST_SKIP() << "could not create the sample: " << qPrintable( errorMsg );
+
+            auto headerTags = CMKVProbe::probe( QFileInfo( fileName ) );
+            ASSERT_TRUE( headerTags.has_value() );
+            EXPECT_EQ( headerTags.value()[ NSABUtils::EMediaTags::eTitle ], "Sample Title" );
+            EXPECT_EQ( headerTags.value()[ NSABUtils::EMediaTags::eResolution ], "640x360" );
+            EXPECT_EQ( headerTags.value()[ NSABUtils::EMediaTags::eAllVideoCodecs ], "mpeg4" );
+            EXPECT_EQ( headerTags.value()[ NSABUtils::EMediaTags::eAllSubtitleCodecs ], "subrip" );
+            EXPECT_EQ( headerTags.value()[ NSABUtils::EMediaTags::eAllSubtitleLanguages ], "eng" );
+            EXPECT_EQ( headerTags.value()[ NSABUtils::EMediaTags::eAudioChannelCount ], "2" );
+
+            qint64 headerMS = 0;
+            qint64 ffprobeMS = 0;
+            compareFile( QFileInfo( fileName ), headerMS, ffprobeMS );
+        }
+
+        // MEDIAMANAGER_TEST_MEDIA_DIR points at a library of real files, every matroska file under it is compared
+        TEST_F( CMKVProbeTest, CorpusMatchesFFProbe )
+        {
+            auto corpusDir = qEnvironmentVariable( "MEDIAMANAGER_TEST_MEDIA_DIR" );
+            if ( corpusDir.isEmpty() )
+                GTEST_SKIP() << "set MEDIAMANAGER_TEST_MEDIA_DIR to compare a media library";
+
+            int numFiles = 0;
+            qint64 headerMS = 0;
+            qint64 ffprobeMS = 0;
+            QDirIterator ii( corpusDir, { "*.mkv", "*.mka", "*.webm" }, QDir::Files, QDirIterator::Subdirectories );
+            while ( ii.hasNext() )
+            {
+                ii.next();
+                compareFile( ii.fileInfo(), headerMS, ffprobeMS );
+                numFiles++;
+            }
+            ASSERT_GT( numFiles, 0 ) << "no matroska files under " << qPrintable( corpusDir );
+
+            report( "MKVProbe", numFiles, "Headers", headerMS );
+            report( "MKVProbe", numFiles, "FFProbe", ffprobeMS );
+        }
+    }
+}
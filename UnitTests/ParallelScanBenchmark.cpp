@@ -0,0 +1,100 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+
+#include <QThread>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            int poolThreads()
+            {
+                return std::max( 2, QThread::idealThreadCount() );
+            }
+        }
+
+        // the pool must not change what is delivered or the order it is delivered in, cached or not
+        TEST( CParallelScan, SameOrderAsOneThread )
+        {
+            CSyntheticTree tree( 10000 );
+            ASSERT_TRUE( tree.isValid() );
+
+            auto serial = scanTree( tree.rootPath(), CSyntheticTree::nameFilters(), 1 );
+            auto parallel = scanTree( tree.rootPath(), CSyntheticTree::nameFilters(), poolThreads() );
+            EXPECT_EQ( serial.fFilesFound, tree.numFiles() );
+            EXPECT_EQ( parallel.fFilesFound, serial.fFilesFound );
+            EXPECT_EQ( parallel.fEntries, serial.fEntries );
+        }
+
+        // the pool only pays off when the directory reads wait on the storage, a warm cache answers them without waiting
+        // so every scan starts from dropped caches, MEDIAMANAGER_BENCHMARK_TREE points at an existing library (network or RAID storage) to scan instead of the synthetic one
+        class CParallelScanBenchmark : public CRowCountBenchmark
+        {
+        };
+
+        TEST_P( CParallelScanBenchmark, PoolVsSingleThreadCold )
+        {
+            auto treePath = qEnvironmentVariable( "MEDIAMANAGER_BENCHMARK_TREE" );
+            std::unique_ptr< CSyntheticTree > tree;
+            if ( treePath.isEmpty() )
+            {
+                tree = std::make_unique< CSyntheticTree >( numRows() );
+                ASSERT_TRUE( tree->isValid() );
+                treePath = tree->rootPath();
+            }
+            else if ( numRows() != benchmarkRowCounts().front() )
+                GTEST_SKIP() << "MEDIAMANAGER_BENCHMARK_TREE is scanned once, at the first row count";
+
+            if ( !dropFileSystemCaches() )
+                GTEST_SKIP() << "the file system caches could not be dropped (needs root on linux), warm cache numbers would not show the pool";
+
+            auto numThreads = poolThreads();
+            SScanResult serial;
+            auto serialMS = elapsedMS( [ & ]() { serial = scanTree( treePath, CSyntheticTree::nameFilters(), 1 ); } );
+
+            ASSERT_TRUE( dropFileSystemCaches() );
+            SScanResult parallel;
+            auto parallelMS = elapsedMS( [ & ]() { parallel = scanTree( treePath, CSyntheticTree::nameFilters(), numThreads ); } );
+
+            auto numFiles = serial.fFilesFound;
+            report( "ParallelScan", numFiles, "OneThreadCold", serialMS );
+            report( "ParallelScan", numFiles, QString( "%1ThreadsCold" ).arg( numThreads ), parallelMS );
+            if ( parallelMS )
+                ::testing::Test::RecordProperty( "speedup_x100", static_cast< int >( ( 100 * serialMS ) / parallelMS ) );
+
+            if ( tree )
+                EXPECT_EQ( numFiles, numRows() );
+            EXPECT_EQ( parallel.fFilesFound, serial.fFilesFound );
+            EXPECT_EQ( parallel.fEntries, serial.fEntries );
+        }
+
+        INSTANTIATE_ROW_COUNT_BENCHMARK( CParallelScanBenchmark );
+    }
+}
@@ -0,0 +1,133 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+#include "Preferences/Core/PathMatcher.h"
+
+#include <QRegularExpression>
+
+#include <gtest/gtest.h>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            // extension, exact name and general wildcards, as the delete list mixes them
+            QStringList deletePatterns()
+            {
+                return { "*.nfo", "*.txt", "*.exe", "*.jpg", "*.png", "*.url", "RARBG.com.mp4", "RARBG_DO_NOT_MIRROR.exe", "*sample*.mkv", "*-sample.*", "WWW.YIFY-TORRENTS.COM.jpg", "Torrent Downloaded From*" };
+            }
+
+            QStringList fileNames( int count )
+            {
+                static const QStringList kSuffixes = { ".mkv", ".en.srt", ".nfo", ".txt", "-sample.mkv", ".mp4", ".sample.mkv", ".exe", ".idx" };
+                QStringList retVal;
+                retVal.reserve( count );
+                for ( int ii = 0; ii < count; ++ii )
+                    retVal << QString( "Title %1 (2000)%2" ).arg( ii ).arg( kSuffixes[ ii % kSuffixes.size() ] );
+                retVal << "RARBG.com.mp4"
+                       << "Torrent Downloaded From RARBG.txt"
+                       << "Torrent Downloaded From Here";
+                return retVal;
+            }
+
+            // isPathToDelete as it was, every wildcard compiled on every call
+            bool perCallMatch( const QStringList &patterns, const QString &fileName )
+            {
+                for ( auto &&ii : patterns )
+                {
+                    auto regExStr = QRegularExpression::wildcardToRegularExpression( ii );
+                    QRegularExpression::PatternOptions options = QRegularExpression::PatternOption::NoPatternOption;
+#ifdef Q_OS_WINDOWS
+                    options |= QRegularExpression::PatternOption::CaseInsensitiveOption;
+#endif
+                    auto regExp = QRegularExpression( regExStr, options );
+                    if ( regExp.match( fileName ).hasMatch() )
+                        return true;
+                }
+                return false;
+            }
+        }
+
+        TEST( CPathMatcher, WildcardsMatchAsPerCallRegEx )
+        {
+            auto patterns = deletePatterns();
+            NPreferences::NCore::CPathMatcher matcher( patterns, true );
+            for ( auto &&ii : fileNames( 1000 ) )
+                EXPECT_EQ( matcher.matches( ii ), perCallMatch( patterns, ii ) ) << qPrintable( ii );
+
+            EXPECT_TRUE( matcher.matches( "Title (2000).nfo" ) );
+            EXPECT_TRUE( matcher.matches( "Title (2000)-sample.mkv" ) );
+            EXPECT_TRUE( matcher.matches( "RARBG_DO_NOT_MIRROR.exe" ) );
+            EXPECT_FALSE( matcher.matches( "Title (2000).mkv" ) );
+            EXPECT_FALSE( matcher.matches( "Title (2000).nfo.mkv" ) );
+            EXPECT_TRUE( NPreferences::NCore::CPathMatcher( {}, true ).isEmpty() );
+        }
+
+        TEST( CPathMatcher, InvalidPatternIsDropped )
+        {
+            NPreferences::NCore::CPathMatcher matcher( { "#recycle", "(unclosed", ".*sample.*" } );
+            EXPECT_TRUE( matcher.matches( "#recycle" ) );
+            EXPECT_TRUE( matcher.matches( "the sample dir" ) );
+            EXPECT_FALSE( matcher.matches( "(unclosed" ) );
+        }
+
+        class CPathMatcherBenchmark : public CRowCountBenchmark
+        {
+        };
+
+        TEST_P( CPathMatcherBenchmark, PrecompiledVsPerCall )
+        {
+            auto numRows = this->numRows();
+            auto patterns = deletePatterns();
+            auto names = fileNames( numRows );
+
+            std::vector< bool > perCall;
+            perCall.reserve( names.size() );
+            auto perCallMS = elapsedMS(
+                [ & ]()
+                {
+                    for ( auto &&ii : names )
+                        perCall.push_back( perCallMatch( patterns, ii ) );
+                } );
+
+            std::vector< bool > precompiled;
+            precompiled.reserve( names.size() );
+            auto precompiledMS = elapsedMS(
+                [ & ]()
+                {
+                    NPreferences::NCore::CPathMatcher matcher( patterns, true );   // built once per preference change, included here anyway
+                    for ( auto &&ii : names )
+                        precompiled.push_back( matcher.matches( ii ) );
+                } );
+
+            report( "PathMatcher", numRows, "PerCallRegEx", perCallMS );
+            report( "PathMatcher", numRows, "CPathMatcher", precompiledMS );
+
+            EXPECT_EQ( precompiled, perCall );
+        }
+
+        INSTANTIATE_ROW_COUNT_BENCHMARK( CPathMatcherBenchmark );
+    }
+}
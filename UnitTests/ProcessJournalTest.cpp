@@ -0,0 +1,282 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Models/ProcessJournal.h"
+#include "Models/DirModel.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
+// the journal is a process wide singleton that owns a lock file, so every session is a child run of this executable
+// the child runs CProcessJournalChild.Run with MEDIAMANAGER_JOURNAL_CHILD naming what it does, a crash is a std::_Exit with no cleanup at all
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            const char *kChildModeVar = "MEDIAMANAGER_JOURNAL_CHILD";
+            const char *kWorkDirVar = "MEDIAMANAGER_JOURNAL_DIR";
+            const char *kExpectTornVar = "MEDIAMANAGER_JOURNAL_TORN";
+
+            QString workPath( const QString &fileName )
+            {
+                return QDir( qEnvironmentVariable( kWorkDirVar ) ).absoluteFilePath( fileName );
+            }
+
+            void touch( const QString &fileName )
+            {
+                QFile file( fileName );
+                file.open( QFile::WriteOnly | QFile::Truncate );
+                file.write( "partial" );
+            }
+
+            quint64 queueJob( const QString &name )
+            {
+                NModels::SProcessInfo processInfo;
+                processInfo.fCmd = "ffmpeg";
+                processInfo.fArgs = QStringList() << "-i" << workPath( name + ".mkv" ) << workPath( name + ".new.mkv" );
+                processInfo.fOldName = workPath( name + ".mkv" );
+                processInfo.fNewNames = QStringList() << workPath( name + ".new.mkv" );
+                processInfo.fMaximum = 100;
+                processInfo.fProgressLabel = name;
+                return NModels::CProcessJournal::instance()->queued( "Transcode", processInfo );
+            }
+
+            // queued, started with partial outputs, outputs complete and finished, then a last queued job the torn test cuts short
+            void crashMidQueue()
+            {
+                auto journal = NModels::CProcessJournal::instance();
+                ASSERT_TRUE( journal->isOwner() );
+
+                queueJob( "NotStarted" );
+
+                auto started = queueJob( "Started" );
+                journal->started( started );
+                touch( workPath( "Started.new.mkv" ) );
+                touch( workPath( "Started.new.mkv.partial" ) );
+
+                auto complete = queueJob( "Complete" );
+                journal->started( complete );
+                touch( workPath( "Complete.new.mkv" ) );
+                journal->outputsComplete( complete );
+
+                auto done = queueJob( "Done" );
+                journal->started( done );
+                journal->finished( done, true );
+
+                queueJob( "Last" );
+
+                std::cout << "crashing" << std::endl;
+                std::_Exit( 3 );
+            }
+
+            void resumeAfterCrash()
+            {
+                auto journal = NModels::CProcessJournal::instance();
+                ASSERT_TRUE( journal->isOwner() ) << "the lock of the crashed session must be stale";
+
+                auto jobs = journal->unfinishedFromLastSession();
+                std::map< QString, NModels::SJournalJob > byLabel;
+                for ( auto &&ii : jobs )
+                    byLabel[ ii.fProgressLabel ] = ii;
+
+                auto torn = !qEnvironmentVariableIsEmpty( kExpectTornVar );
+                ASSERT_EQ( byLabel.size(), torn ? 3U : 4U );
+                EXPECT_EQ( byLabel.count( "Done" ), 0U );
+                EXPECT_EQ( byLabel.count( "Last" ), torn ? 0U : 1U );
+
+                ASSERT_EQ( byLabel.count( "NotStarted" ), 1U );
+                EXPECT_FALSE( byLabel[ "NotStarted" ].fStarted );
+                EXPECT_EQ( byLabel[ "NotStarted" ].fPageName, "Transcode" );
+                EXPECT_EQ( byLabel[ "NotStarted" ].fCmd, "ffmpeg" );
+                EXPECT_EQ( byLabel[ "NotStarted" ].fOldName, workPath( "NotStarted.mkv" ) );
+                EXPECT_EQ( byLabel[ "NotStarted" ].fMaximum, 100 );
+
+                ASSERT_EQ( byLabel.count( "Started" ), 1U );
+                EXPECT_TRUE( byLabel[ "Started" ].fStarted );
+                EXPECT_FALSE( byLabel[ "Started" ].fOutputsComplete );
+
+                ASSERT_EQ( byLabel.count( "Complete" ), 1U );
+                EXPECT_TRUE( byLabel[ "Complete" ].fOutputsComplete );
+
+                journal->discard( jobs );
+
+                // a started job's partial outputs go, complete outputs stay for the resumed cleanup
+                EXPECT_FALSE( QFileInfo::exists( workPath( "Started.new.mkv" ) ) );
+                EXPECT_FALSE( QFileInfo::exists( workPath( "Started.new.mkv.partial" ) ) );
+                EXPECT_TRUE( QFileInfo::exists( workPath( "Complete.new.mkv" ) ) );
+
+                EXPECT_TRUE( journal->unfinishedFromLastSession().empty() );
+                EXPECT_LE( QFileInfo( NModels::CProcessJournal::journalFileName() ).size(), 8 ) << "the journal is truncated once nothing is unfinished";
+
+                // ids keep counting past the last session's
+                auto next = queueJob( "Next" );
+                EXPECT_GT( next, torn ? 4U : 5U );
+                journal->finished( next, true );
+            }
+
+            void holdLock()
+            {
+                auto journal = NModels::CProcessJournal::instance();
+                ASSERT_TRUE( journal->isOwner() );
+                auto id = queueJob( "Held" );
+                journal->started( id );
+                std::cout << "owner" << std::endl;
+
+                for ( int ii = 0; ( ii < 600 ) && !QFileInfo::exists( workPath( "release" ) ); ++ii )
+                    QThread::msleep( 50 );
+                journal->finished( id, true );
+            }
+
+            void secondInstance()
+            {
+                auto journal = NModels::CProcessJournal::instance();
+                EXPECT_FALSE( journal->isOwner() );
+                EXPECT_EQ( queueJob( "Second" ), 0U );
+                EXPECT_TRUE( journal->unfinishedFromLastSession().empty() );
+                journal->discard( journal->unfinishedFromLastSession() );
+            }
+
+            QProcessEnvironment childEnvironment( const QString &mode, const QString &workDir, bool expectTorn )
+            {
+                auto retVal = QProcessEnvironment::systemEnvironment();
+                retVal.insert( kChildModeVar, mode );
+                retVal.insert( kWorkDirVar, workDir );
+                if ( expectTorn )
+                    retVal.insert( kExpectTornVar, "1" );
+                return retVal;
+            }
+
+            void startChild( QProcess &process, const QString &mode, const QString &workDir, bool expectTorn = false )
+            {
+                process.setProcessEnvironment( childEnvironment( mode, workDir, expectTorn ) );
+                process.setProcessChannelMode( QProcess::MergedChannels );
+                process.start( QCoreApplication::applicationFilePath(), { "--gtest_filter=CProcessJournalChild.Run" } );
+            }
+
+            // the exit code, the output is echoed so a failing child's expectations show in the parent's log
+            int runChild( const QString &mode, const QString &workDir, bool expectTorn = false )
+            {
+                QProcess process;
+                startChild( process, mode, workDir, expectTorn );
+                if ( !process.waitForFinished( 60000 ) )
+                {
+                    process.kill();
+                    return -1;
+                }
+                std::cout << process.readAll().toStdString();
+                return ( process.exitStatus() == QProcess::NormalExit ) ? process.exitCode() : -1;
+            }
+        }
+
+        TEST( CProcessJournalChild, Run )
+        {
+            auto mode = qEnvironmentVariable( kChildModeVar );
+            if ( mode.isEmpty() )
+                GTEST_SKIP() << "only run as a child of CProcessJournalTest";
+
+            if ( mode == "crash" )
+                crashMidQueue();
+            else if ( mode == "resume" )
+                resumeAfterCrash();
+            else if ( mode == "hold" )
+                holdLock();
+            else if ( mode == "second" )
+                secondInstance();
+            else
+                FAIL() << "unknown child mode " << qPrintable( mode );
+        }
+
+        class CProcessJournalTest : public ::testing::Test
+        {
+        protected:
+            void SetUp() override
+            {
+                if ( !qEnvironmentVariableIsEmpty( kChildModeVar ) )
+                    GTEST_SKIP();
+                ASSERT_TRUE( fWorkDir.isValid() );
+                QFile::remove( NModels::CProcessJournal::journalFileName() );
+                QFile::remove( NModels::CProcessJournal::lockFileName() );
+            }
+
+            void TearDown() override
+            {
+                QFile::remove( NModels::CProcessJournal::journalFileName() );
+                QFile::remove( NModels::CProcessJournal::lockFileName() );
+            }
+
+            QTemporaryDir fWorkDir;
+        };
+
+        TEST_F( CProcessJournalTest, ResumeAfterCrash )
+        {
+            ASSERT_EQ( runChild( "crash", fWorkDir.path() ), 3 );
+            EXPECT_TRUE( QFileInfo::exists( NModels::CProcessJournal::lockFileName() ) ) << "a crash leaves its lock behind";
+            EXPECT_EQ( runChild( "resume", fWorkDir.path() ), 0 );
+        }
+
+        TEST_F( CProcessJournalTest, TornRecordIsIgnored )
+        {
+            ASSERT_EQ( runChild( "crash", fWorkDir.path() ), 3 );
+
+            // cut the last queued record short, as a crash in the middle of the write would
+            QFile journal( NModels::CProcessJournal::journalFileName() );
+            auto size = journal.size();
+            ASSERT_GT( size, 16 );
+            ASSERT_TRUE( journal.resize( size - 5 ) );
+
+            EXPECT_EQ( runChild( "resume", fWorkDir.path(), true ), 0 );
+        }
+
+        TEST_F( CProcessJournalTest, SecondInstanceDoesNotTouchTheJournal )
+        {
+            QProcess owner;
+            startChild( owner, "hold", fWorkDir.path() );
+            ASSERT_TRUE( owner.waitForStarted() );
+            QByteArray output;
+            while ( !( output += owner.readAll() ).contains( "owner" ) )
+                ASSERT_TRUE( owner.waitForReadyRead( 30000 ) ) << "the first instance never took the journal";
+
+            auto sizeBefore = QFileInfo( NModels::CProcessJournal::journalFileName() ).size();
+            EXPECT_EQ( runChild( "second", fWorkDir.path() ), 0 );
+            EXPECT_EQ( QFileInfo( NModels::CProcessJournal::journalFileName() ).size(), sizeBefore );
+
+            touch( QDir( fWorkDir.path() ).absoluteFilePath( "release" ) );
+            ASSERT_TRUE( owner.waitForFinished( 60000 ) );
+            EXPECT_EQ( owner.exitCode(), 0 );
+            EXPECT_FALSE( QFileInfo::exists( NModels::CProcessJournal::lockFileName() ) ) << "a clean exit releases the lock";
+        }
+    }
+}
@@ -0,0 +1,198 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+#include "Models/DirModel.h"
+#include "Models/DirNodeItem.h"
+#include "Preferences/Core/Preferences.h"
+#include "SABUtils/MediaInfo.h"
+
+#include <QFileIconProvider>
+#include <QStandardItemModel>
+
+#include <gtest/gtest.h>
+
+#include <unordered_set>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            using TStringSet = std::unordered_set< QString >;
+            using TRowItems = std::list< NModels::SDirNodeItem >;
+
+            // the cells of a transcode row, the file columns followed by the media tag columns
+            TRowItems rowItems( int row, const QIcon &icon, TStringSet *interned )
+            {
+                auto intern = [ interned ]( const QString &value )
+                {
+                    if ( !interned || value.isEmpty() )
+                        return value;
+                    return *interned->insert( value ).first;
+                };
+
+                TRowItems retVal;
+                retVal.emplace_back( QString( "Title %1 (2000).mkv" ).arg( row, 7, 10, QChar( '0' ) ), NModels::EColumns::eFSName );
+                retVal.back().fIcon = icon;
+                retVal.back().fCheckable = NModels::SCheckable();
+                retVal.emplace_back( QString( "%1 GB" ).arg( 1 + ( row % 9 ) ), NModels::EColumns::eFSSize );
+                retVal.back().fAlignment = Qt::AlignRight | Qt::AlignVCenter;
+                retVal.emplace_back( intern( QString( "mkv File" ) ), NModels::EColumns::eFSType );
+                retVal.emplace_back( QString( "1/%1/2020 10:00 AM" ).arg( 1 + ( row % 28 ) ), NModels::EColumns::eFSModDate );
+
+                static const std::list< std::pair< NSABUtils::EMediaTags, QString > > kTags = {
+                    { NSABUtils::EMediaTags::eTitle, QString() },
+                    { NSABUtils::EMediaTags::eLength, "01:45:00" },
+                    { NSABUtils::EMediaTags::eDate, "2000" },
+                    { NSABUtils::EMediaTags::eOverAllBitrateString, "8.5 Mbps" },
+                    { NSABUtils::EMediaTags::eResolution, "1920x1080" },
+                    { NSABUtils::EMediaTags::eAllVideoCodecs, "h264" },
+                    { NSABUtils::EMediaTags::eVideoBitrateString, "8 Mbps" },
+                    { NSABUtils::EMediaTags::eHDRInfo, "No" }
+                };
+                int column = NModels::EColumns::eFirstCustomColumn;
+                for ( auto &&ii : kTags )
+                {
+                    // each row gets its own copy of the text, as the media info of every file does
+                    // only the low cardinality columns are interned, as CDirModel::getMediaInfoItems does
+                    auto text = ii.second.isEmpty() ? QString( "Title %1" ).arg( row ) : QString( ii.second.data(), ii.second.length() );
+                    retVal.emplace_back( NModels::CDirModel::isRepeatedTag( ii.first ) ? intern( text ) : text, column++ );
+                    retVal.back().fEditable = std::make_pair( NModels::EType::eMediaTag, ii.first );
+                }
+                return retVal;
+            }
+
+            // the cell as it was created before only the non-default roles were stored
+            QStandardItem *legacyStandardItem( const NModels::SDirNodeItem &nodeItem )
+            {
+                QStandardItem *retVal = nullptr;
+                if ( !nodeItem.fEditable.has_value() )
+                {
+                    retVal = new QStandardItem( nodeItem.fText );
+                    retVal->setEditable( false );
+                }
+                else
+                {
+                    retVal = new NModels::CDirModelItem( nodeItem.fText, nodeItem.fEditable.value().first );
+                    bool editable = true;
+                    if ( nodeItem.fEditable.value().first == NModels::EType::eMediaTag )
+                    {
+                        retVal->setData( static_cast< int >( nodeItem.fEditable.value().second ), NModels::ECustomRoles::eMediaTagTypeRole );
+                        editable = !NPreferences::NCore::CPreferences::instance()->getMKVPropEditEXE().isEmpty();
+                    }
+                    retVal->setEditable( editable );
+                }
+
+                retVal->setIcon( nodeItem.fIcon );
+                if ( nodeItem.fAlignment.has_value() )
+                    retVal->setTextAlignment( nodeItem.fAlignment.value() );
+                for ( auto &&ii : nodeItem.fRoles )
+                    retVal->setData( ii.first, ii.second );
+                if ( nodeItem.fCheckable.has_value() )
+                {
+                    retVal->setCheckable( nodeItem.fCheckable.value().fIsCheckable );
+                    retVal->setData( nodeItem.fCheckable.value().fYesNoOnly, NModels::ECustomRoles::eYesNoCheckableOnly );
+                    retVal->setCheckState( nodeItem.fCheckable.value().fCheckState );
+                }
+                return retVal;
+            }
+
+            struct SBuildResult
+            {
+                qint64 fMSecs{ 0 };
+                qint64 fBytes{ 0 };
+            };
+
+            template< typename T >
+            SBuildResult buildModel( int numRows, bool intern, T createItem )
+            {
+                QFileIconProvider iconProvider;
+                auto icon = iconProvider.icon( QFileIconProvider::File );
+
+                SBuildResult retVal;
+                auto before = residentBytes();
+                TStringSet interned;
+                QStandardItemModel model;
+                retVal.fMSecs = elapsedMS(
+                    [ & ]()
+                    {
+                        auto root = model.invisibleRootItem();
+                        for ( int ii = 0; ii < numRows; ++ii )
+                        {
+                            QList< QStandardItem * > row;
+                            for ( auto &&jj : rowItems( ii, icon, intern ? &interned : nullptr ) )
+                                row << createItem( jj );
+                            root->appendRow( row );
+                        }
+                    } );
+                retVal.fBytes = std::max< qint64 >( 0, residentBytes() - before );
+                EXPECT_EQ( model.rowCount(), numRows );
+                return retVal;
+            }
+        }
+
+        class CRowBuildBenchmark : public CRowCountBenchmark
+        {
+        };
+
+        TEST_P( CRowBuildBenchmark, DefaultRolesAndInterning )
+        {
+            auto numRows = this->numRows();
+            auto mediaTagsEditable = !NPreferences::NCore::CPreferences::instance()->getMKVPropEditEXE().isEmpty();
+
+            // the current cells first, memory freed by the first model is reused by the second, so the legacy number is if anything understated
+            // the legacy cells were never interned
+            auto current = buildModel( numRows, true, [ mediaTagsEditable ]( const NModels::SDirNodeItem &item ) { return item.createStandardItem( mediaTagsEditable ); } );
+            auto legacy = buildModel( numRows, false, []( const NModels::SDirNodeItem &item ) { return legacyStandardItem( item ); } );
+
+            report( "RowBuild", numRows, "Legacy", legacy.fMSecs, legacy.fBytes );
+            report( "RowBuild", numRows, "Current", current.fMSecs, current.fBytes );
+        }
+
+        TEST( CRowBuild, SameDataAsLegacy )
+        {
+            QFileIconProvider iconProvider;
+            auto icon = iconProvider.icon( QFileIconProvider::File );
+            auto mediaTagsEditable = !NPreferences::NCore::CPreferences::instance()->getMKVPropEditEXE().isEmpty();
+
+            TStringSet interned;
+            for ( auto &&ii : rowItems( 0, icon, &interned ) )
+            {
+                std::unique_ptr< QStandardItem > current( ii.createStandardItem( mediaTagsEditable ) );
+                std::unique_ptr< QStandardItem > legacy( legacyStandardItem( ii ) );
+
+                EXPECT_EQ( current->text(), legacy->text() );
+                EXPECT_EQ( current->isEditable(), legacy->isEditable() );
+                EXPECT_EQ( current->isCheckable(), legacy->isCheckable() );
+                EXPECT_EQ( current->checkState(), legacy->checkState() );
+                EXPECT_EQ( current->textAlignment(), legacy->textAlignment() );
+                EXPECT_EQ( current->icon().isNull(), legacy->icon().isNull() );
+                EXPECT_EQ( current->data( NModels::ECustomRoles::eMediaTagTypeRole ), legacy->data( NModels::ECustomRoles::eMediaTagTypeRole ) );
+                EXPECT_EQ( current->data( NModels::ECustomRoles::eYesNoCheckableOnly ).toBool(), legacy->data( NModels::ECustomRoles::eYesNoCheckableOnly ).toBool() );
+            }
+        }
+
+        INSTANTIATE_ROW_COUNT_BENCHMARK( CRowBuildBenchmark );
+    }
+}
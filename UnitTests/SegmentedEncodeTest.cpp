@@ -0,0 +1,172 @@
+// The MIT License( MIT )
+//
+// Copyright( c ) 2020-2023 Scott Aron Bloom
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkUtils.h"
+#include "Core/LanguageInfo.h"
+#include "Preferences/Core/Preferences.h"
+#include "Preferences/Core/TranscodePlan.h"
+#include "SABUtils/MediaInfo.h"
+
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace NMediaManager
+{
+    namespace NUnitTests
+    {
+        namespace
+        {
+            const int kSampleSeconds = 15;
+            const int kNumSegments = 3;
+
+            bool runFFmpeg( const QString &ffmpeg, const QStringList &args, QString &errorMsg )
+            {
+                QProcess process;
+                process.setProcessChannelMode( QProcess::MergedChannels );
+                process.start( ffmpeg, args );
+                auto aOK = process.waitForFinished( -1 ) && ( process.exitStatus() == QProcess::NormalExit ) && ( process.exitCode() == 0 );
+                if ( !aOK )
+                    errorMsg = QString( "%1 %2\n%3" ).arg( ffmpeg ).arg( args.join( " " ) ).arg( QString::fromLocal8Bit( process.readAll() ) );
+                return aOK;
+            }
+
+            // the software encoders the segmented path is used for, the first one this ffmpeg has
+            QString softwareEncoder( const QString &ffmpeg )
+            {
+                QProcess process;
+                process.start( ffmpeg, { "-hide_banner", "-encoders" } );
+                process.waitForFinished( -1 );
+                auto encoders = QString::fromLocal8Bit( process.readAllStandardOutput() );
+                for ( auto &&ii : { "libx265", "libx264" } )
+                {
+                    if ( encoders.contains( QString( " %1 " ).arg( ii ) ) )
+                        return ii;
+                }
+                return {};
+            }
+        }
+
+        class CSegmentedEncodeTest : public ::testing::Test
+        {
+        protected:
+            void SetUp() override
+            {
+                fFFmpeg = findTool( "ffmpeg" );
+                auto ffprobe = findTool( "ffprobe" );
+                if ( fFFmpeg.isEmpty() || ffprobe.isEmpty() )
+                    GTEST_SKIP() << "ffmpeg and ffprobe are needed, set MEDIAMANAGER_FFMPEG and MEDIAMANAGER_FFPROBE or add them to the PATH";
+                NSABUtils::CMediaInfo::setFFProbeEXE( ffprobe );
+
+                fEncoder = softwareEncoder( fFFmpeg );
+                if ( fEncoder.isEmpty() )
+                    GTEST_SKIP() << "ffmpeg has neither libx265 nor libx264";
+
+                ASSERT_TRUE( fDir.isValid() );
+                fSrcName = fDir.filePath( "Sample (2000).mkv" );
+                QString errorMsg;
+                ASSERT_TRUE( createSampleMKV( fSrcName, kSampleSeconds, &errorMsg ) ) << qPrintable( errorMsg );
+
+                auto prefs = NPreferences::NCore::CPreferences::instance();
+                prefs->setTranscodeToVideoCodec( fEncoder );
+                prefs->setUseTargetBitrate( false );
+                prefs->setUseTune( false );
+                prefs->setUseProfile( false );
+                prefs->setUseSegmentedEncoding( true );
+                prefs->setNumEncodeSegments( kNumSegments );
+                prefs->setSegmentedEncodingMinMinutes( 0 );
+            }
+
+            QTemporaryDir fDir;
+            QString fFFmpeg;
+            QString fEncoder;
+            QString fSrcName;
+        };
+
+        // split, encode each segment and mux, as the transcode model queues it, then hold the result against a single run of the same plan
+        TEST_F( CSegmentedEncodeTest, JoinedSegmentsMatchSource )
+        {
+            auto prefs = NPreferences::NCore::CPreferences::instance();
+            auto srcInfo = std::make_shared< NSABUtils::CMediaInfo >( QFileInfo( fSrcName ) );
+            ASSERT_TRUE( srcInfo->aOK() );
+
+            auto plan = prefs->getTranscodePlan( srcInfo );
+            ASSERT_TRUE( plan );
+            ASSERT_TRUE( plan->useSegmentedEncoding( NPreferences::NCore::ETranscodeType::eOther ) ) << "a " << qPrintable( fEncoder ) << " transcode of an mpeg4 source must be segmented";
+
+            auto totalSeconds = plan->fSeconds;
+            auto segmentSeconds = std::max( 1, static_cast< int >( std::ceil( totalSeconds / kNumSegments ) ) );
+
+            QString errorMsg;
+            QDir segmentDir( fDir.filePath( "segments" ) );
+            ASSERT_TRUE( segmentDir.mkpath( "." ) );
+            ASSERT_TRUE( runFFmpeg( fFFmpeg, prefs->getSegmentSplitArgs( fSrcName, segmentDir.absoluteFilePath( "seg_%03d.mkv" ), segmentSeconds ), errorMsg ) ) << qPrintable( errorMsg );
+
+            auto segments = segmentDir.entryInfoList( QStringList() << "seg_*.mkv", QDir::Files, QDir::Name );
+            ASSERT_GT( segments.count(), 1 );
+
+            auto concatList = segmentDir.absoluteFilePath( "segments.ffconcat" );
+            {
+                QFile file( concatList );
+                ASSERT_TRUE( file.open( QFile::WriteOnly | QFile::Truncate | QFile::Text ) );
+                QTextStream ts( &file );
+                ts << "ffconcat version 1.0\n";
+                for ( int ii = 0; ii < segments.count(); ++ii )
+                {
+                    auto encodedName = QString( "enc_%1.mkv" ).arg( ii, 3, 10, QChar( '0' ) );
+                    ts << "file " << encodedName << "\n";
+                    ASSERT_TRUE( runFFmpeg( fFFmpeg, prefs->getSegmentEncodeArgs( *plan, NPreferences::NCore::ETranscodeType::eOther, segments[ ii ].absoluteFilePath(), segmentDir.absoluteFilePath( encodedName ) ), errorMsg ) ) << qPrintable( errorMsg );
+                }
+            }
+
+            auto segmentedName = fDir.filePath( "Segmented.mkv" );
+            ASSERT_TRUE( runFFmpeg( fFFmpeg, prefs->getSegmentedTranscodeArgs( *plan, NPreferences::NCore::ETranscodeType::eOther, fSrcName, segmentedName, {}, {}, concatList ), errorMsg ) ) << qPrintable( errorMsg );
+
+            auto singleName = fDir.filePath( "Single.mkv" );
+            ASSERT_TRUE( runFFmpeg( fFFmpeg, prefs->getTranscodeArgs( *plan, NPreferences::NCore::ETranscodeType::eOther, fSrcName, singleName, {}, {} ), errorMsg ) ) << qPrintable( errorMsg );
+
+            NSABUtils::CMediaInfo segmentedInfo( QFileInfo( segmentedName ) );
+            NSABUtils::CMediaInfo singleInfo( QFileInfo( singleName ) );
+            ASSERT_TRUE( segmentedInfo.aOK() );
+            ASSERT_TRUE( singleInfo.aOK() );
+
+            // the same tolerance the mux step's post process checks against
+            auto tolerance = std::max( 2.0, 0.005 * totalSeconds );
+            EXPECT_NEAR( static_cast< double >( segmentedInfo.getNumberOfSeconds() ), totalSeconds, tolerance );
+            EXPECT_NEAR( static_cast< double >( segmentedInfo.getNumberOfSeconds() ), static_cast< double >( singleInfo.getNumberOfSeconds() ), tolerance );
+
+            EXPECT_EQ( segmentedInfo.getResolution(), srcInfo->getResolution() );
+            EXPECT_EQ( segmentedInfo.getResolution(), singleInfo.getResolution() );
+            EXPECT_EQ( segmentedInfo.numAudioStreams(), singleInfo.numAudioStreams() );
+            EXPECT_GE( segmentedInfo.numAudioStreams(), srcInfo->numAudioStreams() );
+            EXPECT_EQ( segmentedInfo.numSubtitleStreams(), singleInfo.numSubtitleStreams() );
+            EXPECT_EQ( segmentedInfo.numSubtitleStreams(), srcInfo->numSubtitleStreams() );
+            EXPECT_EQ( segmentedInfo.getMediaTags( { NSABUtils::EMediaTags::eAllVideoCodecs } ), singleInfo.getMediaTags( { NSABUtils::EMediaTags::eAllVideoCodecs } ) );
+        }
+    }
+}